@@ -1,9 +1,112 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace Scheduler {
 
     typedef std::chrono::steady_clock Clock;
 
+    /// Source of the time the scheduler runs on. Tasks, schedulers and
+    /// executors read the time through Now() so that a simulation can
+    /// replace the steady clock with one it moves itself.
+    class TimeSource
+    {
+    public:
+        virtual ~TimeSource() { }
+
+        virtual Clock::time_point Now() const = 0;
+
+        /// Wall-clock time at the given point on this source. By default the
+        /// steady clock is tied to the wall clock once, the first time any
+        /// source is asked, so later adjustments of the wall clock do not
+        /// move scheduled times.
+        virtual std::chrono::system_clock::time_point WallTime(
+            const Clock::time_point& point) const;
+    };
+
+    /// Read the current time from the installed time source, or from the
+    /// steady clock when there is none.
+    Clock::time_point Now();
+
+    /// Map a point in time read through Now() to wall-clock time, through
+    /// the installed time source if there is one.
+    std::chrono::system_clock::time_point ToWallTime(const Clock::time_point& point);
+
+    /// Install a time source for the whole process, returning the one it
+    /// replaces. Passing nullptr goes back to the steady clock. The source
+    /// must outlive every scheduler and task which reads it, and should be
+    /// installed before they are created.
+    TimeSource* SetTimeSource(TimeSource* source);
+
+    /// Time source which only moves when it is told to. Its time since the
+    /// epoch is also taken as wall-clock time since the Unix epoch, so wall
+    /// times replay the same way on every run.
+    class SimulatedClock : public TimeSource
+    {
+    public:
+        explicit SimulatedClock(const Clock::time_point& start = Clock::time_point())
+            : m_now(start.time_since_epoch().count())
+        { }
+
+        Clock::time_point Now() const override
+        {
+            return Clock::time_point(Clock::duration(
+                m_now.load(std::memory_order_acquire)));
+        }
+
+        std::chrono::system_clock::time_point WallTime(
+            const Clock::time_point& point) const override;
+
+        /// Move the time forward by the given step.
+        void Advance(const Clock::duration& step);
+
+        /// Move the time forward to the given point. The time never goes
+        /// back, so an earlier point is ignored.
+        void AdvanceTo(const Clock::time_point& point);
+
+    private:
+        std::atomic<Clock::rep> m_now;
+    };
+
+    /// Time source which reads the steady clock on a ticker thread once per
+    /// precision interval, so that reading the time is a single atomic load.
+    /// Readings may trail the steady clock by up to the precision and never
+    /// go back. Deadlines and delays finer than the precision are rounded up
+    /// to the next tick.
+    class CoarseClock : public TimeSource
+    {
+        CoarseClock(const CoarseClock&) = delete;
+        CoarseClock& operator=(const CoarseClock&) = delete;
+
+    public:
+        explicit CoarseClock(
+            const Clock::duration& precision = std::chrono::milliseconds(1));
+
+        /// Stop the ticker. The clock must be uninstalled first.
+        ~CoarseClock();
+
+        const Clock::duration& GetPrecision() const { return m_precision; }
+
+        Clock::time_point Now() const override
+        {
+            return Clock::time_point(Clock::duration(
+                m_now.load(std::memory_order_acquire)));
+        }
+
+    private:
+        void Run();
+
+        Clock::duration m_precision;
+        std::atomic<Clock::rep> m_now;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        bool m_stop = false;
+        std::thread m_thread;
+    };
+
 }  // namespace Scheduler
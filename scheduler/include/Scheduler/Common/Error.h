@@ -11,7 +11,8 @@ namespace Scheduler {
       E_NOT_FOUND,
       E_CANCELLED,
       E_COMPLETED,
-      E_INVALID_ARGUMENT
+      E_INVALID_ARGUMENT,
+      E_FULL
     };
 
     const char* ErrorToStr(Error e);
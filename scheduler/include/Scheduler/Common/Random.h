@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Scheduler/Common/Clock.h>
+#include <cstdint>
 #include <random>
 
 namespace Scheduler {
@@ -10,12 +11,16 @@ namespace Scheduler {
     {
     public:
         Generator(T min, T max)
+            : Generator(min, max, Clock::now().time_since_epoch().count())
+        { }
+
+        Generator(T min, T max, uint64_t seed)
             : m_min(min),
               m_max(max)
         {
             m_dist = std::uniform_int_distribution<T>(min, max);
             m_engine = std::default_random_engine();
-            m_engine.seed(Clock::now().time_since_epoch().count());
+            m_engine.seed(static_cast<std::default_random_engine::result_type>(seed));
         }
 
         ~Generator() { }
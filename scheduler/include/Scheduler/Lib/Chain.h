@@ -10,6 +10,7 @@
 namespace Scheduler {
 namespace Lib {
 
+    class ShardedTaskScheduler;
     class StandardTaskScheduler;
 
     class Chain;
@@ -17,6 +18,8 @@ namespace Lib {
 
     class Chain : public Task
     {
+        friend class DecentralizedTaskScheduler;
+        friend class ShardedTaskScheduler;
         friend class StandardTaskScheduler;
         friend class Task;
 
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Histogram.h>
 #include <Scheduler/Lib/Task.h>
 #include <memory>
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
@@ -14,10 +16,49 @@ namespace Lib {
     class Executor;
     typedef std::shared_ptr<Executor> ExecutorPtr;
 
+    /// Order in which ready tasks of the same priority class are handed out.
+    enum class DispatchPolicy : uint8_t
+    {
+        /// First in, first out.
+        PRIORITY = 0,
+        /// Earliest Before() deadline first, with tasks that have no
+        /// deadline going last in FIFO order. Tasks which can no longer
+        /// finish by their deadline given their estimate are shed rather
+        /// than run.
+        DEADLINE = 1
+    };
+
     struct ExecutorParams
     {
         static const unsigned DEFAULT_CONCURRENCY;
         unsigned concurrency = DEFAULT_CONCURRENCY;
+
+        /// Aging period for the worker queues. Once per interval a worker
+        /// runs the longest waiting task of a lower priority class ahead of
+        /// the higher ones, provided it has waited at least an interval.
+        /// This keeps a steady stream of high priority tasks from starving
+        /// the lower classes entirely. Aging is disabled when zero.
+        Clock::duration agingInterval = std::chrono::milliseconds(50);
+
+        /// Order in which the workers run queued tasks within a priority
+        /// class. With DEADLINE a worker sheds a task instead of running it
+        /// once it can no longer meet its deadline.
+        DispatchPolicy dispatchPolicy = DispatchPolicy::PRIORITY;
+    };
+
+    /// Latency of the tasks run by an executor or by one of its workers.
+    struct ExecutorStats
+    {
+        /// From being handed to the executor to starting to run.
+        HistogramSnapshot queued;
+        /// From starting to run to finishing.
+        HistogramSnapshot running;
+
+        void Merge(const ExecutorStats& other)
+        {
+            queued.Merge(other.queued);
+            running.Merge(other.running);
+        }
     };
 
     class Executor : public std::enable_shared_from_this<Executor>
@@ -33,13 +74,30 @@ namespace Lib {
         /// Cancel a pending task. It may not be possible to cancel a task
         /// once processing has begun on some platform or implementations.
         /// Note: ThreadPool does not support cancelling once the task has
-        ///       been picked up by a thread an execution has begun.
+        ///       been picked up by a thread an execution has begun, and
+        ///       returns E_NOT_FOUND then. A running task is asked to stop
+        ///       through Task::IsCancellationRequested instead.
         virtual Error Cancel(const UUID& id) = 0;
 
-        /// Enqueue a task for execution. Depending on Implementation it
-        /// may simply be moved to an executing worker queue tobe executed
-        /// in short time.
-        virtual void Enqueue(std::shared_ptr<TaskRunner>& task) = 0;
+        /// Enqueue a task for execution, leaving the caller with its
+        /// reference to the runner.
+        void Enqueue(std::shared_ptr<TaskRunner>& task)
+        {
+            std::shared_ptr<TaskRunner> runner(task);
+            Enqueue(std::move(runner));
+        }
+
+        /// Enqueue a task for execution, taking over the caller's reference
+        /// to the runner. Depending on Implementation it may simply be
+        /// moved to an executing worker queue tobe executed in short time.
+        virtual void Enqueue(std::shared_ptr<TaskRunner>&& task) = 0;
+
+        /// Read the latency of the tasks run so far across every worker.
+        void GetStats(ExecutorStats& stats) const;
+
+        /// Read the latency of the tasks run so far, one entry per worker.
+        /// Executors which keep no stats leave the list empty.
+        virtual void GetWorkerStats(std::vector<ExecutorStats>& stats) const;
 
         /// Shutdown the executor. Unless the shutdown is coming as a means
         /// of crashing it is advisable to ALWAYS wait for the shutdown to
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Log-linear bucketing of durations shared by Histogram and its
+    /// snapshots. Each power of two is split into SUB_BUCKETS linear
+    /// buckets, so a recorded value is off by at most 1/SUB_BUCKETS of
+    /// itself, about 3%, whatever its size. Durations are bucketed in
+    /// clock ticks, which are nanoseconds for the steady clock on the usual
+    /// platforms, up to 2^MAX_BITS ticks. Longer durations land in the last
+    /// bucket.
+    struct HistogramBuckets
+    {
+        static const unsigned SUB_BITS = 5;
+        static const unsigned SUB_BUCKETS = 1U << SUB_BITS;
+        static const unsigned MAX_BITS = 44;
+        static const size_t COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+        /// Bucket a duration in ticks falls into.
+        static size_t Index(uint64_t ticks);
+
+        /// Largest duration in ticks which falls into the bucket.
+        static uint64_t Highest(size_t index);
+    };
+
+    /// Counts of a histogram read at one point in time. Snapshots of
+    /// several histograms, such as one per worker, can be merged into one.
+    class HistogramSnapshot
+    {
+    public:
+        /// Number of durations recorded.
+        uint64_t GetCount() const { return m_count; }
+
+        /// Longest duration recorded, zero when there are none.
+        Clock::duration GetMax() const { return Clock::duration(m_max); }
+
+        /// Mean of the durations recorded, zero when there are none.
+        Clock::duration GetMean() const;
+
+        /// Shortest duration recorded, zero when there are none.
+        Clock::duration GetMin() const
+        {
+            return Clock::duration(m_count ? m_min : 0);
+        }
+
+        /// Duration at or below which the given percentage of the recorded
+        /// durations fall, to the precision of the buckets. Zero when there
+        /// are none.
+        Clock::duration Percentile(double percentile) const;
+
+        /// Add the counts of another snapshot to this one.
+        void Merge(const HistogramSnapshot& other);
+
+    private:
+        friend class Histogram;
+
+        std::vector<uint64_t> m_counts;
+        uint64_t m_count = 0;
+        uint64_t m_sum = 0;
+        uint64_t m_min = UINT64_MAX;
+        uint64_t m_max = 0;
+    };
+
+    /// Lock-free histogram of durations in the style of HdrHistogram, with
+    /// a fixed set of log-linear buckets. Recording is a handful of relaxed
+    /// atomic operations and never allocates, so it can sit on the path of
+    /// every task. Reads run alongside recording and may see a duration
+    /// counted in its bucket before it is counted in the totals.
+    class Histogram
+    {
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+    public:
+        Histogram();
+
+        /// Add the counts recorded so far to the snapshot.
+        void Read(HistogramSnapshot& snapshot) const;
+
+        /// Record a duration. Negative durations are recorded as zero.
+        void Record(const Clock::duration& duration);
+
+    private:
+        std::array<std::atomic<uint64_t>, HistogramBuckets::COUNT> m_counts;
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<uint64_t> m_sum{0};
+        std::atomic<uint64_t> m_min{UINT64_MAX};
+        std::atomic<uint64_t> m_max{0};
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// When a recurring task runs again after each successful run. The
+    /// scheduler re-arms the same task in place, so every run shares one
+    /// identifier, one allocation and one entry with the task manager.
+    ///
+    /// Fixed-rate recurrences run on a grid anchored to the first run and do
+    /// not drift. A tick missed because a run overran, or because the
+    /// scheduler was late, is skipped and counted rather than run late, so a
+    /// slow task never runs back to back to catch up. Fixed-delay
+    /// recurrences wait the delay after each run finishes and drift by the
+    /// running time by design. Cron recurrences match wall-clock time in
+    /// UTC, as the time source maps it, and skip missed matches the same way
+    /// as fixed-rate ones.
+    class Recurrence
+    {
+    public:
+        enum class Kind : uint8_t
+        {
+            NONE = 0,
+            FIXED_RATE = 1,
+            FIXED_DELAY,
+            CRON
+        };
+
+        /// Create a recurrence which never runs again.
+        Recurrence() = default;
+
+        /// Run every period, keeping to the grid of the first run.
+        static Recurrence FixedRate(const Clock::duration& period);
+
+        /// Run again the given delay after each run finishes.
+        static Recurrence FixedDelay(const Clock::duration& delay);
+
+        /// Run at the times matched by a cron expression of five fields:
+        /// minute, hour, day of month, month and day of week, with Sunday as
+        /// 0 or 7. Fields take '*', values, ranges 'a-b', steps '/n' and
+        /// comma separated lists. When both day fields are restricted a day
+        /// matching either runs, as with cron. The @yearly, @monthly,
+        /// @weekly, @daily and @hourly shorthands are also accepted. A
+        /// malformed expression gives an invalid recurrence.
+        static Recurrence Cron(const std::string& expression);
+
+        Kind GetKind() const { return m_kind; }
+
+        /// Retrieve the period or delay between runs, zero for cron.
+        const Clock::duration& GetPeriod() const { return m_period; }
+
+        bool IsRecurring() const { return m_kind != Kind::NONE; }
+
+        bool IsValid() const { return m_valid; }
+
+        /// Time of the next run after a run due at the given time finished
+        /// at the given time. Ticks which passed in between are skipped and
+        /// added to missed. Returns time_point::max() when there is no next
+        /// run.
+        Clock::time_point Next(
+            const Clock::time_point& due,
+            const Clock::time_point& now,
+            unsigned& missed) const;
+
+        /// First wall-clock minute matched by the cron expression strictly
+        /// after the given time. Returns time_point::max() when nothing
+        /// matches within the next few years, as for the 30th of February.
+        std::chrono::system_clock::time_point NextMatch(
+            const std::chrono::system_clock::time_point& after) const;
+
+    private:
+        bool Parse(const std::string& expression);
+
+        Kind m_kind = Kind::NONE;
+        bool m_valid = true;
+        Clock::duration m_period = Clock::duration::zero();
+
+        // Matched values of each cron field as bit sets.
+        uint64_t m_minutes = 0;
+        uint32_t m_hours = 0;
+        uint32_t m_days = 0;
+        uint16_t m_months = 0;
+        uint8_t m_weekdays = 0;
+        bool m_anyDay = true;
+        bool m_anyWeekday = true;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
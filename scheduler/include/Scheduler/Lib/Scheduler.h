@@ -3,17 +3,30 @@
 #include <Scheduler/Common/Error.h>
 #include <Scheduler/Lib/Chain.h>
 #include <Scheduler/Lib/Executor.h>
+#include <Scheduler/Lib/Histogram.h>
 #include <Scheduler/Lib/Task.h>
 #include <Scheduler/Lib/TaskManager.h>
 #include <Scheduler/Lib/UUID.h>
 #include <memory>
-
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
 
+    class Admission;
     class ScheduleReporter;
 
+    enum class SchedulingMode : uint8_t
+    {
+        /// A scheduler thread takes in queued tasks, resolves their
+        /// dependencies and hands ready tasks to the executor.
+        CENTRALIZED = 0,
+        /// Producers resolve dependencies as they queue tasks and workers
+        /// hand on the dependents made ready by the tasks they complete. A
+        /// thread is only kept for timers.
+        DECENTRALIZED = 1
+    };
+
     struct SchedulerParams
     {
         /// Param block for the Task executor. It is only needed if a
@@ -35,12 +48,85 @@ namespace Lib {
         /// Pointer to the TaskManager object which will serve the
         /// scheduler with Metadata about Tasks.
         TaskManager* manager = nullptr;
+
+        /// Window within which the start times of premature tasks are
+        /// coalesced into a single scheduler wakeup. Start times are rounded
+        /// up to the window so a task never runs before its After() time.
+        Clock::duration timerSlack = std::chrono::milliseconds(1);
+
+        /// Maximum number of queued tasks the scheduler takes in on a
+        /// single pass before it goes on to process completions.
+        size_t intakeBatchSize = 1024;
+
+        /// Number of scheduler loops the tasks are partitioned across. Each
+        /// loop runs on its own thread and owns the tasks whose ID hashes to
+        /// it, with every loop sharing the same executor and manager. A
+        /// dependency on a task owned by another loop costs a message in
+        /// each direction, so this is only worth raising when dispatch on
+        /// a single loop is the bottleneck.
+        unsigned shards = 1;
+
+        /// Order in which the scheduler hands ready tasks of the same
+        /// priority class to the executor. With DEADLINE the scheduler also
+        /// sheds tasks which can no longer meet their deadline before they
+        /// reach the executor. An executor created from executorParams
+        /// follows the same policy.
+        DispatchPolicy dispatchPolicy = DispatchPolicy::PRIORITY;
+
+        /// Maximum number of tasks the scheduler holds at once, counting a
+        /// task from the time it is queued until the scheduler is done with
+        /// it. A chain or group takes room for itself and each of its
+        /// children. TryEnqueue and the timed Enqueue respect the capacity
+        /// while the plain Enqueue always queues the task. Zero leaves the
+        /// scheduler unbounded.
+        size_t capacity = 0;
+
+        /// Longest the scheduler waits before running a task again after it
+        /// asks to be retried. Each retry waits a random time between the
+        /// retry interval of the task and three times the previous wait, so
+        /// tasks which fail together come back spread out rather than all
+        /// at once. A task with a longer retry interval still waits for it.
+        Clock::duration maxRetryDelay = std::chrono::seconds(30);
+
+        /// Number of retries allowed per second across the scheduler, up to
+        /// a second's worth at once. A task asking to be retried once the
+        /// budget is spent fails instead, as does one which has used up its
+        /// own Task::SetRetryLimit. Zero leaves retries unbounded.
+        size_t retryBudget = 0;
+
+        /// How tasks get from being queued to the executor. DECENTRALIZED
+        /// takes the scheduler thread off the path of every task, which
+        /// suits graphs of many short tasks, at the cost of producers and
+        /// workers doing the bookkeeping themselves. The shards and
+        /// intakeBatchSize params only apply to CENTRALIZED, except that
+        /// intake is still reported in batches of intakeBatchSize.
+        SchedulingMode mode = SchedulingMode::CENTRALIZED;
+    };
+
+    /// Latency of the tasks which have gone through a scheduler. Each
+    /// histogram covers one stage of TaskTimes.
+    struct SchedulerStats
+    {
+        /// From being queued to being taken in by the scheduler.
+        HistogramSnapshot intake;
+        /// From being taken in, or from the start time of the run when that
+        /// is later, to being handed to the executor. This is time spent
+        /// waiting on dependencies and on the scheduler itself.
+        HistogramSnapshot waiting;
+        /// Queueing and running time on the executor.
+        ExecutorStats executor;
     };
 
     class ScheduleReporter :
         public std::enable_shared_from_this<ScheduleReporter>
     {
     public:
+        virtual ~ScheduleReporter() { }
+
+        /// Called by the scheduler after taking in a batch of queued tasks
+        /// with the number of tasks in the batch and the time spent on it.
+        virtual void ReportIntake(size_t count, const Clock::duration& elapsed);
+
         virtual void Shutdown(bool wait = true);
     };
 
@@ -57,6 +143,25 @@ namespace Lib {
 
         virtual ~TaskScheduler() { }
 
+        /// Cancel a task the scheduler has been given. A task which has not
+        /// run yet never will, and one still queued on the executor is
+        /// dropped there. A running task is asked to stop through
+        /// Task::IsCancellationRequested and is treated as cancelled right
+        /// away. Everything depending on the task fails. Returns E_NOT_FOUND
+        /// for a task the scheduler does not know and E_COMPLETED for one
+        /// which has already completed.
+        virtual Error Cancel(const UUID& id) = 0;
+
+        /// Cancel a task, or a chain or group along with all of its
+        /// children, so a whole workflow can be dropped at once. Returns the
+        /// result of cancelling the task itself.
+        template<typename T, typename
+            std::enable_if<std::is_base_of<Task, T>::value, T>::type* = nullptr>
+        Error Cancel(std::shared_ptr<T>& task)
+        {
+            return Cancel(static_cast<Task*>(task.get()));
+        }
+
         template<typename T, typename
             std::enable_if<
                 std::is_base_of<Task, T>::value
@@ -75,6 +180,57 @@ namespace Lib {
             Enqueue(chain.get());
         }
 
+        /// Queue a task, waiting up to the timeout for the scheduler to have
+        /// room for it. Returns E_FULL if there is still no room after the
+        /// timeout, E_INVALID_ARGUMENT for an invalid task and E_CANCELLED
+        /// once the scheduler is shutdown.
+        template<typename T, typename
+            std::enable_if<
+                std::is_base_of<Task, T>::value
+                && !std::is_base_of<Chain, T>::value, T>::type* = nullptr>
+        Error Enqueue(std::shared_ptr<T>& task, const Clock::duration& timeout)
+        {
+            return Enqueue(static_cast<Task*>(task.get()), timeout);
+        }
+
+        /// Queue a chain, waiting up to the timeout for the scheduler to
+        /// have room for the chain and all of its children.
+        template<typename T, typename
+            std::enable_if<
+                std::is_base_of<Chain, T>::value
+                && std::is_convertible<T*, Task*>::value, T>::type* = nullptr>
+        Error Enqueue(std::shared_ptr<T>& chain, const Clock::duration& timeout)
+        {
+            return Enqueue(static_cast<Chain*>(chain.get()), timeout);
+        }
+
+        /// Queue a batch of tasks in one go. Each task is validated once and
+        /// the whole batch is handed to the manager and to the scheduler
+        /// together, waking the scheduler at most once. The children of a
+        /// chain in the batch are queued along with it. Invalid tasks are
+        /// skipped. Like the plain Enqueue the batch is always queued,
+        /// counting against the capacity without waiting for room.
+        void Enqueue(const std::vector<TaskPtr>& tasks);
+
+        /// Queue a task only if the scheduler has room for it right now.
+        template<typename T>
+        Error TryEnqueue(std::shared_ptr<T>& task)
+        {
+            return Enqueue(task, Clock::duration::zero());
+        }
+
+        /// Queue as many of the tasks as there is room for, in order,
+        /// stopping at the first one which does not fit. Room for the run
+        /// which fits is taken at once and the run is queued as a single
+        /// batch. The number queued is returned through admitted. Returns
+        /// E_SUCCESS once every task is queued and otherwise the error for
+        /// the first one which was not.
+        Error TryEnqueue(const std::vector<TaskPtr>& tasks, size_t& admitted);
+
+        /// Read the latency of the tasks which have gone through the
+        /// scheduler so far, along with that of its executor.
+        virtual void GetStats(SchedulerStats& stats) const = 0;
+
         virtual bool IsShutdown() const = 0;
 
         virtual void Notify() = 0;
@@ -86,10 +242,39 @@ namespace Lib {
         virtual void Start() = 0;
 
     protected:
+        /// Cancel the task and, for chains, every child down the tree.
+        Error Cancel(Task* task);
+
         virtual void Enqueue(Task* task) = 0;
 
         virtual void Enqueue(Chain* chain) = 0;
 
+        virtual Error Enqueue(Task* task, const Clock::duration& timeout) = 0;
+
+        virtual Error Enqueue(Chain* chain, const Clock::duration& timeout) = 0;
+
+        /// Queue a batch which has already been validated and admitted. The
+        /// children of each chain come ahead of the chain.
+        virtual void EnqueueBatch(std::vector<TaskPtr>&& batch) = 0;
+
+        /// Capacity the scheduler admits tasks against.
+        virtual Admission& GetAdmission() = 0;
+
+    private:
+        /// Validate a task for a batch and append it, after its children
+        /// if it is a chain. Returns false if the task is invalid.
+        static bool AppendToBatch(const TaskPtr& task, std::vector<TaskPtr>& batch);
+
+        /// Report a task as having succeeded and claim a dependent it made
+        /// ready for the reporting worker to run straight away, saving a
+        /// round trip through the scheduler. Returns nullptr when there is
+        /// no such dependent.
+        virtual TaskPtr Continue(TaskPtr& task)
+        {
+            Notify(task, TaskState::SUCCESS);
+            return nullptr;
+        }
+
         virtual void Notify(TaskPtr& task, TaskState state) = 0;
 
         virtual bool RunOnce() = 0;
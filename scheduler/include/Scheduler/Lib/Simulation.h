@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Scheduler.h>
+#include <memory>
+
+namespace Scheduler {
+namespace Lib {
+
+    class DeterministicExecutor;
+    class StandardTaskScheduler;
+
+    class Simulation;
+    typedef std::shared_ptr<Simulation> SimulationPtr;
+
+    /// Runs a scheduler on simulated time, entirely on the calling thread.
+    /// The simulation installs a SimulatedClock as the time source and runs
+    /// ready tasks in a fixed order when it is stepped, so a run can be
+    /// repeated exactly. Time only moves when the simulation moves it,
+    /// jumping straight to the next timer, and task bodies take no
+    /// simulated time. A day of timed tasks replays as fast as the
+    /// scheduler can get through them. Only one simulation may exist at a
+    /// time.
+    class Simulation
+    {
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+
+    public:
+        /// Create a simulation whose clock starts at the given time. The
+        /// scheduler is always a single centralized loop stepped by the
+        /// simulation, so the executor, mode and shards params are ignored.
+        /// Returns E_FULL when a time source is already installed.
+        static Error Create(
+            const SchedulerParams& params,
+            SimulationPtr& simulation,
+            const Clock::time_point& start = Clock::time_point());
+
+        /// Shut the scheduler down and go back to the steady clock.
+        ~Simulation();
+
+        /// Real time spent running task bodies.
+        Clock::duration GetExecutionTime() const { return m_executionTime; }
+
+        /// The scheduler to queue and cancel tasks with. It is driven by the
+        /// simulation and must not be started.
+        const SchedulerPtr& GetScheduler() const { return m_scheduler; }
+
+        /// Real time spent in scheduler passes, apart from running tasks.
+        /// This is the overhead of the scheduler itself.
+        Clock::duration GetSchedulerTime() const { return m_schedulerTime; }
+
+        /// Current simulated time.
+        Clock::time_point Now() const { return m_clock.Now(); }
+
+        /// Run for the given stretch of simulated time.
+        size_t RunFor(const Clock::duration& duration)
+        {
+            return RunUntil(Now() + duration);
+        }
+
+        /// Run everything which is ready at the current time, and whatever
+        /// that makes ready, without moving time. Returns the number of
+        /// tasks handed to the executor.
+        size_t RunUntilIdle();
+
+        /// Run until the given time, moving time from one timer to the next
+        /// and running whatever is ready at each. Time is left at the given
+        /// point. Returns the number of tasks handed to the executor.
+        size_t RunUntil(const Clock::time_point& point);
+
+    private:
+        explicit Simulation(const Clock::time_point& start);
+
+        SimulatedClock m_clock;
+        // Set once the clock is the installed time source.
+        bool m_installed = false;
+        std::shared_ptr<DeterministicExecutor> m_executor;
+        std::shared_ptr<StandardTaskScheduler> m_loop;
+        SchedulerPtr m_scheduler;
+
+        Clock::duration m_executionTime = Clock::duration::zero();
+        Clock::duration m_schedulerTime = Clock::duration::zero();
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <Scheduler/Common/Clock.h>
+#include <Scheduler/Lib/Recurrence.h>
 #include <Scheduler/Lib/Result.h>
+#include <Scheduler/Lib/TaskPool.h>
 #include <Scheduler/Lib/UUID.h>
-#include <condition_variable>
+#include <algorithm>
+#include <atomic>
 #include <iosfwd>
 #include <memory>
-#include <mutex>
 #include <type_traits>
 #include <vector>
 
@@ -44,12 +46,51 @@ namespace Lib {
 
     std::ostream& operator<<(std::ostream& o, TaskResult result);
 
+    /// Dispatch class of a task. Once ready to run, tasks of a higher class
+    /// are handed to the executor and picked up by its workers ahead of
+    /// those of a lower class.
+    enum class TaskPriority : uint8_t
+    {
+        LOW = 0,
+        NORMAL = 1,
+        HIGH = 2,
+        CRITICAL = 3
+    };
+
+    /// Number of TaskPriority classes.
+    const size_t TASK_PRIORITY_COUNT = 4;
+
+    const char* TaskPriorityToStr(TaskPriority priority);
+
+    std::ostream& operator<<(std::ostream& o, TaskPriority priority);
+
+    /// Times at which a task reached each stage on its way through the
+    /// scheduler, read from the time source. A stage which has not been
+    /// reached is time_point::min(). Retried and recurring tasks are stamped
+    /// again from dispatch on for every run.
+    struct TaskTimes
+    {
+        /// Queued with the scheduler.
+        Clock::time_point enqueued = Clock::time_point::min();
+        /// Taken in by the scheduler.
+        Clock::time_point pending = Clock::time_point::min();
+        /// Handed to the executor, or claimed by the worker which completed
+        /// its last dependency.
+        Clock::time_point dispatched = Clock::time_point::min();
+        /// Started running on a worker.
+        Clock::time_point started = Clock::time_point::min();
+        /// Finished running.
+        Clock::time_point finished = Clock::time_point::min();
+    };
+
     class Task;
     typedef std::shared_ptr<Task> TaskPtr;
 
     class Task : public std::enable_shared_from_this<Task>
     {
+        friend class Backoff;
         friend class TaskRunner;
+        friend class DecentralizedTaskScheduler;
         friend class StandardTaskScheduler;
 
         Task(const Task&) = delete;
@@ -68,10 +109,10 @@ namespace Lib {
         template<typename T, typename... Args>
         static TaskTypePtr<T> After(const Clock::time_point& point, Args&& ...args)
         {
-            return std::shared_ptr<T>(new T(
+            return Make<T>(
                 Clock::time_point::max(),
                 point,
-                std::forward<Args>(args)...));
+                std::forward<Args>(args)...);
         }
 
         /// Create a task that executes the given callable object after a
@@ -85,12 +126,11 @@ namespace Lib {
             const Clock::time_point& point,
             Args&& ...args)
         {
-            return std::shared_ptr<Task::Impl<Task, Callable>>(
-                new Task::Impl<Task, Callable>(
-                    std::move(cb),
-                    Clock::time_point::max(),
-                    point,
-                    std::forward<Args>(args)...));
+            return Make<Task::Impl<Task, Callable>>(
+                std::move(cb),
+                Clock::time_point::max(),
+                point,
+                std::forward<Args>(args)...);
         }
 
         /// Create a Task that should not execute before a given time.
@@ -99,10 +139,10 @@ namespace Lib {
         template<typename T, typename... Args>
         static TaskTypePtr<T> Before(const Clock::time_point& point, Args&& ...args)
         {
-            return std::shared_ptr<T>(new T(
+            return Make<T>(
                 point,
                 Clock::time_point::max(),
-                std::forward<Args>(args)...));
+                std::forward<Args>(args)...);
         }
 
         /// Create a Task with should execute a given callable object before
@@ -116,12 +156,11 @@ namespace Lib {
             const Clock::time_point& point,
             Args&& ...args)
         {
-            return std::shared_ptr<Task::Impl<Task, Callable>>(
-                new Task::Impl<Task, Callable>(
-                    std::move(cb),
-                    point,
-                    Clock::time_point::max(),
-                    std::forward<Args>(args)...));
+            return Make<Task::Impl<Task, Callable>>(
+                std::move(cb),
+                point,
+                Clock::time_point::max(),
+                std::forward<Args>(args)...);
         }
 
         /// Create a task that should execute between two given time
@@ -133,7 +172,7 @@ namespace Lib {
             const Clock::time_point& before,
             Args&& ...args)
         {
-            return std::shared_ptr<T>(new T(before, after, std::forward<Args>(args)...));
+            return Make<T>(before, after, std::forward<Args>(args)...);
         }
 
         /// Create a Task that should execute a given callable object
@@ -148,19 +187,18 @@ namespace Lib {
             const Clock::time_point& before,
             Args&& ...args)
         {
-            return std::shared_ptr<Task::Impl<Task, Callable>>(
-                new Task::Impl<Task, Callable>(
-                    std::move(cb),
-                    before,
-                    after,
-                    std::forward<Args>(args)...));
+            return Make<Task::Impl<Task, Callable>>(
+                std::move(cb),
+                before,
+                after,
+                std::forward<Args>(args)...);
         }
 
         /// Create a simple task that has no time boundaries for execution.
         template<typename T, typename... Args>
         static TaskTypePtr<T> Create(Args&& ...args)
         {
-            return std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+            return Make<T>(std::forward<Args>(args)...);
         }
 
         /// Create a simple Task with a callable object as the body. This
@@ -172,10 +210,9 @@ namespace Lib {
             typename = decltype(std::declval<CallbackFn&>())>
         static TaskTypePtr<Task> Create(CallbackFn&& cb, Args&& ...args)
         {
-            return std::shared_ptr<Task::Impl<Task, CallbackFn>>(
-                new Task::Impl<Task, CallbackFn>(
-                    std::move(cb),
-                    std::forward<Args>(args)...));
+            return Make<Task::Impl<Task, CallbackFn>>(
+                std::move(cb),
+                std::forward<Args>(args)...);
         }
 
         /// The destructor.
@@ -221,11 +258,44 @@ namespace Lib {
             return reinterpret_cast<T*>(Depends(chain.get()));
         }
 
+        /// Retrieve the expected running time of the task.
+        Clock::duration GetEstimate() const { return m_estimate; }
+
+        /// Retrieve the priority class the task is dispatched with.
+        TaskPriority GetPriority() const { return m_priority; }
+
+        /// Retrieve the number of ticks of a recurring task which were
+        /// skipped because an earlier run was still going or late.
+        unsigned GetMissedCount() const { return m_missed; }
+
+        /// Retrieve when the task runs again after each successful run.
+        const Recurrence& GetRecurrence() const { return m_recurrence; }
+
+        /// Retrieve the number of times the task has been retried. For a
+        /// recurring task this counts the retries of the current run.
+        unsigned GetRetryCount() const { return m_retries; }
+
+        /// Retrieve the most times the task may be retried, zero when only
+        /// the scheduler's retry budget limits it.
+        unsigned GetRetryLimit() const { return m_retryLimit; }
+
+        /// Retrieve the number of runs of a recurring task which have
+        /// finished successfully.
+        unsigned GetRunCount() const { return m_runs; }
+
         /// Retrieve teh state for the task.
-        TaskState GetState() const { return m_state; }
+        TaskState GetState() const
+        {
+            return m_state.load(std::memory_order_acquire);
+        }
+
+        /// Retrieve the times the task reached each stage. The stages are
+        /// stamped by whichever thread holds the task at the time, so they
+        /// should only be read once the task has completed.
+        const TaskTimes& GetTimes() const { return m_times; }
 
         /// Predicate check if the task has dependencies set.
-        bool HasDependencies() const { return !m_dependencies.empty(); }
+        bool HasDependencies() const;
 
         /// Retrieve the ID for the task.
         const UUID& Id() const { return m_id; }
@@ -240,6 +310,16 @@ namespace Lib {
         /// task can no longer be modified.
         bool IsActive() const;
 
+        /// Check if the task has been cancelled. This is the cancellation
+        /// token for a running task: long running bodies should poll it,
+        /// for instance through the Task* passed to a callable, and return
+        /// early once it is set. Whatever a cancelled task returns is
+        /// ignored.
+        bool IsCancellationRequested() const
+        {
+            return m_cancelled.load(std::memory_order_acquire);
+        }
+
         /// Predicate check if the task has completed. This should not be
         /// used to determine success or failure, just that the task is now
         /// complete.
@@ -247,18 +327,42 @@ namespace Lib {
 
         /// Check if the task has expired based on the time range
         /// given during construction.
-        bool IsExpired() const;
+        bool IsExpired() const { return IsExpired(Now()); }
+
+        /// Check if the task has expired as of the given time, for callers
+        /// checking many tasks against one reading of the clock.
+        bool IsExpired(const Clock::time_point& now) const
+        {
+            return m_before != Clock::time_point::max() && now > m_before;
+        }
+
+        /// Check if the task could still finish before its deadline were it
+        /// started at the given time, based on its estimated running time.
+        /// Tasks without a deadline are always feasible.
+        bool IsFeasible(const Clock::time_point& start) const;
 
         /// Check if the task is premature and not yet ready to run based
         /// on the given time range during construction.
-        bool IsPremature() const;
+        bool IsPremature() const { return IsPremature(Now()); }
+
+        /// Check if the task is premature as of the given time, for callers
+        /// checking many tasks against one reading of the clock.
+        bool IsPremature(const Clock::time_point& now) const
+        {
+            return m_after != Clock::time_point::max() && now < m_after;
+        }
+
+        /// Check if the task is re-armed after each successful run.
+        bool IsRecurring() const { return m_recurrence.IsRecurring(); }
 
         virtual bool IsRetryable() const { return false; }
 
         /// Predicate check if the task is valid. This flag could get set
         /// during construction or anytime a dependency is added if that
-        /// dependency would cause the task to never complete.
-        bool IsValid() const;
+        /// dependency would cause the task to never complete. It covers
+        /// everything the task depends on and is kept up to date as the
+        /// graph is wired, so checking it is a single load.
+        bool IsValid() const { return m_allValid.load(std::memory_order_acquire); }
 
         /// Check if the given task is a required dependency for this
         // task to run.
@@ -272,6 +376,34 @@ namespace Lib {
         // task to run.
         bool Requires(const UUID& id) const;
 
+        /// Set the expected running time of the task. Under the DEADLINE
+        /// dispatch policy a task is shed once it is too late to start it
+        /// and still finish within its deadline. The estimate can only be
+        /// changed before the task is queued with a scheduler, after which
+        /// the call is ignored.
+        Task* SetEstimate(const Clock::duration& estimate);
+
+        /// Set the priority class the task is dispatched with. The priority
+        /// can only be changed before the task is queued with a scheduler,
+        /// after which the call is ignored.
+        Task* SetPriority(TaskPriority priority);
+
+        /// Run the task again after each successful run, following the
+        /// given recurrence. The first run waits for After as usual. The
+        /// recurrence ends when a run fails, when the task is cancelled or
+        /// when the next run would fall after Before, in which case the
+        /// task completes successfully. Dependents wait for the recurrence
+        /// to end. An invalid recurrence makes the task invalid. It can
+        /// only be changed before the task is queued with a scheduler,
+        /// after which the call is ignored.
+        Task* SetRecurrence(const Recurrence& recurrence);
+
+        /// Set the most times the task may be retried before it fails
+        /// instead. Zero leaves it to the scheduler's retry budget. The
+        /// limit can only be changed before the task is queued with a
+        /// scheduler, after which the call is ignored.
+        Task* SetRetryLimit(unsigned limit);
+
         /// Retrieve the Task identifier as a string or with a descriptive
         /// identifier.
         virtual std::string ToString(bool asShort = false) const;
@@ -284,33 +416,113 @@ namespace Lib {
         Task();
         Task(const Clock::time_point& after, const Clock::time_point& before);
 
-        bool Requires(const UUID& start, const UUID& parent, const UUID& id) const;
-
         virtual void Fail();
 
         virtual TaskResult Run(ResultPtr&) = 0;
 
+        /// Mark the task invalid, along with everything depending on it.
+        /// Only the lock of the graph the task is in is taken, so wiring in
+        /// other graphs carries on undisturbed.
         void SetValid(bool status);
 
     private:
+        struct Graph;
+        class GraphLock;
+        struct Links;
+
         /// Return a vector of the tasks which are depended on by this task
         /// for completion.
-        const std::vector<TaskPtr>& GetDependencies() const
-        {
-            return m_dependencies;
-        }
+        const std::vector<TaskPtr>& GetDependencies() const;
 
         virtual Clock::duration GetRetryInterval() const
         {
             return std::chrono::seconds(0);
         }
 
+        /// Retrieve the links of the task into its graph, creating them
+        /// along with a graph of its own on first use.
+        Links& Attach();
+
+        /// Retrieve the links of a task which has been attached.
+        Links& GetLinks() const;
+
+        /// Raise the height of the task to at least the given value, along
+        /// with the tasks depending on it. Called with the graph lock held.
+        void Raise(unsigned height);
+
+        /// Check if the target can be reached through the dependencies of
+        /// the task. Each task is visited at most once per search, and
+        /// untangled tasks no higher than the target are not searched at
+        /// all. Called with the lock of the graph both are in held.
+        bool Reaches(const Task* target, Graph& graph) const;
+
+        /// Mark the task and everything depending on it as invalid. Called
+        /// with the graph lock held.
+        void Invalidate();
+
+        /// Mark the task and everything depending on it as tangled up in a
+        /// circular dependency. Called with the graph lock held.
+        void Tangle();
+
+        /// Time from which the current run could have been dispatched: when
+        /// the scheduler took the task in, or its start time when later.
+        Clock::time_point ReadySince() const
+        {
+            if (m_after == Clock::time_point::max()) return m_times.pending;
+            return std::max(m_times.pending, m_after);
+        }
+
+        /// Count a successful run of a recurring task and move After to its
+        /// next run. Returns false when there is no next run and the task
+        /// should complete instead.
+        bool Recur(const Clock::time_point& now);
+
         void SetAfterTime(const Clock::time_point& point);
 
         void SetState(TaskState state);
-        void SetStateLocked(
-            TaskState state,
-            std::unique_lock<std::mutex>& lock);
+
+        /// Move the task to the given state with a compare and swap,
+        /// returning false when nothing changed. Complete tasks keep their
+        /// state and no task goes back to NEW.
+        bool Transition(TaskState state);
+
+        /// Allocator placing a task and its reference counts in one block
+        /// from the TaskPool. It constructs through Task, so task classes
+        /// can keep their constructors protected and befriend Task alone.
+        template<typename T>
+        struct Allocator : PoolAllocator<T>
+        {
+            template<typename U>
+            struct rebind { typedef Allocator<U> other; };
+
+            Allocator() = default;
+
+            template<typename U>
+            Allocator(const Allocator<U>&) { }
+
+            template<typename U, typename... Args>
+            void construct(U* p, Args&& ...args)
+            {
+                Task::Construct(p, std::forward<Args>(args)...);
+            }
+
+            template<typename U>
+            void destroy(U* p) { p->~U(); }
+        };
+
+        template<typename U, typename... Args>
+        static void Construct(U* p, Args&& ...args)
+        {
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template<typename T, typename... Args>
+        static std::shared_ptr<T> Make(Args&& ...args)
+        {
+            return std::allocate_shared<T>(
+                Allocator<T>(),
+                std::forward<Args>(args)...);
+        }
 
         template<typename T, typename>
         struct TaskCb {};
@@ -419,17 +631,41 @@ namespace Lib {
             bool m_called = false;
         };
 
-        UUID m_id;
-        TaskState m_state;
-
-        Clock::time_point m_createdOn;
+        // Read by the scheduler on every pass over the task, so kept at the
+        // front where they share the cache line holding the vtable pointer.
+        // Waiting and the setters lock the task's stripe of the ParkingLot
+        // rather than carrying a mutex and condition variable of their own.
+        std::atomic<TaskState> m_state;
+        // Set once the task is cancelled, which a running body can poll
+        // without taking the lock.
+        std::atomic<bool> m_cancelled{false};
+        TaskPriority m_priority = TaskPriority::NORMAL;
+        bool m_valid = true;
+        // False once the task or anything it depends on is invalid.
+        std::atomic<bool> m_allValid{true};
         Clock::time_point m_before;
         Clock::time_point m_after;
-        bool m_valid = true;
+        Clock::duration m_estimate = Clock::duration::zero();
+        // Dependencies, dependents and the rest of the graph bookkeeping,
+        // allocated with the first edge of the task so that tasks without
+        // any do not pay for it.
+        std::atomic<Links*> m_links{nullptr};
+        UUID m_id;
 
-        std::vector<TaskPtr> m_dependencies;
-        mutable std::condition_variable m_cond;
-        mutable std::mutex m_mutex;
+        // Only touched as the task is retried, recurs or reaches a new stage.
+        // Retries taken so far and the delay before the last of them, set
+        // by the scheduler as the task is retried, then the finished and
+        // missed runs of a recurring task.
+        unsigned m_retries = 0;
+        unsigned m_retryLimit = 0;
+        unsigned m_runs = 0;
+        unsigned m_missed = 0;
+        Clock::duration m_retryDelay = Clock::duration::zero();
+        // The recurrence, with the time the current run was due so retries
+        // do not move a fixed-rate grid.
+        Recurrence m_recurrence;
+        Clock::time_point m_due = Clock::time_point::max();
+        TaskTimes m_times;
     };
 
     template<>
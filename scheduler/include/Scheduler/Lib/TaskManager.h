@@ -2,12 +2,20 @@
 
 #include <Scheduler/Common/Error.h>
 #include <Scheduler/Lib/Task.h>
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
 
-    struct TaskManagerParams { };
+    struct TaskManagerParams
+    {
+        /// Most outcomes of finished tasks kept for lookups by ID once the
+        /// tasks themselves have been let go. The oldest are forgotten
+        /// first, after which a lookup by ID no longer finds the task.
+        size_t outcomes = 1 << 16;
+    };
 
     class TaskManager;
     typedef std::shared_ptr<TaskManager> TaskManagerPtr;
@@ -23,6 +31,9 @@ namespace Lib {
 
         virtual void Add(TaskPtr&& task) = 0;
 
+        /// Bulk insert for a batch of tasks under a single lock.
+        virtual void Add(std::vector<TaskPtr>&& tasks) = 0;
+
         void Expire(const UUID& id);
 
         virtual void Expire(const TaskPtr& task) = 0;
@@ -31,8 +42,17 @@ namespace Lib {
 
         virtual void Finalize(const TaskPtr& task) = 0;
 
+        /// Look up a task. One which has finished and been let go is
+        /// reported by its outcome: E_COMPLETED, E_FAILURE or E_CANCELLED.
         virtual Error GetTask(const UUID& id, TaskPtr& task) const = 0;
 
+        /// Bulk lookup for a batch of tasks. The output is resized to match
+        /// the given IDs and any task which could not be found is left as a
+        /// nullptr, in which case E_NOT_FOUND is returned.
+        virtual Error GetTasks(
+            const std::vector<UUID>& ids,
+            std::vector<TaskPtr>& tasks) const = 0;
+
         virtual void Shutdown(bool wait = true) = 0;
 
     protected:
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Counts of the blocks which went to and from the heap rather than
+    /// being recycled, summed over every thread.
+    struct TaskPoolStats
+    {
+        /// Blocks taken from the heap because the pool was empty, or which
+        /// were too large for it.
+        uint64_t fresh = 0;
+        /// Blocks given back to the heap because the pool was full, or
+        /// which were too large for it.
+        uint64_t released = 0;
+    };
+
+    /// Recycles the memory of tasks, and of the runners which carry them
+    /// through the executor, in fixed size blocks. Each thread keeps a free
+    /// list per block size and only goes to a shared depot, in batches,
+    /// when its list runs dry or grows too long. Tasks tend to be created
+    /// on one thread and destroyed on another, so the depot is what carries
+    /// blocks back to the creating threads. Sizes beyond the largest block
+    /// go straight to the heap.
+    class TaskPool
+    {
+    public:
+        /// Size of the smallest block, and the step between block sizes.
+        static const size_t BLOCK_SIZE = 64;
+
+        /// Number of block sizes. Larger allocations are not pooled.
+        static const size_t SIZE_CLASSES = 16;
+
+        /// Blocks moved between a thread and the depot at a time.
+        static const size_t BATCH_SIZE = 32;
+
+        /// Most batches of each block size the depot keeps. Blocks beyond
+        /// that go back to the heap.
+        static const size_t DEPOT_BATCHES = 64;
+
+        /// Take a block of at least the given size.
+        static void* Allocate(size_t size);
+
+        /// Return a block taken with Allocate for the same size.
+        static void Deallocate(void* block, size_t size);
+
+        /// Read the counts so far.
+        static TaskPoolStats GetStats();
+    };
+
+    /// Standard allocator drawing from the TaskPool, for use with
+    /// std::allocate_shared so an object and its reference counts share
+    /// one recycled block.
+    template<typename T>
+    class PoolAllocator
+    {
+    public:
+        typedef T value_type;
+
+        PoolAllocator() = default;
+
+        template<typename U>
+        PoolAllocator(const PoolAllocator<U>&) { }
+
+        T* allocate(size_t n)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t),
+                "Pooled blocks are only aligned as the heap would align them");
+            return static_cast<T*>(TaskPool::Allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            TaskPool::Deallocate(p, n * sizeof(T));
+        }
+    };
+
+    template<typename T, typename U>
+    bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    {
+        return true;
+    }
+
+    template<typename T, typename U>
+    bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    {
+        return false;
+    }
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Common/Error.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    class Admission;
+    typedef std::shared_ptr<Admission> AdmissionPtr;
+
+    /// Counts the tasks a scheduler has taken on and has not yet finished
+    /// with against a fixed capacity. Producers take room before queueing a
+    /// task and the scheduler gives it back once it drops the task. Taking
+    /// and giving back room is a single atomic operation unless a producer
+    /// is blocked waiting for room.
+    class Admission
+    {
+        Admission(const Admission&) = delete;
+        Admission& operator=(const Admission&) = delete;
+
+    public:
+        /// Create a gate for the given number of tasks. A capacity of zero
+        /// admits everything.
+        explicit Admission(size_t capacity = 0);
+
+        /// Take room for the given number of tasks, waiting up to the
+        /// timeout for it to free up. Room is taken for all of the tasks or
+        /// none of them. Returns E_FULL when there is still no room once the
+        /// timeout has passed and E_CANCELLED once shutdown.
+        Error Acquire(size_t count, const Clock::duration& timeout);
+
+        /// Take room for the given number of tasks even if that goes past
+        /// the capacity.
+        void Force(size_t count);
+
+        size_t Capacity() const { return m_capacity; }
+
+        bool IsShutdown() const
+        {
+            return m_shutdown.load(std::memory_order_acquire);
+        }
+
+        /// Give back room for the given number of tasks, waking any producer
+        /// waiting for it.
+        void Release(size_t count);
+
+        /// Fail every producer which is waiting, and any which comes along
+        /// later, with E_CANCELLED.
+        void Shutdown();
+
+        /// Take room for the given number of tasks if there is enough of it
+        /// right now.
+        bool TryAcquire(size_t count);
+
+        /// Take room for the longest run of a batch which fits right now.
+        /// The totals hold the running count of tasks up to and including
+        /// each entry of the batch. Returns the number of entries admitted.
+        size_t TryAcquire(const std::vector<size_t>& totals);
+
+        /// Number of tasks currently holding room.
+        size_t Used() const { return m_used.load(std::memory_order_relaxed); }
+
+    private:
+        const size_t m_capacity;
+        std::atomic<size_t> m_used;
+        std::atomic<bool> m_shutdown;
+
+        // Producers blocked in Acquire. Release only takes the lock to wake
+        // them when there are any.
+        std::atomic<size_t> m_waiters;
+        std::condition_variable m_cond;
+        std::mutex m_mutex;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Task.h>
+#include <memory>
+#include <mutex>
+#include <random>
+
+namespace Scheduler {
+namespace Lib {
+
+    class Backoff;
+    typedef std::shared_ptr<Backoff> BackoffPtr;
+
+    /// Decides when a task which asked to be retried runs again, and whether
+    /// it may be retried at all. Delays grow exponentially from the retry
+    /// interval of the task with decorrelated jitter: each one is drawn at
+    /// random between the interval and three times the previous delay, up
+    /// to a cap. Retries are limited per task by Task::SetRetryLimit and
+    /// across the scheduler by a budget of retries per second.
+    class Backoff
+    {
+        Backoff(const Backoff&) = delete;
+        Backoff& operator=(const Backoff&) = delete;
+
+    public:
+        /// Create the policy with the longest delay allowed and the number
+        /// of retries allowed per second, up to a second's worth at once. A
+        /// budget of zero allows every retry. The delays are drawn from a
+        /// generator seeded with the time of creation.
+        Backoff(
+            const Clock::duration& cap,
+            size_t budget = 0,
+            const Clock::time_point& now = Now());
+
+        size_t Budget() const { return m_budget; }
+
+        const Clock::duration& Cap() const { return m_cap; }
+
+        /// Delay before the next retry of a task with the given retry
+        /// interval, following a retry which waited the previous delay.
+        /// There is no previous delay before the first retry.
+        Clock::duration Next(
+            const Clock::duration& interval,
+            const Clock::duration& previous = Clock::duration::zero());
+
+        /// Take a retry for the task, counting it against the task and
+        /// setting the time it may next run. Returns E_FULL when the task
+        /// has used up its own retries or the scheduler has used up its
+        /// budget, in which case the task is left as it was.
+        Error Retry(Task& task, const Clock::time_point& now = Now());
+
+    private:
+        /// Take a retry from the budget if there is one left.
+        bool Take(const Clock::time_point& now);
+
+        const Clock::duration m_cap;
+        const size_t m_budget;
+
+        std::mutex m_mutex;
+        std::default_random_engine m_engine;
+        // Retries left in the budget, refilled as time passes.
+        double m_tokens;
+        Clock::time_point m_refilled;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <Scheduler/Lib/Scheduler.h>
+
+#include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Admission.h>
+#include <Scheduler/Lib/Backoff.h>
+#include <Scheduler/Lib/Chain.h>
+#include <Scheduler/Lib/Executor.h>
+#include <Scheduler/Lib/SlotMap.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/TaskManager.h>
+#include <Scheduler/Lib/TimerWheel.h>
+#include <Scheduler/Lib/UUID.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Scheduler without a central loop. Producers resolve the dependencies
+    /// of a task as they queue it and workers settle the dependents of a
+    /// task as they complete it, each decrementing an atomic count of the
+    /// dependencies a task is still waiting on. Whichever thread takes that
+    /// count to zero hands the task to the executor. The only thread of its
+    /// own is a timer thread for premature tasks, retries, deadlines and
+    /// dependencies which are never queued.
+    class DecentralizedTaskScheduler : public TaskScheduler
+    {
+        friend TaskScheduler;
+
+    public:
+        ~DecentralizedTaskScheduler();
+
+        Error Cancel(const UUID& id) override;
+
+        void GetStats(SchedulerStats& stats) const override;
+
+        bool IsShutdown() const { return m_shutdownComplete; }
+
+        void Notify();
+
+        std::shared_ptr<DecentralizedTaskScheduler> shared_from_this();
+
+        void Shutdown(bool wait = true);
+
+        void Start();
+
+    protected:
+        Error Initialize();
+
+        TaskPtr Continue(TaskPtr& task) override;
+
+        void Notify(TaskPtr& task, TaskState state);
+
+        /// Serve the timers which are due, or wait for the next one.
+        bool RunOnce();
+
+    private:
+        enum class Phase : uint8_t
+        {
+            /// Known only as a dependency of a queued task.
+            NEW,
+            /// Queued and waiting on its start time or its dependencies.
+            PENDING,
+            /// Handed to the executor.
+            RUNNING,
+            /// Completed, failed or cancelled.
+            DONE
+        };
+
+        struct Node;
+        typedef std::shared_ptr<Node> NodePtr;
+
+        /// State shared between every thread which touches a task.
+        struct Node
+        {
+            TaskPtr task;
+            std::atomic<Phase> phase{Phase::NEW};
+            // Dependencies the task is still waiting on, plus one held by
+            // the thread resolving it until it is done registering.
+            std::atomic<uint32_t> outstanding{0};
+            // The task was queued with this scheduler and holds room
+            // against its capacity until it is released.
+            bool admitted = false;
+            // Dependencies have been resolved, so a start timer only has to
+            // dispatch the task.
+            bool resolved = false;
+
+            std::mutex mutex;
+            // Set under the mutex once dependents are being settled. Nothing
+            // may register as a dependent after that.
+            bool done = false;
+            std::vector<NodePtr> dependents;
+
+            // Timers which may still be armed long after the task is done,
+            // guarded by the timer mutex.
+            SlotHandle deadline = INVALID_HANDLE;
+            SlotHandle timeout = INVALID_HANDLE;
+        };
+
+        struct Timer
+        {
+            enum Kind
+            {
+                /// Premature task or retry which may now start.
+                START,
+                /// Deadline of a pending or running task.
+                DEADLINE,
+                /// Check on a task waiting on a dependency never queued.
+                TIMEOUT
+            };
+
+            Kind kind = START;
+            std::weak_ptr<Node> node;
+        };
+
+        DecentralizedTaskScheduler(
+            const SchedulerParams& params,
+            std::shared_ptr<ScheduleReporter>&& reporter,
+            std::shared_ptr<TaskManager>&& manager,
+            std::shared_ptr<Executor>&& executor,
+            std::shared_ptr<Admission>&& admission,
+            std::shared_ptr<Backoff>&& backoff);
+
+        void Enqueue(Task* task) override;
+        void Enqueue(Chain* chain) override;
+
+        Error Enqueue(Task* task, const Clock::duration& timeout) override;
+        Error Enqueue(Chain* chain, const Clock::duration& timeout) override;
+
+        void EnqueueBatch(std::vector<TaskPtr>&& batch) override;
+
+        Admission& GetAdmission() override { return *m_admission; }
+
+        /// Take in tasks which have already been validated, admitted and
+        /// handed to the manager, reporting them in batches of at most
+        /// intakeBatchSize.
+        void Admit(const std::vector<TaskPtr>& tasks);
+
+        /// Cancel a task which has been settled, dropping it from the
+        /// executor if it was handed over.
+        void CancelNode(const NodePtr& node, Phase previous);
+
+        /// Settle the dependents of a task which has been settled, failing
+        /// them transitively if it did not succeed, and release it. When
+        /// claim is given the first dependent made ready is returned
+        /// through it instead of being dispatched.
+        void Complete(const NodePtr& node, NodePtr* claim = nullptr);
+
+        /// Get the node for a task taken in by the intake and move it from
+        /// NEW to PENDING. Returns nullptr for a task which is already
+        /// queued or settled.
+        NodePtr Admit(const TaskPtr& task);
+
+        /// Take a task with nothing left to wait on for running. Returns
+        /// false if another thread got to it first or if it was cancelled,
+        /// in which case it is settled here.
+        bool Claim(const NodePtr& node);
+
+        /// Hand a task with nothing left to wait on to the executor.
+        void Dispatch(const NodePtr& node);
+
+        /// Cancel a task whose deadline has passed.
+        void Expire(const NodePtr& node);
+
+        /// Fail a task unless it has already been settled.
+        void FailNode(const NodePtr& node);
+
+        NodePtr Find(const UUID& id);
+
+        /// Check if a dependency has never been queued. A task waiting for
+        /// its start time is still NEW but its node is already PENDING.
+        bool IsUnqueued(const TaskPtr& task);
+
+        /// Re-arm a recurring task in place after a successful run, waiting
+        /// on a start timer for its next run. Returns false when the task
+        /// does not recur or its recurrence is over.
+        bool Recur(const NodePtr& node);
+
+        /// Forget a settled task, giving back its room, along with the
+        /// nodes of dependencies which were never queued and which nothing
+        /// else is waiting on.
+        void Release(const NodePtr& node);
+
+        /// Register the task with each dependency it is waiting on,
+        /// dispatching it straight away if there are none.
+        void Resolve(const NodePtr& node);
+
+        void ScheduleTimer(
+            const NodePtr& node,
+            Timer::Kind kind,
+            const Clock::time_point& when);
+
+        /// Move a task to DONE from any other phase, returning the phase it
+        /// was in. Only the first caller gets anything but DONE back.
+        Phase Settle(Node& node);
+
+        /// Get the node for a task, creating one if there is none. Called
+        /// with the node lock held.
+        NodePtr Track(const TaskPtr& task);
+
+        size_t m_intakeBatchSize;
+        DispatchPolicy m_policy;
+
+        std::atomic<bool> m_shutdown{false};
+        std::atomic<bool> m_shutdownComplete{false};
+        std::atomic<bool> m_started{false};
+        // The scheduler itself, handed to every runner it dispatches, set
+        // once it is started.
+        std::weak_ptr<DecentralizedTaskScheduler> m_self;
+
+        // Node of every task known to the scheduler. Nodes of dependencies
+        // which were never queued are created, registered with and dropped
+        // under the lock, as is the move of a node out of NEW on intake.
+        std::mutex m_mutex;
+        std::unordered_map<UUID, NodePtr> m_nodes;
+        // Ready tasks held back until the scheduler is started.
+        std::vector<NodePtr> m_held;
+
+        // Timer facility, served by the scheduler thread.
+        std::mutex m_timerMutex;
+        std::condition_variable m_timerCond;
+        TimerWheel m_timers;
+        SlotMap<Timer> m_timerEntries;
+        // Time the timer thread is asleep until, so only timers due before
+        // it need to wake the thread. The thread looks at every timer before
+        // going back to sleep, so this is min() while it is awake.
+        Clock::time_point m_wakeup = Clock::time_point::min();
+        bool m_notify = false;
+        std::thread m_thread;
+
+        // Time from being queued to being taken in, and from then to being
+        // handed to the executor. Producers and workers record alongside
+        // each other.
+        Histogram m_intakeLatency;
+        Histogram m_waitLatency;
+
+        std::shared_ptr<Admission> m_admission;
+        std::shared_ptr<Backoff> m_backoff;
+        std::shared_ptr<Executor> m_executor;
+        std::shared_ptr<ScheduleReporter> m_reporter;
+        std::shared_ptr<TaskManager> m_manager;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Scheduler/Lib/Executor.h>
+#include <Scheduler/Lib/TaskRunner.h>
+#include <Scheduler/Lib/UUID.h>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Executor without threads of its own. Queued tasks are run on the
+    /// thread which calls RunPending, the highest priority class first and
+    /// in the order they were queued within a class, so the same tasks
+    /// always run in the same order.
+    class DeterministicExecutor : public Executor
+    {
+    public:
+        DeterministicExecutor(const ExecutorParams& params);
+        ~DeterministicExecutor();
+
+        Error Cancel(const UUID& id) override;
+
+        using Executor::Enqueue;
+        void Enqueue(std::shared_ptr<TaskRunner>&& task) override;
+
+        /// Reports a single entry, for the calling thread.
+        void GetWorkerStats(std::vector<ExecutorStats>& stats) const override;
+
+        /// Run queued tasks until there are none left, including those
+        /// queued by the tasks being run. Returns the number of tasks run.
+        size_t RunPending();
+
+        void Shutdown(bool wait = true) override;
+
+    protected:
+        Error Initialize() override;
+
+    private:
+        /// Take the next task to run off the queues.
+        bool Pop(TaskRunnerPtr& task);
+
+        DispatchPolicy m_policy;
+
+        bool m_shutdown = false;
+        std::mutex m_mutex;
+
+        std::array<std::deque<TaskRunnerPtr>, TASK_PRIORITY_COUNT> m_queues;
+        std::unordered_map<UUID, TaskRunner*> m_index;
+        ExecutorHistograms m_histograms;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -2,9 +2,10 @@
 
 #include <Scheduler/Lib/Task.h>
 #include <Scheduler/Lib/TaskManager.h>
-#include <map>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
@@ -16,6 +17,7 @@ namespace Lib {
         ~MemoryTaskManager();
 
         void Add(TaskPtr&& task) override;
+        void Add(std::vector<TaskPtr>&& tasks) override;
 
         void Expire(const TaskPtr& task) override;
 
@@ -23,6 +25,17 @@ namespace Lib {
 
         Error GetTask(const UUID& id, TaskPtr& task) const override;
 
+        Error GetTasks(
+            const std::vector<UUID>& ids,
+            std::vector<TaskPtr>& tasks) const override;
+
+        /// Number of outcomes of finished tasks currently remembered.
+        size_t GetOutcomeCount() const;
+
+        /// Number of tasks currently held, from being added until they
+        /// finish.
+        size_t GetTaskCount() const;
+
         std::shared_ptr<MemoryTaskManager> shared_from_this();
 
         void Shutdown(bool wait = true) override;
@@ -31,12 +44,18 @@ namespace Lib {
         Error Initialize() override;
 
     private:
+        /// Remember the outcome of a task, forgetting the oldest outcome
+        /// once there are too many. Called with the lock held.
+        void Remember(const UUID& id, TaskState state);
+
         TaskManagerParams m_params;
 
-        std::map<UUID, TaskPtr> m_tasks;
-        std::mutex m_mutex;
+        std::unordered_map<UUID, TaskPtr> m_tasks;
+        mutable std::mutex m_mutex;
 
         std::unordered_map<UUID, TaskState> m_cache;
+        // IDs in m_cache, oldest first.
+        std::deque<UUID> m_order;
     };
 
 }  // namespace Lib
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Unbounded multi-producer single-consumer queue (Vyukov). Producers
+    /// never block on each other or on the consumer: a push is a single
+    /// atomic exchange followed by a store to link the node.
+    ///
+    /// The queue also carries the consumer's idle flag so producers can tell
+    /// whether the consumer needs to be woken up. Only the first producer to
+    /// push after the consumer parks is told to wake it.
+    template<typename T>
+    class MpscQueue
+    {
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        struct Node
+        {
+            Node() = default;
+            Node(T&& v) : value(std::move(v)) { }
+
+            std::atomic<Node*> next{nullptr};
+            T value;
+        };
+
+    public:
+        MpscQueue()
+            : m_head(&m_stub),
+              m_tail(&m_stub)
+        { }
+
+        ~MpscQueue()
+        {
+            Clear();
+            if (m_tail != &m_stub) delete m_tail;
+        }
+
+        /// Consumer only. Drop every queued value.
+        void Clear()
+        {
+            T value;
+            while (Pop(value));
+        }
+
+        /// Consumer only. Predicate check for whether anything has been
+        /// pushed which the consumer has not yet taken. A push which is
+        /// still in flight counts as pending even though Pop may not see it
+        /// just yet.
+        bool Empty() const
+        {
+            return m_head.load(std::memory_order_seq_cst) == m_tail;
+        }
+
+        /// Consumer only. Mark the consumer as idle ahead of waiting. Returns
+        /// false if something was pushed in the meantime and the consumer
+        /// should not go to sleep.
+        bool Park()
+        {
+            m_parked.store(true, std::memory_order_seq_cst);
+            if (!Empty())
+            {
+                Unpark();
+                return false;
+            }
+            return true;
+        }
+
+        /// Consumer only. Take the value at the front of the queue.
+        bool Pop(T& value)
+        {
+            Node* tail = m_tail;
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (!next) return false;
+
+            value = std::move(next->value);
+            m_tail = next;
+            if (tail != &m_stub) delete tail;
+            return true;
+        }
+
+        /// Push a value onto the queue. Returns true if the consumer was
+        /// parked and the caller is responsible for waking it up.
+        bool Push(T&& value)
+        {
+            Node* node = new Node(std::move(value));
+            Node* prev = m_head.exchange(node, std::memory_order_seq_cst);
+            prev->next.store(node, std::memory_order_release);
+            return m_parked.exchange(false, std::memory_order_seq_cst);
+        }
+
+        /// Push a batch of values onto the queue with a single exchange. The
+        /// batch is linked up privately first so consumers see it appear all
+        /// at once and in order. Returns true if the consumer was parked and
+        /// the caller is responsible for waking it up.
+        bool Push(std::vector<T>&& values)
+        {
+            if (values.empty()) return false;
+
+            Node* first = new Node(std::move(values.front()));
+            Node* last = first;
+            for (size_t i = 1; i < values.size(); ++i)
+            {
+                Node* node = new Node(std::move(values[i]));
+                last->next.store(node, std::memory_order_relaxed);
+                last = node;
+            }
+            values.clear();
+
+            Node* prev = m_head.exchange(last, std::memory_order_seq_cst);
+            prev->next.store(first, std::memory_order_release);
+            return m_parked.exchange(false, std::memory_order_seq_cst);
+        }
+
+        /// Consumer only. Clear the idle flag once the consumer is running.
+        void Unpark() { m_parked.store(false, std::memory_order_relaxed); }
+
+    private:
+        Node m_stub;
+        std::atomic<Node*> m_head;
+        Node* m_tail;
+        std::atomic<bool> m_parked{false};
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
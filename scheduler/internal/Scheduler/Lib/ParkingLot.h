@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Waiting and short critical sections keyed by address, for objects
+    /// too numerous to carry a mutex and condition variable each. Addresses
+    /// hash onto a fixed set of stripes, so unrelated objects can share a
+    /// stripe: waiters always re-check their condition when woken and the
+    /// stripe locks are only ever held briefly.
+    ///
+    /// A notifier changes the state waited on before calling NotifyAll.
+    /// NotifyAll only takes the stripe lock when someone is parked on the
+    /// stripe, so notifying nobody costs a single atomic load.
+    class ParkingLot
+    {
+        ParkingLot() = delete;
+
+        struct alignas(64) Stripe
+        {
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::atomic<uint32_t> waiters{0};
+        };
+
+    public:
+        static const unsigned STRIPE_BITS = 6;
+        static const size_t STRIPES = size_t(1) << STRIPE_BITS;
+
+        /// Lock guarding the given address. It must not be held across a
+        /// call to Wait or NotifyAll for an address on the same stripe.
+        static std::mutex& GetMutex(const void* address)
+        {
+            return GetStripe(address).mutex;
+        }
+
+        /// Wake every thread parked on the address, along with any parked
+        /// on an address sharing its stripe.
+        static void NotifyAll(const void* address);
+
+        /// Park the calling thread until the predicate holds. The predicate
+        /// is checked with the stripe locked, must read the state it waits
+        /// on with sequentially consistent loads, and must not lock the
+        /// stripe itself.
+        template<typename Predicate>
+        static void Wait(const void* address, Predicate&& ready)
+        {
+            Stripe& stripe = GetStripe(address);
+            std::unique_lock<std::mutex> lock(stripe.mutex);
+
+            // Counted before the predicate is checked, so a notifier which
+            // changed the state too late for the check sees the waiter.
+            stripe.waiters.fetch_add(1);
+            stripe.cond.wait(lock, ready);
+            stripe.waiters.fetch_sub(1);
+        }
+
+    private:
+        static Stripe& GetStripe(const void* address);
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
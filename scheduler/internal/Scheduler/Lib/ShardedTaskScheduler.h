@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Scheduler/Lib/Scheduler.h>
+
+#include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Admission.h>
+#include <Scheduler/Lib/Backoff.h>
+#include <Scheduler/Lib/Chain.h>
+#include <Scheduler/Lib/Executor.h>
+#include <Scheduler/Lib/StandardTaskScheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/TaskManager.h>
+#include <Scheduler/Lib/UUID.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Scheduler made up of several StandardTaskScheduler loops, each on its
+    /// own thread. Tasks are partitioned across the shards by ID and every
+    /// shard shares the same executor and manager. A task waiting on a task
+    /// owned by another shard is resolved through completion messages posted
+    /// between the shards.
+    class ShardedTaskScheduler : public TaskScheduler
+    {
+        friend TaskScheduler;
+
+    public:
+        ~ShardedTaskScheduler();
+
+        Error Cancel(const UUID& id) override;
+
+        void GetStats(SchedulerStats& stats) const override;
+
+        bool IsShutdown() const;
+
+        void Notify();
+
+        std::shared_ptr<ShardedTaskScheduler> shared_from_this();
+
+        void Shutdown(bool wait = true);
+
+        /// Number of scheduler loops the tasks are partitioned across.
+        size_t Size() const { return m_shards.size(); }
+
+        void Start();
+
+    protected:
+
+        Error Initialize();
+
+        TaskPtr Continue(TaskPtr& task) override;
+
+        void Notify(TaskPtr& task, TaskState state);
+
+        /// The shards run their own loops once started. Running the sharded
+        /// scheduler directly blocks until it has been shutdown.
+        bool RunOnce();
+
+    private:
+        ShardedTaskScheduler(
+            const SchedulerParams& params,
+            std::shared_ptr<ScheduleReporter>&& reporter,
+            std::shared_ptr<TaskManager>&& manager,
+            std::shared_ptr<Executor>&& executor,
+            std::shared_ptr<Admission>&& admission,
+            std::shared_ptr<Backoff>&& backoff);
+
+        void Enqueue(Task* task) override;
+        void Enqueue(Chain* chain) override;
+
+        Error Enqueue(Task* task, const Clock::duration& timeout) override;
+        Error Enqueue(Chain* chain, const Clock::duration& timeout) override;
+
+        void EnqueueBatch(std::vector<TaskPtr>&& batch) override;
+
+        /// Hand the chain and its children to the shards which own them.
+        void EnqueueChain(ChainPtr&& chain);
+
+        Admission& GetAdmission() override { return *m_admission; }
+
+        StandardTaskScheduler& Owner(const UUID& id) const;
+
+        bool m_shutdown = false;
+
+        std::shared_ptr<Admission> m_admission;
+        std::shared_ptr<Backoff> m_backoff;
+
+        std::condition_variable m_cond;
+        std::mutex m_mutex;
+
+        std::vector<std::shared_ptr<StandardTaskScheduler>> m_shards;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Handle to a value stored in a SlotMap. The low 32 bits index the slot
+    /// and the high 32 bits carry the generation of the slot at the time the
+    /// value was inserted, so a handle outliving its value is detected rather
+    /// than aliasing whatever reuses the slot.
+    typedef uint64_t SlotHandle;
+
+    /// A handle which never refers to a value.
+    const SlotHandle INVALID_HANDLE = 0;
+
+    /// Generational slot map. Values live in a flat array and are addressed
+    /// by a dense 32 bit index, so lookups are a bounds and generation check
+    /// with no hashing or tree walk. Freed slots are reused in LIFO order
+    /// which keeps the array as compact as the number of live values.
+    ///
+    /// Pointers returned by Get are invalidated by the next Insert.
+    template<typename T>
+    class SlotMap
+    {
+        SlotMap(const SlotMap&) = delete;
+        SlotMap& operator=(const SlotMap&) = delete;
+
+        struct Slot
+        {
+            T value;
+            // Odd while the slot holds a value and even while it is free.
+            uint32_t generation = 0;
+        };
+
+    public:
+        SlotMap() = default;
+
+        /// Index of the slot a handle refers to. Indices are below Capacity
+        /// and suitable for addressing side tables.
+        static uint32_t Index(SlotHandle handle)
+        {
+            return static_cast<uint32_t>(handle & 0xFFFFFFFFu);
+        }
+
+        /// Number of slots, free or not.
+        size_t Capacity() const { return m_slots.size(); }
+
+        /// Drop every value. Outstanding handles are invalidated.
+        void Clear()
+        {
+            for (uint32_t index = 0; index < m_slots.size(); ++index)
+            {
+                Slot& slot = m_slots[index];
+                if (!(slot.generation & 1)) continue;
+
+                slot.value = T();
+                ++slot.generation;
+                m_free.emplace_back(index);
+            }
+            m_size = 0;
+        }
+
+        bool Contains(SlotHandle handle) const { return Get(handle) != nullptr; }
+
+        bool Empty() const { return m_size == 0; }
+
+        /// Release the value for the handle. Returns false if the handle was
+        /// already stale.
+        bool Erase(SlotHandle handle)
+        {
+            if (!Get(handle)) return false;
+
+            uint32_t index = Index(handle);
+            Slot& slot = m_slots[index];
+            slot.value = T();
+            ++slot.generation;
+            m_free.emplace_back(index);
+            --m_size;
+            return true;
+        }
+
+        T* Get(SlotHandle handle)
+        {
+            uint32_t index = Index(handle);
+            if (index >= m_slots.size()) return nullptr;
+
+            Slot& slot = m_slots[index];
+            if (slot.generation != Generation(handle)) return nullptr;
+            return &slot.value;
+        }
+
+        const T* Get(SlotHandle handle) const
+        {
+            uint32_t index = Index(handle);
+            if (index >= m_slots.size()) return nullptr;
+
+            const Slot& slot = m_slots[index];
+            if (slot.generation != Generation(handle)) return nullptr;
+            return &slot.value;
+        }
+
+        /// Store a value and return the handle it can be retrieved with.
+        SlotHandle Insert(T&& value)
+        {
+            uint32_t index = 0;
+            if (!m_free.empty())
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            else
+            {
+                index = static_cast<uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            Slot& slot = m_slots[index];
+            slot.value = std::move(value);
+            ++slot.generation;
+            ++m_size;
+            return (static_cast<SlotHandle>(slot.generation) << 32) | index;
+        }
+
+        size_t Size() const { return m_size; }
+
+    private:
+        static uint32_t Generation(SlotHandle handle)
+        {
+            return static_cast<uint32_t>(handle >> 32);
+        }
+
+        std::vector<Slot> m_slots;
+        std::vector<uint32_t> m_free;
+        size_t m_size = 0;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
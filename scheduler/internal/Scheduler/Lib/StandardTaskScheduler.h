@@ -3,32 +3,50 @@
 #include <Scheduler/Lib/Scheduler.h>
 
 #include <Scheduler/Common/Error.h>
+#include <Scheduler/Lib/Admission.h>
+#include <Scheduler/Lib/Backoff.h>
 #include <Scheduler/Lib/Chain.h>
 #include <Scheduler/Lib/Executor.h>
 #include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/MpscQueue.h>
+#include <Scheduler/Lib/SlotMap.h>
 #include <Scheduler/Lib/TaskManager.h>
+#include <Scheduler/Lib/TimerWheel.h>
 #include <Scheduler/Lib/UUID.h>
+#include <array>
 #include <condition_variable>
 #include <deque>
 #include <memory>
 #include <mutex>
-#include <set>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
 
+    class ShardedTaskScheduler;
+
     class StandardTaskScheduler : public TaskScheduler
     {
+        friend ShardedTaskScheduler;
         friend TaskRunner;
         friend TaskScheduler;
 
     public:
         ~StandardTaskScheduler();
 
+        Error Cancel(const UUID& id) override;
+
+        void GetStats(SchedulerStats& stats) const override;
+
         bool IsShutdown() const { return m_shutdownComplete; }
 
+        /// Earliest time a timer of the scheduler is due, whether a task
+        /// waiting to start, a deadline or a dependency timeout. Returns
+        /// time_point::max() when there is none.
+        Clock::time_point NextExpiry();
+
         void Notify();
 
         void Run() { while (RunOnce()); }
@@ -40,37 +58,216 @@ namespace Lib {
 
         void Start();
 
+        /// Make a single pass over the scheduler on the calling thread
+        /// without waiting for anything to come in, in place of Start.
+        /// Returns true when there is more to do straight away.
+        bool Step();
+
     protected:
 
         Error Initialize();
 
         void NotifyLocked(std::unique_lock<std::mutex>& lock);
 
+        TaskPtr Continue(TaskPtr& task) override;
+
         void Notify(TaskPtr& task, TaskState state);
 
     private:
+        /// Entry on the intake queue. Besides newly enqueued tasks, shards
+        /// of a sharded scheduler use the queue to deliver dependency edges
+        /// which cross from one shard to another.
+        struct Message
+        {
+            enum Type
+            {
+                /// A task was enqueued with this scheduler.
+                ENQUEUE,
+                /// The sending shard has tasks waiting on the given task,
+                /// which is owned by this shard.
+                WATCH,
+                /// The sending shard no longer has tasks waiting on the
+                /// given task, which is owned by this shard.
+                UNWATCH,
+                /// A task owned by the sending shard has completed.
+                COMPLETED
+            };
+
+            Type type = ENQUEUE;
+            unsigned shard = 0;
+            UUID id;
+            TaskPtr task;
+        };
+
+        static const uint32_t NPOS = 0xFFFFFFFFu;
+
+        /// Bookkeeping for a task known to the scheduler. Records are
+        /// addressed by handle and hold on to the task so the loop never has
+        /// to go back to the manager once a task has been taken in. Tasks
+        /// owned elsewhere which local tasks depend on get a record too.
+        struct Record
+        {
+            enum Flags : uint8_t
+            {
+                ACTIVE = 1 << 0,
+                PENDING = 1 << 1,
+                // The task was queued with this scheduler and holds room
+                // against its capacity until the record is released.
+                ADMITTED = 1 << 2
+            };
+
+            TaskPtr task;
+            uint8_t flags = 0;
+            // Number of dependencies the pending task is still waiting on.
+            uint32_t outstanding = 0;
+            // Position of the handle in m_timeouts.
+            uint32_t timeout = NPOS;
+            // Time the task started waiting on an unqueued dependency.
+            Clock::time_point since;
+            // Pending tasks waiting on this one to complete.
+            std::vector<SlotHandle> dependents;
+            // Shards with tasks waiting on this one to complete.
+            std::vector<unsigned> watchers;
+        };
+
         StandardTaskScheduler(
             const SchedulerParams& params,
             std::shared_ptr<ScheduleReporter>&& reporter,
             std::shared_ptr<TaskManager>&& manager,
-            std::shared_ptr<Executor>&& executor);
+            std::shared_ptr<Executor>&& executor,
+            std::shared_ptr<Admission>&& admission,
+            std::shared_ptr<Backoff>&& backoff);
 
         void Enqueue(Task* task) override;
         void Enqueue(Chain* chain) override;
 
-        void EnqueueLocked(TaskPtr&& task, std::unique_lock<std::mutex>& lock);
-        void EnqueueLocked(TaskPtr& task, std::unique_lock<std::mutex>& lock);
+        Error Enqueue(Task* task, const Clock::duration& timeout) override;
+        Error Enqueue(Chain* chain, const Clock::duration& timeout) override;
+
+        void EnqueueBatch(std::vector<TaskPtr>&& batch) override;
+
+        Admission& GetAdmission() override { return *m_admission; }
+
+        /// Cancel a task the scheduler has a record for, dropping it from
+        /// the executor if it is queued there, and fail its dependents on
+        /// the next pass.
+        bool CancelTask(SlotHandle handle);
+
+        /// Take a dependent of the completed task which has nothing left to
+        /// wait on and mark it active, for the worker which completed the
+        /// task to run itself. Returns nullptr if there is none.
+        TaskPtr ClaimContinuation(SlotHandle handle);
+
+        /// Hand every ready task to the executor, highest priority class
+        /// first. Under the DEADLINE policy each class goes out earliest
+        /// deadline first and tasks which can no longer make it are shed.
+        void DispatchReadyTasks(const Clock::time_point& now);
+
+        /// Queue the children of a chain followed by the chain itself.
+        /// Returns true if the scheduler needs to be woken.
+        bool EnqueueChain(ChainPtr&& chain);
+        bool EnqueueTask(TaskPtr&& task);
+
+        /// Hand a batch of tasks to the manager in one insert and push them
+        /// onto the intake together. Returns true if the scheduler needs to
+        /// be woken.
+        bool EnqueueTasks(std::vector<TaskPtr>&& tasks);
+
+        /// Fail every task which depends on the given failed, expired or
+        /// cancelled task, transitively, releasing each record once swept.
+        void FailDependents(SlotHandle handle);
+        void FailTask(SlotHandle handle);
+
+        /// Look up the handle for a task ID. Returns INVALID_HANDLE when the
+        /// task has no record.
+        SlotHandle Find(const UUID& id) const;
+
+        /// Mark a task as active and queue it for dispatch at the end of
+        /// the pass.
+        bool HandleTask(SlotHandle handle);
+        bool HandleExpiredTask(SlotHandle handle);
 
-        bool HandleTask(TaskPtr& task);
-        bool HandleExpiredTask(TaskPtr& task);
+        bool IsTimedOut(const Record& record, const Clock::time_point& now) const;
 
-        bool IsTimedOut(const TaskPtr& task) const;
+        /// Check if a dependency has never been queued. A task waiting for
+        /// its start time is still NEW but has been taken in, so it counts
+        /// as queued, as does one owned by another shard which is waiting.
+        bool IsUnqueued(const Task& task, const Clock::time_point& now) const;
 
-        bool ProcessActiveTasks();
-        bool ProcessPendingQueue();
-        bool ProcessPendingTasks();
+        /// Add the handle to one of the dense handle lists, recording its
+        /// position on the record so it can be removed in constant time.
+        void Link(
+            std::vector<SlotHandle>& list,
+            uint32_t Record::* position,
+            SlotHandle handle);
 
-        void PrunePrematureTasks();
+        /// Index of the shard which owns the task with the given ID. This is
+        /// always the current shard when the scheduler is not sharded.
+        unsigned Owner(const UUID& id) const;
+
+        /// Tell every shard watching the task that it has completed.
+        void NotifyWatchers(const Record& record);
+
+        /// Deliver a message to the intake of another shard.
+        void Post(unsigned shard, Message&& message);
+
+        bool ProcessCompletedTasks();
+
+        /// Expire every task whose deadline has passed since the last pass.
+        /// Only tasks which are actually due are visited.
+        bool ProcessExpiredTasks(const Clock::time_point& now);
+
+        Clock::time_point NextExpiryLocked() const;
+
+        bool ProcessPendingQueue(const Clock::time_point& now);
+        bool ProcessPendingTasks(const Clock::time_point& now);
+
+        /// Take in, settle and dispatch whatever is ready without waiting.
+        /// Returns false once the scheduler has shutdown.
+        bool Pass(std::unique_lock<std::mutex>& lock);
+
+        void PrunePrematureTasks(const Clock::time_point& now);
+
+        /// Re-arm a recurring task in place after a successful run, waiting
+        /// on the premature timers for its next run. Returns false when the
+        /// task does not recur or its recurrence is over.
+        bool RecurTask(SlotHandle handle);
+
+        /// Add the stats of the executor to the given stats, or those it had
+        /// when the scheduler was shut down.
+        void ReadExecutorStats(ExecutorStats& stats) const;
+
+        /// Drop the record for a task the scheduler is done with.
+        void Release(SlotHandle handle);
+
+        bool ResolveDependents(SlotHandle handle);
+        bool ResolveTask(SlotHandle handle, const Clock::time_point& now);
+
+        /// Drop an active task the executor gave up on without running it,
+        /// either because it could not meet its deadline or because it was
+        /// cancelled there, treating it as expired.
+        void ShedTask(SlotHandle handle);
+
+        void SetShards(
+            unsigned shard,
+            const std::vector<std::weak_ptr<StandardTaskScheduler>>& shards);
+
+        /// Get the handle for a task, creating a record if there is none.
+        /// The record keeps the scheduler's only reference to the task,
+        /// moved in when the caller has one to spare.
+        SlotHandle Track(const TaskPtr& task);
+        SlotHandle Track(TaskPtr&& task);
+
+        /// Remove the handle from a dense handle list if it is in it.
+        void Unlink(
+            std::vector<SlotHandle>& list,
+            uint32_t Record::* position,
+            SlotHandle handle);
+
+        void WatchTask(TaskPtr& task, unsigned shard);
+        /// Drop the shard from the watchers of the task, releasing its record
+        /// if the task was never queued and nothing is left waiting on it.
+        void UnwatchTask(const UUID& id, unsigned shard);
 
         // Flag indiciating Notify has been called and the next Wait phase on
         // the scheduler should be skipped.
@@ -82,22 +279,59 @@ namespace Lib {
         // Scheduler is waiting for changes
         bool m_waiting = false;
 
+        // Maximum number of queued tasks taken in on a single pass
+        size_t m_intakeBatchSize;
+        // Order ready tasks are dispatched in within a priority class
+        DispatchPolicy m_policy;
+
         std::condition_variable m_cond;
-        std::mutex m_mutex;
-        std::deque<UUID> m_queue;
+        mutable std::mutex m_mutex;
+        // Lock-free intake of newly enqueued tasks and cross-shard messages.
+        // Producers never take the scheduler mutex unless the scheduler is
+        // parked waiting.
+        MpscQueue<Message> m_intake;
         std::thread m_thread;
 
-        // Cache the UUID of tasks which are active on the executor
-        std::set<UUID> m_active;
-        // Cache the list of tasks which are currently known and pending
-        std::set<UUID> m_pending;
-        // Cache the list of tasks which are premature and cannot be
-        // run until a certain time.
-        std::unordered_map<UUID, Clock::time_point> m_premature;
-        // Cache the list of tasks which may be timed out due to an
-        // unqueued dependency.
-        std::unordered_map<UUID, Clock::time_point> m_timeouts;
+        // Record for every task the scheduler is tracking. UUIDs are only
+        // used to find a record when a task comes in from outside the loop.
+        SlotMap<Record> m_tasks;
+        std::unordered_map<UUID, SlotHandle> m_handles;
+
+        // Pending tasks which may be timed out due to an unqueued
+        // dependency.
+        std::vector<SlotHandle> m_timeouts;
+        // Tasks which became ready during the pass, by priority class. The
+        // queues are drained at the end of every pass so no class can be
+        // starved by another here.
+        std::array<std::deque<SlotHandle>, TASK_PRIORITY_COUNT> m_ready;
+        // Tasks which have completed since the last pass and whose
+        // dependents still need to be resolved.
+        std::deque<SlotHandle> m_completed;
+        // Timers for the tasks which are premature and cannot be run
+        // until a certain time.
+        TimerWheel m_premature;
+        // Deadlines of the pending and active tasks which carry one. Tasks
+        // without a deadline never get a timer.
+        TimerWheel m_deadlines;
+
+        // Time from being queued to being taken in, and from then to being
+        // handed to the executor.
+        Histogram m_intakeLatency;
+        Histogram m_waitLatency;
+        // Stats of the executor as it was shut down.
+        ExecutorStats m_executorStats;
+
+        // Index of this scheduler within a sharded scheduler along with
+        // every shard, itself included. There are no shards when running
+        // as a single scheduler.
+        unsigned m_shard = 0;
+        std::vector<std::weak_ptr<StandardTaskScheduler>> m_shards;
+        // Shards which were parked when a message was posted to them and
+        // need to be woken once the current pass releases the lock.
+        std::vector<std::shared_ptr<StandardTaskScheduler>> m_wakeups;
 
+        std::shared_ptr<Admission> m_admission;
+        std::shared_ptr<Backoff> m_backoff;
         std::shared_ptr<Executor> m_executor;
         std::shared_ptr<ScheduleReporter> m_reporter;
         std::shared_ptr<TaskManager> m_manager;
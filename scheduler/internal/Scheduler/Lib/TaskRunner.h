@@ -1,11 +1,17 @@
 #pragma once
 
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Lib/Histogram.h>
+#include <atomic>
 #include <memory>
+#include <stdint.h>
 
 namespace Scheduler {
 namespace Lib {
 
+    struct ExecutorStats;
     class Task;
+    enum class TaskPriority : uint8_t;
     class TaskManager;
     class TaskScheduler;
     class UUID;
@@ -13,9 +19,25 @@ namespace Lib {
     class TaskRunner;
     typedef std::shared_ptr<TaskRunner> TaskRunnerPtr;
 
-    class TaskRunner : public std::enable_shared_from_this<TaskRunner>
+    /// Latency histograms a worker keeps for the tasks it runs, recorded by
+    /// the runners as they go.
+    struct ExecutorHistograms
+    {
+        Histogram queued;
+        Histogram running;
+
+        /// Add what has been recorded so far to the stats.
+        void Read(ExecutorStats& stats) const;
+    };
+
+    class TaskRunner
     {
     public:
+        /// Most dependents run back to back on the same worker before the
+        /// next one goes through the scheduler, so a long chain cannot hold
+        /// on to a worker at the expense of everything queued behind it.
+        static const unsigned MAX_CONTINUATIONS = 16;
+
         TaskRunner(
             std::shared_ptr<Task>&& task);
         TaskRunner(
@@ -24,17 +46,58 @@ namespace Lib {
 
         ~TaskRunner();
 
+        /// Create a runner in a block recycled through the TaskPool. One is
+        /// made for every dispatch, so this saves a trip to the heap each
+        /// time a task is handed to the executor.
+        static TaskRunnerPtr Create(
+            std::shared_ptr<Task>&& task,
+            std::weak_ptr<TaskScheduler>&& scheduler);
+
+        /// Deadline of the task being run.
+        Clock::time_point Before() const;
+
+        /// Tombstone the runner while it is queued. A cancelled runner is
+        /// dropped by the worker instead of being run.
+        void Cancel() { m_cancelled.store(true, std::memory_order_release); }
+
         const UUID& Id() const;
 
+        /// Check if the task could still meet its deadline if it were
+        /// started at the given time.
+        bool IsFeasible(const Clock::time_point& start) const;
+
+        bool IsCancelled() const
+        {
+            return m_cancelled.load(std::memory_order_acquire);
+        }
+
         bool IsValid() const;
 
+        TaskPriority Priority() const;
+
         void Release();
 
-        void Run();
+        /// Run the task, followed by any dependent it makes ready which the
+        /// scheduler hands back to run inline. How long each task waited on
+        /// the executor and ran for is recorded in the histograms if given.
+        void Run(ExecutorHistograms* histograms = nullptr);
+
+        /// Drop the task without running it because it can no longer meet
+        /// its deadline. The scheduler treats it as expired.
+        void Shed();
 
     private:
+        /// Run the current task and report the outcome to the scheduler,
+        /// if it is still around. Returns the dependent to run next when
+        /// continuing is allowed and the scheduler has one.
+        std::shared_ptr<Task> RunTask(
+            TaskScheduler* scheduler,
+            bool continuing,
+            ExecutorHistograms* histograms);
+
         std::shared_ptr<Task> m_task;
         std::weak_ptr<TaskScheduler> m_scheduler;
+        std::atomic<bool> m_cancelled{false};
     };
 
 }  // namespace Lib
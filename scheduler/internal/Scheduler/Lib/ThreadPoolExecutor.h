@@ -17,7 +17,10 @@ namespace Lib {
 
         Error Cancel(const UUID& id) override;
 
-        void Enqueue(std::shared_ptr<TaskRunner>& task) override;
+        using Executor::Enqueue;
+        void Enqueue(std::shared_ptr<TaskRunner>&& task) override;
+
+        void GetWorkerStats(std::vector<ExecutorStats>& stats) const override;
 
         std::shared_ptr<ThreadPoolExecutor> shared_from_this();
 
@@ -30,10 +33,12 @@ namespace Lib {
         ExecutorParams m_params;
 
         bool m_shutdown = false;
-        std::mutex m_mutex;
+        mutable std::mutex m_mutex;
 
         typedef std::unique_ptr<ThreadPoolWorker> WorkerPtr;
         std::vector<WorkerPtr> m_workers;
+        // Stats of every worker as it was shut down.
+        std::vector<ExecutorStats> m_retired;
     };
 
 }  // namespace Lib
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Lib/Executor.h>
+#include <Scheduler/Lib/Task.h>
 #include <Scheduler/Lib/TaskRunner.h>
+#include <Scheduler/Lib/UUID.h>
+#include <array>
 #include <condition_variable>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace Scheduler {
 namespace Lib {
@@ -21,11 +27,23 @@ namespace Lib {
         ThreadPoolWorker& operator=(const ThreadPoolWorker&) = delete;
 
     public:
-        ThreadPoolWorker(std::weak_ptr<ThreadPoolExecutor>&& executor);
+        ThreadPoolWorker(
+            std::weak_ptr<ThreadPoolExecutor>&& executor,
+            const Clock::duration& agingInterval = Clock::duration::zero(),
+            DispatchPolicy policy = DispatchPolicy::PRIORITY);
         ~ThreadPoolWorker();
 
+        /// Tombstone the queued runner for a task so it is dropped instead
+        /// of run once it reaches the head of its queue. Returns E_NOT_FOUND
+        /// if the task is not queued on the worker, including once it has
+        /// started running.
+        Error Cancel(const UUID& id);
+
         void Enqueue(TaskRunnerPtr&& task);
 
+        /// Add the latency of the tasks the worker has run to the stats.
+        void GetStats(ExecutorStats& stats) const { m_histograms.Read(stats); }
+
         std::hash<std::thread::id>::result_type Id() const;
 
         void Shutdown(bool wait = true);
@@ -34,6 +52,29 @@ namespace Lib {
         void Wait() const;
 
     private:
+        struct Entry
+        {
+            TaskRunnerPtr task;
+            Clock::time_point queued;
+            // Deadline the class is ordered by, which is always max when
+            // dispatching in FIFO order.
+            Clock::time_point deadline;
+            // Order the task was queued in, breaking ties on the deadline.
+            uint64_t sequence;
+
+            /// Heap ordering, placing the entry which runs first on top.
+            bool operator<(const Entry& other) const
+            {
+                if (deadline != other.deadline) return deadline > other.deadline;
+                return sequence > other.sequence;
+            }
+        };
+
+        /// Take the next task to run. This is the head of the highest
+        /// priority class, except once per aging interval where a lower
+        /// class head which has waited a full interval goes first.
+        bool Pop(TaskRunnerPtr& task);
+
         void Run();
         bool RunOnce();
         void Start();
@@ -45,7 +86,21 @@ namespace Lib {
 
         std::weak_ptr<ThreadPoolExecutor> m_executor;
 
-        std::deque<TaskRunnerPtr> m_queue;
+        Clock::duration m_agingInterval;
+        DispatchPolicy m_policy;
+        // Last time a task was run ahead of its class because of its age
+        Clock::time_point m_aged;
+
+        // Heap of queued tasks for each priority class, ordered by deadline
+        // and then by the order they were queued in.
+        std::array<std::vector<Entry>, TASK_PRIORITY_COUNT> m_queues;
+        size_t m_queued = 0;
+        uint64_t m_sequence = 0;
+        // Runners still queued, by task, so they can be cancelled without
+        // searching the queues. Tombstoned runners leave the index but stay
+        // queued until they are popped.
+        std::unordered_map<UUID, TaskRunner*> m_index;
+        ExecutorHistograms m_histograms;
         mutable std::condition_variable m_cond, m_wait;
         mutable std::mutex m_mutex, m_waitex;
 
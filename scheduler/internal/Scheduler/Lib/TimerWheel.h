@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <Scheduler/Lib/SlotMap.h>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace Scheduler {
+namespace Lib {
+
+    /// Hierarchical timing wheel keyed by task handle. Timers are bucketed by
+    /// tick where a tick is the configured slack window, so every deadline
+    /// falling inside the same window is coalesced into a single expiry.
+    /// Scheduling and cancelling are O(1), and each timer is moved between
+    /// levels at most LEVELS times before it expires.
+    class TimerWheel
+    {
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+    public:
+        enum
+        {
+            BITS = 6,
+            SLOTS = 1 << BITS,
+            LEVELS = 6
+        };
+
+        static const Clock::duration DEFAULT_SLACK;
+
+        explicit TimerWheel(
+            const Clock::duration& slack = DEFAULT_SLACK,
+            const Clock::time_point& now = Now());
+        TimerWheel(TimerWheel&&) = default;
+        ~TimerWheel();
+
+        TimerWheel& operator=(TimerWheel&&) = default;
+
+        /// Cancel a scheduled timer. Cancelled timers are dropped lazily
+        /// when the wheel reaches their slot.
+        bool Cancel(SlotHandle handle);
+
+        /// Drop every scheduled timer.
+        void Clear();
+
+        /// Predicate check for whether the timer for the given handle is
+        /// armed.
+        bool Contains(SlotHandle handle) const
+        {
+            return m_timers.count(handle) > 0;
+        }
+
+        bool Empty() const { return m_timers.empty(); }
+
+        /// Advance the wheel to the given time and append the handle of
+        /// every timer which is now due. Returns the number of timers expired.
+        size_t Expire(
+            const Clock::time_point& now,
+            std::vector<SlotHandle>& expired);
+
+        /// The earliest time at which the wheel needs to be advanced again.
+        /// This is time_point::max() when nothing is scheduled.
+        Clock::time_point NextExpiry() const;
+
+        /// Arm a timer for the given handle. Scheduling a handle which is
+        /// already armed replaces the previous deadline.
+        void Schedule(SlotHandle handle, const Clock::time_point& deadline);
+
+        size_t Size() const { return m_timers.size(); }
+
+        const Clock::duration& Slack() const { return m_slack; }
+
+    private:
+        struct Entry
+        {
+            SlotHandle handle;
+            uint64_t tick;
+            uint64_t generation;
+        };
+
+        typedef std::vector<Entry> Slot;
+
+        uint64_t NextTick() const;
+
+        void Place(Entry&& entry);
+
+        void Process(uint64_t tick, std::vector<SlotHandle>& expired);
+
+        void Release(Slot& slot, std::vector<SlotHandle>& expired);
+
+        Clock::duration m_slack;
+        Clock::time_point m_origin;
+
+        uint64_t m_current = 0;
+        uint64_t m_generation = 0;
+
+        std::array<std::array<Slot, SLOTS>, LEVELS> m_slots;
+        std::array<uint64_t, LEVELS> m_occupied;
+
+        // Timers which were already due when scheduled.
+        Slot m_due;
+        // Timers too far in the future for the top level of the wheel.
+        Slot m_overflow;
+
+        // Generation of the live timer for each handle. Entries in the wheel
+        // which do not match are stale and skipped.
+        std::unordered_map<SlotHandle, uint64_t> m_timers;
+    };
+
+}  // namespace Lib
+}  // namespace Scheduler
@@ -0,0 +1,99 @@
+#include <Scheduler/Common/Clock.h>
+
+#include <algorithm>
+
+namespace {
+
+    std::atomic<Scheduler::TimeSource*> s_timeSource{nullptr};
+
+    /// Map a steady clock time to the wall clock through an offset read
+    /// once, the first time it is needed.
+    std::chrono::system_clock::time_point AnchoredWallTime(
+        const Scheduler::Clock::time_point& point)
+    {
+        typedef std::chrono::system_clock::duration WallDuration;
+        static const WallDuration offset =
+            std::chrono::system_clock::now().time_since_epoch()
+            - std::chrono::duration_cast<WallDuration>(
+                Scheduler::Clock::now().time_since_epoch());
+
+        return std::chrono::system_clock::time_point(offset
+            + std::chrono::duration_cast<WallDuration>(point.time_since_epoch()));
+    }
+
+}  // namespace
+
+std::chrono::system_clock::time_point Scheduler::TimeSource::WallTime(
+    const Clock::time_point& point) const
+{
+    return AnchoredWallTime(point);
+}
+
+Scheduler::Clock::time_point Scheduler::Now()
+{
+    TimeSource* source = s_timeSource.load(std::memory_order_acquire);
+    if (!source) return Clock::now();
+    return source->Now();
+}
+
+std::chrono::system_clock::time_point Scheduler::ToWallTime(
+    const Clock::time_point& point)
+{
+    TimeSource* source = s_timeSource.load(std::memory_order_acquire);
+    if (!source) return AnchoredWallTime(point);
+    return source->WallTime(point);
+}
+
+Scheduler::TimeSource* Scheduler::SetTimeSource(TimeSource* source)
+{
+    return s_timeSource.exchange(source, std::memory_order_acq_rel);
+}
+
+std::chrono::system_clock::time_point Scheduler::SimulatedClock::WallTime(
+    const Clock::time_point& point) const
+{
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            point.time_since_epoch()));
+}
+
+void Scheduler::SimulatedClock::Advance(const Clock::duration& step)
+{
+    if (step <= Clock::duration::zero()) return;
+    m_now.fetch_add(step.count(), std::memory_order_acq_rel);
+}
+
+void Scheduler::SimulatedClock::AdvanceTo(const Clock::time_point& point)
+{
+    Clock::rep target = point.time_since_epoch().count();
+    Clock::rep current = m_now.load(std::memory_order_acquire);
+    while (current < target
+        && !m_now.compare_exchange_weak(current, target, std::memory_order_acq_rel))
+    { }
+}
+
+Scheduler::CoarseClock::CoarseClock(const Clock::duration& precision)
+    : m_precision(std::max(precision, Clock::duration(1))),
+      m_now(Clock::now().time_since_epoch().count())
+{
+    m_thread = std::thread(&CoarseClock::Run, this);
+}
+
+Scheduler::CoarseClock::~CoarseClock()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void Scheduler::CoarseClock::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cond.wait_for(lock, m_precision, [this]{ return m_stop; }))
+    {
+        m_now.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+    }
+}
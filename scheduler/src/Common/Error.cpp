@@ -11,6 +11,7 @@ const char* Scheduler::ErrorToStr(Error e)
     if (e == E_CANCELLED) return "E_CANCELLED";
     if (e == E_COMPLETED) return "E_COMPLETED";
     if (e == E_INVALID_ARGUMENT) return "E_INVALID_ARGUMENT";
+    if (e == E_FULL) return "E_FULL";
     assert(!"Unknown error");
     return "<Unknown>";
 }
@@ -0,0 +1,118 @@
+#include <Scheduler/Lib/Admission.h>
+
+#include <algorithm>
+#include <assert.h>
+
+Scheduler::Lib::Admission::Admission(size_t capacity)
+    : m_capacity(capacity),
+      m_used(0),
+      m_shutdown(false),
+      m_waiters(0)
+{ }
+
+Scheduler::Error Scheduler::Lib::Admission::Acquire(
+    size_t count,
+    const Clock::duration& timeout)
+{
+    if (m_shutdown.load(std::memory_order_acquire)) return E_CANCELLED;
+    if (TryAcquire(count)) return E_SUCCESS;
+    if (timeout <= Clock::duration::zero()) return E_FULL;
+
+    // A request larger than the whole capacity could never be satisfied.
+    if (count > m_capacity) return E_FULL;
+
+    Clock::time_point now = Clock::now();
+    auto ready = [&]{
+        return m_shutdown.load(std::memory_order_acquire) || TryAcquire(count);
+    };
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Registering as a waiter before checking again means a release which
+    // comes in between either sees the waiter or frees the room first. A
+    // timeout too long to add to the clock, such as duration::max(), waits
+    // for as long as it takes.
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool admitted = true;
+    if (timeout >= Clock::time_point::max() - now) m_cond.wait(lock, ready);
+    else admitted = m_cond.wait_until(lock, now + timeout, ready);
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    // Room taken just as the scheduler shut down is never given back, which
+    // no longer matters by then.
+    if (m_shutdown.load(std::memory_order_acquire)) return E_CANCELLED;
+    return admitted ? E_SUCCESS : E_FULL;
+}
+
+void Scheduler::Lib::Admission::Force(size_t count)
+{
+    m_used.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Scheduler::Lib::Admission::Release(size_t count)
+{
+    if (count == 0) return;
+
+    size_t used = m_used.fetch_sub(count, std::memory_order_seq_cst);
+    assert(used >= count);
+    (void)used;
+
+    if (m_waiters.load(std::memory_order_seq_cst) == 0) return;
+
+    // Taking the lock orders the wakeup after a waiter which is between
+    // registering and going to sleep.
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_cond.notify_all();
+}
+
+void Scheduler::Lib::Admission::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown.store(true, std::memory_order_release);
+    }
+    m_cond.notify_all();
+}
+
+bool Scheduler::Lib::Admission::TryAcquire(size_t count)
+{
+    if (m_capacity == 0)
+    {
+        m_used.fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t used = m_used.load();
+    do
+    {
+        if (used + count > m_capacity) return false;
+    }
+    while (!m_used.compare_exchange_weak(used, used + count,
+        std::memory_order_relaxed));
+    return true;
+}
+
+size_t Scheduler::Lib::Admission::TryAcquire(const std::vector<size_t>& totals)
+{
+    if (totals.empty() || IsShutdown()) return 0;
+    if (m_capacity == 0)
+    {
+        m_used.fetch_add(totals.back(), std::memory_order_relaxed);
+        return totals.size();
+    }
+
+    size_t used = m_used.load();
+    size_t count = 0;
+    do
+    {
+        if (used >= m_capacity) return 0;
+
+        // Totals only ever grow so the longest run which fits is found by
+        // bisection.
+        count = std::upper_bound(totals.begin(), totals.end(),
+            m_capacity - used) - totals.begin();
+        if (count == 0) return 0;
+    }
+    while (!m_used.compare_exchange_weak(used, used + totals[count - 1],
+        std::memory_order_relaxed));
+    return count;
+}
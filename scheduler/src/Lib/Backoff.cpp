@@ -0,0 +1,78 @@
+#include <Scheduler/Lib/Backoff.h>
+
+#include <algorithm>
+#include <assert.h>
+
+Scheduler::Lib::Backoff::Backoff(
+    const Clock::duration& cap,
+    size_t budget,
+    const Clock::time_point& now)
+    : m_cap(std::max(cap, Clock::duration::zero())),
+      m_budget(budget),
+      m_tokens(static_cast<double>(budget)),
+      m_refilled(now)
+{
+    // Seeded from the time source rather than the steady clock so that a
+    // simulation draws the same delays every time it is run.
+    m_engine.seed(static_cast<std::default_random_engine::result_type>(
+        now.time_since_epoch().count()));
+}
+
+Scheduler::Clock::duration Scheduler::Lib::Backoff::Next(
+    const Clock::duration& interval,
+    const Clock::duration& previous)
+{
+    Clock::duration base = std::max(interval, Clock::duration::zero());
+
+    // A task asking for a longer interval than the cap still gets it.
+    Clock::duration cap = std::max(m_cap, base);
+    Clock::duration last = std::max(previous, base);
+    Clock::duration upper = last < cap / 3 ? last * 3 : cap;
+    if (upper <= base) return base;
+
+    std::uniform_int_distribution<Clock::rep> distribution(
+        base.count(),
+        upper.count());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Clock::duration(distribution(m_engine));
+}
+
+Scheduler::Error Scheduler::Lib::Backoff::Retry(
+    Task& task,
+    const Clock::time_point& now)
+{
+    assert(task.IsRetryable());
+
+    unsigned limit = task.GetRetryLimit();
+    if (limit != 0 && task.m_retries >= limit) return E_FULL;
+    if (!Take(now)) return E_FULL;
+
+    // The wait is never zero so the task is always premature until then.
+    Clock::duration delay = Next(task.GetRetryInterval(), task.m_retryDelay);
+    delay = std::max(delay, Clock::duration(1));
+
+    task.m_retryDelay = delay;
+    task.m_retries += 1;
+    task.SetAfterTime(now + delay);
+    return E_SUCCESS;
+}
+
+bool Scheduler::Lib::Backoff::Take(const Clock::time_point& now)
+{
+    if (m_budget == 0) return true;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (now > m_refilled)
+    {
+        double elapsed = std::chrono::duration<double>(now - m_refilled).count();
+        m_tokens = std::min(
+            m_tokens + elapsed * static_cast<double>(m_budget),
+            static_cast<double>(m_budget));
+        m_refilled = now;
+    }
+
+    if (m_tokens < 1.0) return false;
+    m_tokens -= 1.0;
+    return true;
+}
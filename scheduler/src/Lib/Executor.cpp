@@ -20,3 +20,16 @@ Scheduler::Error Scheduler::Lib::Executor::Create(
 }
 
 Scheduler::Lib::Executor::~Executor() { }
+
+void Scheduler::Lib::Executor::GetStats(ExecutorStats& stats) const
+{
+    std::vector<ExecutorStats> workers;
+    GetWorkerStats(workers);
+    for (const ExecutorStats& worker : workers) stats.Merge(worker);
+}
+
+void Scheduler::Lib::Executor::GetWorkerStats(
+    std::vector<ExecutorStats>& stats) const
+{
+    stats.clear();
+}
@@ -0,0 +1,135 @@
+#include <Scheduler/Lib/Histogram.h>
+
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+namespace {
+
+    inline unsigned HighestBit(uint64_t value)
+    {
+        assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned bit = 0;
+        while (value >>= 1) ++bit;
+        return bit;
+#endif
+    }
+
+}  // namespace
+
+const unsigned Scheduler::Lib::HistogramBuckets::SUB_BITS;
+const unsigned Scheduler::Lib::HistogramBuckets::SUB_BUCKETS;
+const unsigned Scheduler::Lib::HistogramBuckets::MAX_BITS;
+const size_t Scheduler::Lib::HistogramBuckets::COUNT;
+
+size_t Scheduler::Lib::HistogramBuckets::Index(uint64_t ticks)
+{
+    // Values below two sub-bucket ranges map one to one. Above that the
+    // highest bit picks the power of two and the next SUB_BITS bits the
+    // linear bucket within it.
+    if (ticks < 2 * SUB_BUCKETS) return static_cast<size_t>(ticks);
+
+    unsigned bit = HighestBit(ticks);
+    if (bit >= MAX_BITS) return COUNT - 1;
+
+    uint64_t mantissa = ticks >> (bit - SUB_BITS);
+    return static_cast<size_t>((bit - SUB_BITS) * SUB_BUCKETS + mantissa);
+}
+
+uint64_t Scheduler::Lib::HistogramBuckets::Highest(size_t index)
+{
+    if (index < 2 * SUB_BUCKETS) return index;
+
+    unsigned bit = static_cast<unsigned>(index / SUB_BUCKETS) + SUB_BITS - 1;
+    uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+    unsigned shift = bit - SUB_BITS;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+Scheduler::Clock::duration Scheduler::Lib::HistogramSnapshot::GetMean() const
+{
+    if (m_count == 0) return Clock::duration::zero();
+    return Clock::duration(static_cast<Clock::rep>(m_sum / m_count));
+}
+
+Scheduler::Clock::duration Scheduler::Lib::HistogramSnapshot::Percentile(
+    double percentile) const
+{
+    if (m_count == 0) return Clock::duration::zero();
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(
+        std::ceil(percentile / 100.0 * static_cast<double>(m_count)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    // Report the top of the bucket the rank falls in, but never beyond the
+    // range of what was actually recorded.
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i)
+    {
+        seen += m_counts[i];
+        if (seen < rank) continue;
+
+        uint64_t value = std::min(HistogramBuckets::Highest(i), m_max);
+        return Clock::duration(static_cast<Clock::rep>(std::max(value, m_min)));
+    }
+    return GetMax();
+}
+
+void Scheduler::Lib::HistogramSnapshot::Merge(const HistogramSnapshot& other)
+{
+    if (other.m_count == 0) return;
+
+    if (m_counts.empty()) m_counts.assign(HistogramBuckets::COUNT, 0);
+    for (size_t i = 0; i < other.m_counts.size(); ++i)
+        m_counts[i] += other.m_counts[i];
+
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+Scheduler::Lib::Histogram::Histogram()
+{
+    for (std::atomic<uint64_t>& count : m_counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void Scheduler::Lib::Histogram::Read(HistogramSnapshot& snapshot) const
+{
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    if (count == 0) return;
+
+    if (snapshot.m_counts.empty())
+        snapshot.m_counts.assign(HistogramBuckets::COUNT, 0);
+    for (size_t i = 0; i < m_counts.size(); ++i)
+        snapshot.m_counts[i] += m_counts[i].load(std::memory_order_relaxed);
+
+    snapshot.m_count += count;
+    snapshot.m_sum += m_sum.load(std::memory_order_relaxed);
+    snapshot.m_min = std::min(snapshot.m_min, m_min.load(std::memory_order_relaxed));
+    snapshot.m_max = std::max(snapshot.m_max, m_max.load(std::memory_order_relaxed));
+}
+
+void Scheduler::Lib::Histogram::Record(const Clock::duration& duration)
+{
+    uint64_t ticks = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+
+    m_counts[HistogramBuckets::Index(ticks)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ticks, std::memory_order_relaxed);
+
+    uint64_t min = m_min.load(std::memory_order_relaxed);
+    while (ticks < min
+        && !m_min.compare_exchange_weak(min, ticks, std::memory_order_relaxed))
+    { }
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (ticks > max
+        && !m_max.compare_exchange_weak(max, ticks, std::memory_order_relaxed))
+    { }
+}
@@ -0,0 +1,29 @@
+#include <Scheduler/Lib/ParkingLot.h>
+
+const unsigned Scheduler::Lib::ParkingLot::STRIPE_BITS;
+const size_t Scheduler::Lib::ParkingLot::STRIPES;
+
+void Scheduler::Lib::ParkingLot::NotifyAll(const void* address)
+{
+    Stripe& stripe = GetStripe(address);
+    if (stripe.waiters.load() == 0) return;
+
+    // Taking the lock orders the notify after any waiter which has counted
+    // itself but not yet gone to sleep.
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+    }
+    stripe.cond.notify_all();
+}
+
+Scheduler::Lib::ParkingLot::Stripe& Scheduler::Lib::ParkingLot::GetStripe(
+    const void* address)
+{
+    static Stripe stripes[STRIPES];
+
+    // Objects are at least a cache line apart more often than not, so the
+    // low bits carry little. Fibonacci hashing spreads the rest.
+    uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(address)) >> 6;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return stripes[key >> (64 - STRIPE_BITS)];
+}
@@ -0,0 +1,297 @@
+#include <Scheduler/Lib/Recurrence.h>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+    const int64_t SECONDS_PER_DAY = 86400;
+
+    // Stop looking for a cron match this many years out. Long enough for the
+    // 29th of February to come around again across a skipped leap year.
+    const int64_t MATCH_HORIZON_YEARS = 9;
+
+    // Most missed cron matches counted between two runs, so a task which
+    // slept for a long time does not walk every minute since.
+    const unsigned MISSED_MATCH_LIMIT = 1024;
+
+    int64_t FloorDiv(int64_t value, int64_t divisor)
+    {
+        int64_t quotient = value / divisor;
+        if ((value % divisor != 0) && ((value < 0) != (divisor < 0))) --quotient;
+        return quotient;
+    }
+
+    // Days since the Unix epoch of a proleptic Gregorian date.
+    int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+    {
+        year -= month <= 2;
+        const int64_t era = FloorDiv(year, 400);
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day)
+    {
+        days += 719468;
+        const int64_t era = FloorDiv(days, 146097);
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+    }
+
+    bool ParseNumber(const std::string& text, int& value)
+    {
+        if (text.empty() || text.size() > 4) return false;
+        value = 0;
+        for (char c : text)
+        {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    std::vector<std::string> Split(const std::string& text, char separator)
+    {
+        std::vector<std::string> parts;
+        std::string part;
+        std::istringstream stream(text);
+        while (std::getline(stream, part, separator)) parts.emplace_back(part);
+        if (!text.empty() && text.back() == separator) parts.emplace_back();
+        return parts;
+    }
+
+    // Parse one cron field into a bit set of the values it matches, offset
+    // so that the lowest allowed value is bit zero.
+    bool ParseField(const std::string& field, int low, int high, uint64_t& bits)
+    {
+        bits = 0;
+        for (const std::string& item : Split(field, ','))
+        {
+            std::vector<std::string> stepped = Split(item, '/');
+            if (stepped.empty() || stepped.size() > 2) return false;
+
+            int step = 1;
+            if (stepped.size() == 2 && (!ParseNumber(stepped[1], step) || step == 0))
+                return false;
+
+            int first = low, last = high;
+            const std::string& range = stepped[0];
+            if (range != "*")
+            {
+                std::vector<std::string> bounds = Split(range, '-');
+                if (bounds.empty() || bounds.size() > 2) return false;
+                if (!ParseNumber(bounds[0], first)) return false;
+                if (bounds.size() == 2)
+                {
+                    if (!ParseNumber(bounds[1], last)) return false;
+                }
+                else if (stepped.size() == 1)
+                {
+                    last = first;
+                }
+            }
+
+            if (first < low || last > high || first > last) return false;
+            for (int value = first; value <= last; value += step)
+                bits |= uint64_t(1) << (value - low);
+        }
+        return bits != 0;
+    }
+
+}  // namespace
+
+Scheduler::Lib::Recurrence Scheduler::Lib::Recurrence::FixedRate(
+    const Clock::duration& period)
+{
+    Recurrence recurrence;
+    recurrence.m_kind = Kind::FIXED_RATE;
+    recurrence.m_period = period;
+    recurrence.m_valid = period > Clock::duration::zero();
+    return recurrence;
+}
+
+Scheduler::Lib::Recurrence Scheduler::Lib::Recurrence::FixedDelay(
+    const Clock::duration& delay)
+{
+    Recurrence recurrence;
+    recurrence.m_kind = Kind::FIXED_DELAY;
+    recurrence.m_period = delay;
+    recurrence.m_valid = delay >= Clock::duration::zero();
+    return recurrence;
+}
+
+Scheduler::Lib::Recurrence Scheduler::Lib::Recurrence::Cron(
+    const std::string& expression)
+{
+    Recurrence recurrence;
+    recurrence.m_kind = Kind::CRON;
+    recurrence.m_valid = recurrence.Parse(expression);
+    return recurrence;
+}
+
+bool Scheduler::Lib::Recurrence::Parse(const std::string& expression)
+{
+    std::string text = expression;
+    if (text == "@yearly" || text == "@annually") text = "0 0 1 1 *";
+    else if (text == "@monthly") text = "0 0 1 * *";
+    else if (text == "@weekly") text = "0 0 * * 0";
+    else if (text == "@daily" || text == "@midnight") text = "0 0 * * *";
+    else if (text == "@hourly") text = "0 * * * *";
+
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream stream(text);
+    while (stream >> field) fields.emplace_back(field);
+    if (fields.size() != 5) return false;
+
+    uint64_t minutes, hours, days, months, weekdays;
+    if (!ParseField(fields[0], 0, 59, minutes)) return false;
+    if (!ParseField(fields[1], 0, 23, hours)) return false;
+    if (!ParseField(fields[2], 1, 31, days)) return false;
+    if (!ParseField(fields[3], 1, 12, months)) return false;
+    if (!ParseField(fields[4], 0, 7, weekdays)) return false;
+
+    // Sunday may be written as either 0 or 7.
+    if (weekdays & (uint64_t(1) << 7)) weekdays |= 1;
+
+    m_minutes = minutes;
+    m_hours = static_cast<uint32_t>(hours);
+    m_days = static_cast<uint32_t>(days);
+    m_months = static_cast<uint16_t>(months);
+    m_weekdays = static_cast<uint8_t>(weekdays & 0x7F);
+    m_anyDay = fields[2][0] == '*';
+    m_anyWeekday = fields[4][0] == '*';
+    return true;
+}
+
+Scheduler::Clock::time_point Scheduler::Lib::Recurrence::Next(
+    const Clock::time_point& due,
+    const Clock::time_point& now,
+    unsigned& missed) const
+{
+    if (!m_valid) return Clock::time_point::max();
+
+    switch (m_kind)
+    {
+    case Kind::NONE:
+        return Clock::time_point::max();
+
+    case Kind::FIXED_DELAY:
+        return now + m_period;
+
+    case Kind::FIXED_RATE:
+    {
+        // Keep to the grid: the next tick is the first one at or after now,
+        // and every tick before it was missed.
+        Clock::rep ticks = 1;
+        if (now > due)
+        {
+            Clock::rep elapsed = (now - due).count();
+            ticks = std::max<Clock::rep>(
+                (elapsed + m_period.count() - 1) / m_period.count(),
+                1);
+        }
+        missed += static_cast<unsigned>(ticks - 1);
+        return due + m_period * ticks;
+    }
+
+    case Kind::CRON:
+    {
+        // Cron matches wall-clock time, while the scheduler runs on its time
+        // source. Map between them through the source.
+        std::chrono::system_clock::time_point wallNow = ToWallTime(now);
+        std::chrono::system_clock::time_point wallDue =
+            now > due ? ToWallTime(due) : wallNow;
+
+        std::chrono::system_clock::time_point match = NextMatch(wallDue);
+        for (unsigned count = 0;
+             match <= wallNow && count < MISSED_MATCH_LIMIT;
+             ++count)
+        {
+            missed += 1;
+            match = NextMatch(match);
+        }
+        if (match <= wallNow) match = NextMatch(wallNow);
+        if (match == std::chrono::system_clock::time_point::max())
+            return Clock::time_point::max();
+
+        return now + std::chrono::duration_cast<Clock::duration>(match - wallNow);
+    }
+    }
+    return Clock::time_point::max();
+}
+
+std::chrono::system_clock::time_point Scheduler::Lib::Recurrence::NextMatch(
+    const std::chrono::system_clock::time_point& after) const
+{
+    typedef std::chrono::system_clock::time_point WallPoint;
+    if (m_kind != Kind::CRON || !m_valid) return WallPoint::max();
+
+    // Start from the first whole minute after the given time.
+    int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        after.time_since_epoch()).count();
+    if (WallPoint(std::chrono::seconds(seconds)) > after) --seconds;
+    seconds = FloorDiv(seconds, 60) * 60 + 60;
+
+    int64_t year;
+    unsigned month, day;
+    CivilFromDays(FloorDiv(seconds, SECONDS_PER_DAY), year, month, day);
+    const int64_t horizon = year + MATCH_HORIZON_YEARS;
+
+    // Skip whole months, days and hours which cannot match before looking
+    // at single minutes.
+    for (;;)
+    {
+        int64_t days = FloorDiv(seconds, SECONDS_PER_DAY);
+        CivilFromDays(days, year, month, day);
+        if (year > horizon) return WallPoint::max();
+
+        if (!(m_months & (1U << (month - 1))))
+        {
+            seconds = (month == 12
+                ? DaysFromCivil(year + 1, 1, 1)
+                : DaysFromCivil(year, month + 1, 1)) * SECONDS_PER_DAY;
+            continue;
+        }
+
+        // The epoch fell on a Thursday.
+        unsigned weekday = static_cast<unsigned>(((days + 4) % 7 + 7) % 7);
+        bool dayMatch = (m_days & (1U << (day - 1))) != 0;
+        bool weekdayMatch = (m_weekdays & (1U << weekday)) != 0;
+        bool matches = m_anyDay || m_anyWeekday
+            ? dayMatch && weekdayMatch
+            : dayMatch || weekdayMatch;
+        if (!matches)
+        {
+            seconds = (days + 1) * SECONDS_PER_DAY;
+            continue;
+        }
+
+        int64_t second = seconds - days * SECONDS_PER_DAY;
+        unsigned hour = static_cast<unsigned>(second / 3600);
+        if (!(m_hours & (1U << hour)))
+        {
+            seconds = days * SECONDS_PER_DAY + (hour + 1) * 3600;
+            continue;
+        }
+
+        unsigned minute = static_cast<unsigned>((second % 3600) / 60);
+        if (!(m_minutes & (uint64_t(1) << minute)))
+        {
+            seconds += 60;
+            continue;
+        }
+
+        return WallPoint(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::seconds(seconds)));
+    }
+}
@@ -1,12 +1,21 @@
 #include <Scheduler/Lib/Scheduler.h>
 
 #include <Scheduler/Common/Console.h>
+#include <Scheduler/Lib/Admission.h>
+#include <Scheduler/Lib/Backoff.h>
+#include <Scheduler/Lib/DecentralizedTaskScheduler.h>
+#include <Scheduler/Lib/ShardedTaskScheduler.h>
 #include <Scheduler/Lib/StandardTaskScheduler.h>
 #include <Scheduler/Lib/TaskRunner.h>
 
 #include <iostream>
 #include <assert.h>
 
+void Scheduler::Lib::ScheduleReporter::ReportIntake(
+    size_t count,
+    const Clock::duration& elapsed)
+{ }
+
 void Scheduler::Lib::ScheduleReporter::Shutdown(bool wait)
 { }
 
@@ -25,7 +34,8 @@ Scheduler::Error Scheduler::Lib::TaskScheduler::Create(
     }
     else
     {
-        const ExecutorParams& exeParams = params.executorParams;
+        ExecutorParams exeParams = params.executorParams;
+        exeParams.dispatchPolicy = params.dispatchPolicy;
         if ((error = Executor::Create(exeParams, executor)) != E_SUCCESS)
             return error;
     }
@@ -44,13 +54,134 @@ Scheduler::Error Scheduler::Lib::TaskScheduler::Create(
         reporter = params.reporter->shared_from_this();
     }
 
+    // Every shard of a sharded scheduler draws on the same capacity and
+    // the same retry budget.
+    AdmissionPtr admission = std::make_shared<Admission>(params.capacity);
+    BackoffPtr backoff = std::make_shared<Backoff>(
+        params.maxRetryDelay,
+        params.retryBudget);
+
+    if (params.mode == SchedulingMode::DECENTRALIZED)
+    {
+        std::shared_ptr<DecentralizedTaskScheduler> impl(
+            new DecentralizedTaskScheduler(params,
+                std::move(reporter),
+                std::move(manager),
+                std::move(executor),
+                std::move(admission),
+                std::move(backoff)));
+        if ((error = impl->Initialize()) != E_SUCCESS) return error;
+
+        scheduler = std::move(impl);
+        return E_SUCCESS;
+    }
+    if (params.shards > 1)
+    {
+        std::shared_ptr<ShardedTaskScheduler> impl(
+            new ShardedTaskScheduler(params,
+                std::move(reporter),
+                std::move(manager),
+                std::move(executor),
+                std::move(admission),
+                std::move(backoff)));
+        if ((error = impl->Initialize()) != E_SUCCESS) return error;
+
+        scheduler = std::move(impl);
+        return E_SUCCESS;
+    }
+
     std::shared_ptr<StandardTaskScheduler> impl(
         new StandardTaskScheduler(params,
             std::move(reporter),
             std::move(manager),
-            std::move(executor)));
+            std::move(executor),
+            std::move(admission),
+            std::move(backoff)));
     if ((error = impl->Initialize()) != E_SUCCESS) return error;
 
     scheduler = std::move(impl);
     return E_SUCCESS;
 }
+
+Scheduler::Error Scheduler::Lib::TaskScheduler::Cancel(Task* task)
+{
+    // The chain goes first so it is cancelled itself rather than failed by
+    // one of its children.
+    Error error = Cancel(task->Id());
+
+    Chain* chain = dynamic_cast<Chain*>(task);
+    if (chain)
+    {
+        for (const TaskPtr& child : static_cast<const Chain*>(chain)->GetChildren())
+            Cancel(child.get());
+    }
+    return error;
+}
+
+bool Scheduler::Lib::TaskScheduler::AppendToBatch(
+    const TaskPtr& task,
+    std::vector<TaskPtr>& batch)
+{
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return false;
+    }
+
+    // Chains bring their children along with them, ahead of the chain.
+    const Chain* chain = dynamic_cast<const Chain*>(task.get());
+    if (chain)
+    {
+        const std::vector<TaskPtr>& children = chain->GetChildren();
+        batch.insert(batch.end(), children.begin(), children.end());
+    }
+    batch.emplace_back(task);
+    return true;
+}
+
+void Scheduler::Lib::TaskScheduler::Enqueue(const std::vector<TaskPtr>& tasks)
+{
+    std::vector<TaskPtr> batch;
+    batch.reserve(tasks.size());
+    for (const TaskPtr& task : tasks) AppendToBatch(task, batch);
+    if (batch.empty()) return;
+
+    GetAdmission().Force(batch.size());
+    EnqueueBatch(std::move(batch));
+}
+
+Scheduler::Error Scheduler::Lib::TaskScheduler::TryEnqueue(
+    const std::vector<TaskPtr>& tasks,
+    size_t& admitted)
+{
+    Error error = E_SUCCESS;
+    admitted = 0;
+
+    // Running total of the batch size after each task so the run which
+    // fits can be admitted in one go.
+    std::vector<TaskPtr> batch;
+    std::vector<size_t> totals;
+    batch.reserve(tasks.size());
+    totals.reserve(tasks.size());
+    for (const TaskPtr& task : tasks)
+    {
+        if (!AppendToBatch(task, batch))
+        {
+            error = E_INVALID_ARGUMENT;
+            break;
+        }
+        totals.emplace_back(batch.size());
+    }
+
+    Admission& admission = GetAdmission();
+    size_t count = admission.TryAcquire(totals);
+    if (count < totals.size())
+        error = admission.IsShutdown() ? E_CANCELLED : E_FULL;
+    if (count == 0) return error;
+
+    batch.resize(totals[count - 1]);
+    EnqueueBatch(std::move(batch));
+    admitted = count;
+    return error;
+}
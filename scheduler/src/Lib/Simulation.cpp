@@ -0,0 +1,92 @@
+#include <Scheduler/Lib/Simulation.h>
+
+#include <Scheduler/Lib/DeterministicExecutor.h>
+#include <Scheduler/Lib/StandardTaskScheduler.h>
+
+#include <algorithm>
+
+Scheduler::Lib::Simulation::Simulation(const Clock::time_point& start)
+    : m_clock(start)
+{ }
+
+Scheduler::Lib::Simulation::~Simulation()
+{
+    if (m_scheduler) m_scheduler->Shutdown(true);
+    m_scheduler.reset();
+    m_loop.reset();
+    m_executor.reset();
+
+    if (m_installed) SetTimeSource(nullptr);
+}
+
+Scheduler::Error Scheduler::Lib::Simulation::Create(
+    const SchedulerParams& params,
+    SimulationPtr& simulation,
+    const Clock::time_point& start)
+{
+    SimulationPtr impl(new Simulation(start));
+
+    // The clock goes in before anything reads the time, so timers and
+    // tasks are created on simulated time from the start.
+    TimeSource* previous = SetTimeSource(&impl->m_clock);
+    if (previous)
+    {
+        SetTimeSource(previous);
+        return E_FULL;
+    }
+    impl->m_installed = true;
+
+    ExecutorParams exeParams = params.executorParams;
+    exeParams.dispatchPolicy = params.dispatchPolicy;
+    impl->m_executor = std::make_shared<DeterministicExecutor>(exeParams);
+
+    SchedulerParams loopParams = params;
+    loopParams.executor = impl->m_executor.get();
+    loopParams.mode = SchedulingMode::CENTRALIZED;
+    loopParams.shards = 1;
+
+    Error error = TaskScheduler::Create(loopParams, impl->m_scheduler);
+    if (error != E_SUCCESS) return error;
+    impl->m_loop = std::static_pointer_cast<StandardTaskScheduler>(
+        impl->m_scheduler);
+
+    simulation = std::move(impl);
+    return E_SUCCESS;
+}
+
+size_t Scheduler::Lib::Simulation::RunUntilIdle()
+{
+    // Timing is on the steady clock, as it measures the real cost of the
+    // scheduler and of the tasks rather than simulated time.
+    size_t count = 0;
+    for (;;)
+    {
+        Clock::time_point start = Clock::now();
+        while (m_loop->Step());
+        Clock::time_point stepped = Clock::now();
+        size_t ran = m_executor->RunPending();
+        m_schedulerTime += stepped - start;
+        m_executionTime += Clock::now() - stepped;
+
+        if (ran == 0) return count;
+        count += ran;
+    }
+}
+
+size_t Scheduler::Lib::Simulation::RunUntil(const Clock::time_point& point)
+{
+    size_t count = RunUntilIdle();
+    for (;;)
+    {
+        Clock::time_point next = m_loop->NextExpiry();
+        if (next > point) break;
+
+        // A timer which comes due without settling anything, such as a
+        // deadline reached on the very instant, needs time to move on.
+        m_clock.AdvanceTo(std::max(next, Now() + Clock::duration(1)));
+        count += RunUntilIdle();
+    }
+
+    m_clock.AdvanceTo(point);
+    return count + RunUntilIdle();
+}
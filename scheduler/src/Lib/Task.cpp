@@ -1,9 +1,158 @@
 #include <Scheduler/Lib/Task.h>
 
+#include <Scheduler/Lib/ParkingLot.h>
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <sstream>
+#include <vector>
 #include <assert.h>
 
+namespace {
+
+    // Dependencies let go of by the tasks being destroyed on this thread.
+    // Only the outermost destructor releases them, one at a time, so that
+    // destroying a long line of tasks does not recurse once per task.
+    thread_local std::vector<Scheduler::Lib::TaskPtr>* t_released = nullptr;
+
+    bool IsFinal(Scheduler::Lib::TaskState state)
+    {
+        using Scheduler::Lib::TaskState;
+        return state == TaskState::CANCELLED || state == TaskState::FAILED
+            || state == TaskState::SUCCESS;
+    }
+
+}  // namespace
+
+// Tasks joined by an edge share a graph, whose lock guards their links.
+// Wiring tasks from separate graphs merges them, so producers building
+// unrelated graphs never contend. A graph is not split again when edges go
+// away with their tasks, which only means it is locked more widely.
+struct Scheduler::Lib::Task::Graph
+{
+    std::mutex mutex;
+    // Tasks moved into the graph, so the smaller of two is merged into the
+    // larger one.
+    size_t size = 1;
+    // Stamp of the latest search and the stack it works through.
+    uint64_t epoch = 0;
+    std::vector<const Task*> stack;
+};
+
+// Dependents are not owned: each one unlinks itself from its dependencies
+// when destroyed. The height is one more than the highest dependency, so a
+// task can only reach tasks lower than it, unless it is tangled: on or
+// above a circular dependency, which Depends records but which has no
+// meaningful height. Searches stamp the tasks they visit with the epoch of
+// the graph. Everything but the dependencies, which the scheduler reads once
+// the task is queued, is guarded by the lock of the graph.
+struct Scheduler::Lib::Task::Links
+{
+    // Only moved to another graph with the lock of both held, and read with
+    // atomic loads until the lock of the graph is taken.
+    std::shared_ptr<Graph> graph = std::make_shared<Graph>();
+    std::vector<TaskPtr> dependencies;
+    std::vector<Task*> dependents;
+    uint64_t visited = 0;
+    unsigned height = 0;
+    bool tangled = false;
+};
+
+class Scheduler::Lib::Task::GraphLock
+{
+    GraphLock(const GraphLock&) = delete;
+    GraphLock& operator=(const GraphLock&) = delete;
+
+public:
+    /// Lock the graph of the task with the given links.
+    explicit GraphLock(Links& links)
+    {
+        for (;;)
+        {
+            m_graph = std::atomic_load(&links.graph);
+            m_lock = std::unique_lock<std::mutex>(m_graph->mutex);
+            if (std::atomic_load(&links.graph) == m_graph) return;
+            m_lock.unlock();
+        }
+    }
+
+    /// Lock the graph of both tasks, merging them first if they differ.
+    GraphLock(Links& links, Links& other)
+    {
+        for (;;)
+        {
+            std::shared_ptr<Graph> first = std::atomic_load(&links.graph);
+            std::shared_ptr<Graph> second = std::atomic_load(&other.graph);
+            std::unique_lock<std::mutex> lock(first->mutex, std::defer_lock);
+            std::unique_lock<std::mutex> merged;
+            if (first == second)
+            {
+                lock.lock();
+            }
+            else
+            {
+                merged = std::unique_lock<std::mutex>(second->mutex, std::defer_lock);
+                std::lock(lock, merged);
+            }
+
+            // Either task may have moved while the locks were taken.
+            if (std::atomic_load(&links.graph) != first
+                || std::atomic_load(&other.graph) != second)
+            {
+                continue;
+            }
+
+            if (first != second)
+            {
+                Links* moving = &other;
+                if (first->size < second->size)
+                {
+                    std::swap(first, second);
+                    std::swap(lock, merged);
+                    moving = &links;
+                }
+                Merge(*moving, first, *second);
+            }
+
+            m_graph = std::move(first);
+            m_lock = std::move(lock);
+            return;
+        }
+    }
+
+    Graph& Get() const { return *m_graph; }
+
+private:
+    /// Move the tasks connected to the given links from one graph into the
+    /// other. Called with the lock of both held.
+    static void Merge(Links& links, const std::shared_ptr<Graph>& to, Graph& from)
+    {
+        std::vector<Links*> pending(1, &links);
+        while (!pending.empty())
+        {
+            Links* current = pending.back();
+            pending.pop_back();
+            if (current->graph == to) continue;
+
+            std::atomic_store(&current->graph, to);
+            to->size += 1;
+            for (const TaskPtr& task : current->dependencies)
+                pending.push_back(&task->GetLinks());
+            for (Task* task : current->dependents)
+                pending.push_back(&task->GetLinks());
+        }
+
+        // Stamps left by searches of the old graph must not look like ones
+        // made by searches of the new one.
+        to->epoch = std::max(to->epoch, from.epoch);
+    }
+
+    // Released after the lock, which lives in the graph.
+    std::shared_ptr<Graph> m_graph;
+    std::unique_lock<std::mutex> m_lock;
+};
+
 const char* Scheduler::Lib::TaskStateToStr(TaskState state)
 {
     if (state == TaskState::ACTIVE) return "ACTIVE";
@@ -36,25 +185,94 @@ std::ostream& Scheduler::Lib::operator<<(std::ostream& o, TaskResult result)
     return o << TaskResultToStr(result);
 }
 
+const char* Scheduler::Lib::TaskPriorityToStr(TaskPriority priority)
+{
+    if (priority == TaskPriority::LOW) return "LOW";
+    if (priority == TaskPriority::NORMAL) return "NORMAL";
+    if (priority == TaskPriority::HIGH) return "HIGH";
+    if (priority == TaskPriority::CRITICAL) return "CRITICAL";
+    assert(!"Unknown task priority");
+    return "<Unknown TaskPriority>";
+}
+
+std::ostream& Scheduler::Lib::operator<<(std::ostream& o, TaskPriority priority)
+{
+    return o << TaskPriorityToStr(priority);
+}
+
 Scheduler::Lib::Task::Task()
-    : m_id(true),
-      m_state(TaskState::NEW),
-      m_createdOn(Clock::now()),
+    : m_state(TaskState::NEW),
       m_before(Clock::time_point::max()),
-      m_after(Clock::time_point::max())
+      m_after(Clock::time_point::max()),
+      m_id(true)
 { }
 
 Scheduler::Lib::Task::Task(
     const Clock::time_point& before,
     const Clock::time_point& after)
-    : m_id(true),
-      m_state(TaskState::NEW),
-      m_createdOn(Clock::now()),
+    : m_state(TaskState::NEW),
       m_before(before),
-      m_after(after)
+      m_after(after),
+      m_id(true)
 { }
 
-Scheduler::Lib::Task::~Task() { }
+Scheduler::Lib::Task::~Task()
+{
+    // Every dependent holds a reference to this task, so all of them have
+    // unlinked themselves by now, and a task without dependencies has no
+    // edges left to take the lock for. The dependencies are released once
+    // the lock is dropped, since releasing one may destroy it.
+    std::unique_ptr<Links> links(m_links.load(std::memory_order_acquire));
+    if (!links) return;
+    assert(links->dependents.empty());
+    if (links->dependencies.empty()) return;
+
+    std::vector<TaskPtr> dependencies;
+    {
+        GraphLock lock(*links);
+        for (const TaskPtr& task : links->dependencies)
+        {
+            std::vector<Task*>& dependents = task->GetLinks().dependents;
+            dependents.erase(std::find(dependents.begin(), dependents.end(), this));
+        }
+        dependencies.swap(links->dependencies);
+    }
+    links.reset();
+
+    if (t_released)
+    {
+        std::move(dependencies.begin(), dependencies.end(), std::back_inserter(*t_released));
+        return;
+    }
+
+    t_released = &dependencies;
+    while (!dependencies.empty())
+    {
+        TaskPtr task = std::move(dependencies.back());
+        dependencies.pop_back();
+        task.reset();
+    }
+    t_released = nullptr;
+}
+
+Scheduler::Lib::Task::Links& Scheduler::Lib::Task::Attach()
+{
+    Links* links = m_links.load(std::memory_order_acquire);
+    if (links) return *links;
+
+    // Another thread may wire onto the task at the same time.
+    std::unique_ptr<Links> created(new Links());
+    if (m_links.compare_exchange_strong(links, created.get(), std::memory_order_acq_rel))
+        return *created.release();
+    return *links;
+}
+
+Scheduler::Lib::Task::Links& Scheduler::Lib::Task::GetLinks() const
+{
+    Links* links = m_links.load(std::memory_order_acquire);
+    assert(links != nullptr);
+    return *links;
+}
 
 Scheduler::Lib::Task* Scheduler::Lib::Task::Depends(Task* task)
 {
@@ -66,122 +284,295 @@ Scheduler::Lib::Task* Scheduler::Lib::Task::Depends(Task* task)
     // that the Requires() call comes back true for everything.
     if (IsComplete() || IsActive()) return this;
 
-     // Early check in case the task ID is already linked as a dependency
-     // this is to prevent duplicates being added.
-    if (Requires(task->Id())) return this;
+    Links& links = Attach();
+    Links& other = task->Attach();
+    GraphLock lock(links, other);
 
-    // Prevent circular dependencies by invalidating this task if
-    // a dependency is added which requires it.
-    if (task->Requires(Id())) m_valid = false;
+    // Early check in case the task is already required, directly or through
+    // another dependency, this is to prevent duplicates being added.
+    if (Reaches(task, lock.Get())) return this;
 
-    std::shared_ptr<Task> that = task->shared_from_this();
-    m_dependencies.emplace_back(std::move(that));
+    // Prevent circular dependencies by invalidating this task if a
+    // dependency is added which requires it.
+    bool circular = task == this || task->Reaches(this, lock.Get());
+    if (circular) m_valid = false;
+
+    links.dependencies.emplace_back(task->shared_from_this());
+    other.dependents.push_back(this);
+    if (circular || other.tangled) Tangle();
+    else Raise(other.height + 1);
+    if (!m_valid || !task->IsValid()) Invalidate();
     return this;
 }
 
 void Scheduler::Lib::Task::Fail()
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    if (IsComplete()) return;
-
-    SetStateLocked(TaskState::FAILED, lock);
-
-    lock.unlock();
-    m_cond.notify_all();
-    // We should probably have some way of notifying every task
-    // which depends on this one that it has failed.
+    if (Transition(TaskState::FAILED)) ParkingLot::NotifyAll(this);
+    // Tasks depending on this one are failed by the scheduler, which holds
+    // the reverse dependency index.
 }
 
 bool Scheduler::Lib::Task::IsActive() const
 {
-    return m_state == TaskState::ACTIVE;
+    return m_state.load(std::memory_order_acquire) == TaskState::ACTIVE;
 }
 
 bool Scheduler::Lib::Task::IsComplete() const
 {
-    return m_state == TaskState::CANCELLED || m_state == TaskState::FAILED
-        || m_state == TaskState::SUCCESS;
+    return IsFinal(m_state.load(std::memory_order_acquire));
 }
 
-bool Scheduler::Lib::Task::IsExpired() const
+const std::vector<Scheduler::Lib::TaskPtr>& Scheduler::Lib::Task::GetDependencies() const
 {
-    if (m_before != Clock::time_point::max())
-        return Clock::now() > m_before;
-    return false;
+    static const std::vector<TaskPtr> none;
+    Links* links = m_links.load(std::memory_order_acquire);
+    return links ? links->dependencies : none;
 }
 
-bool Scheduler::Lib::Task::IsValid() const
+bool Scheduler::Lib::Task::HasDependencies() const
 {
-    if (!m_valid) return false;
-    for (const TaskPtr& task : m_dependencies)
-    {
-        if (!task->IsValid()) return false;
-    }
-    return true;
+    Links* links = m_links.load(std::memory_order_acquire);
+    return links && !links->dependencies.empty();
 }
 
 bool Scheduler::Lib::Task::Requires(const Task* task) const
 {
     if (!task) return false;
-    return Requires(Id(), Id(), task->Id());
+
+    // Tasks without edges require nothing and nothing requires them.
+    Links* links = m_links.load(std::memory_order_acquire);
+    Links* other = task->m_links.load(std::memory_order_acquire);
+    if (!links || !other) return false;
+
+    // A task in another graph cannot be joined to this one while its lock
+    // is held, so it is not required.
+    GraphLock lock(*links);
+    if (std::atomic_load(&other->graph).get() != &lock.Get()) return false;
+    return Reaches(task, lock.Get());
 }
 
 bool Scheduler::Lib::Task::Requires(const TaskPtr& task) const
 {
-    return Requires(Id(), Id(), task->Id());
+    return Requires(task.get());
 }
 
 bool Scheduler::Lib::Task::Requires(const UUID& id) const
 {
-    return Requires(Id(), Id(), id);
+    Links* links = m_links.load(std::memory_order_acquire);
+    if (!links) return false;
+
+    GraphLock lock(*links);
+    Graph& graph = lock.Get();
+    uint64_t epoch = ++graph.epoch;
+
+    // Without the task itself there is no height to prune by, so this walks
+    // everything below the task once.
+    std::vector<const Task*>& stack = graph.stack;
+    stack.clear();
+    stack.push_back(this);
+    while (!stack.empty())
+    {
+        const Task* current = stack.back();
+        stack.pop_back();
+        for (const TaskPtr& task : current->GetLinks().dependencies)
+        {
+            Links& next = task->GetLinks();
+            if (next.visited == epoch) continue;
+            if (task->Id() == id) return true;
+            next.visited = epoch;
+            stack.push_back(task.get());
+        }
+    }
+    return false;
+}
+
+void Scheduler::Lib::Task::Raise(unsigned height)
+{
+    Links& links = GetLinks();
+    if (links.tangled || links.height >= height) return;
+    links.height = height;
+
+    // Tangled tasks are left alone, so this only climbs acyclic parts of the
+    // graph and settles. Building from the bottom up it stops at the task
+    // being wired, which has no dependents yet.
+    std::vector<Task*> pending(links.dependents);
+    while (!pending.empty())
+    {
+        Links& current = pending.back()->GetLinks();
+        pending.pop_back();
+        if (current.tangled) continue;
+
+        unsigned next = 0;
+        for (const TaskPtr& dependency : current.dependencies)
+            next = std::max(next, dependency->GetLinks().height + 1);
+        if (current.height >= next) continue;
+
+        current.height = next;
+        pending.insert(pending.end(), current.dependents.begin(), current.dependents.end());
+    }
 }
 
-bool Scheduler::Lib::Task::Requires(
-    const UUID& start,
-    const UUID& parent,
-    const UUID& id) const
+void Scheduler::Lib::Task::Invalidate()
 {
-    for (const TaskPtr& task : m_dependencies)
+    // Stops at tasks already invalid, whose dependents have been marked by
+    // whichever change made them so.
+    std::vector<Task*> pending(1, this);
+    while (!pending.empty())
     {
-        if (task->Id() == start) continue;
-        if (task->Id() == parent) continue;
-        if (task->Id() == id) return true;
-        if (task->Requires(parent, Id(), id)) return true;
+        Task* task = pending.back();
+        pending.pop_back();
+        if (!task->m_allValid.exchange(false, std::memory_order_acq_rel)) continue;
+
+        const std::vector<Task*>& dependents = task->GetLinks().dependents;
+        pending.insert(pending.end(), dependents.begin(), dependents.end());
+    }
+}
+
+void Scheduler::Lib::Task::Tangle()
+{
+    std::vector<Task*> pending(1, this);
+    while (!pending.empty())
+    {
+        Links& links = pending.back()->GetLinks();
+        pending.pop_back();
+        if (links.tangled) continue;
+
+        links.tangled = true;
+        pending.insert(pending.end(), links.dependents.begin(), links.dependents.end());
+    }
+}
+
+bool Scheduler::Lib::Task::Reaches(const Task* target, Graph& graph) const
+{
+    // Nothing reaches a task which has no dependents, such as one being
+    // wired before anything depends on it.
+    const Links& links = GetLinks();
+    const Links& goal = target->GetLinks();
+    if (goal.dependents.empty()) return false;
+    if (!links.tangled && links.height <= goal.height) return false;
+    uint64_t epoch = ++graph.epoch;
+
+    std::vector<const Task*>& stack = graph.stack;
+    stack.clear();
+    stack.push_back(this);
+    while (!stack.empty())
+    {
+        const Task* current = stack.back();
+        stack.pop_back();
+        for (const TaskPtr& task : current->GetLinks().dependencies)
+        {
+            if (task.get() == target) return true;
+            Links& next = task->GetLinks();
+            if (next.visited == epoch) continue;
+            if (!next.tangled && next.height <= goal.height) continue;
+            next.visited = epoch;
+            stack.push_back(task.get());
+        }
     }
     return false;
 }
 
+bool Scheduler::Lib::Task::Recur(const Clock::time_point& now)
+{
+    std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
+    if (!m_recurrence.IsRecurring()) return false;
+    m_runs += 1;
+
+    // The first run is due when it was first allowed to run, or when it
+    // finished for a task which could run straight away.
+    Clock::time_point due = m_due;
+    if (due == Clock::time_point::max())
+        due = m_after != Clock::time_point::max() ? m_after : now;
+
+    unsigned missed = 0;
+    Clock::time_point next = m_recurrence.Next(due, now, missed);
+    if (next == Clock::time_point::max() || next > m_before) return false;
+
+    m_due = next;
+    m_after = next;
+    m_missed += missed;
+    m_retries = 0;
+    m_retryDelay = Clock::duration::zero();
+    return true;
+}
+
 void Scheduler::Lib::Task::SetAfterTime(const Clock::time_point& point)
 {
-    assert(point > Clock::now());
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // A retry time which has already passed by the time the scheduler gets
+    // to it only makes the task due straight away.
+    std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
     m_after = point;
 }
 
-bool Scheduler::Lib::Task::IsPremature() const
+bool Scheduler::Lib::Task::IsFeasible(const Clock::time_point& start) const
 {
-    if (m_after != Clock::time_point::max())
-        return Clock::now() < m_after;
-    return false;
+    if (m_before == Clock::time_point::max()) return true;
+    if (start > m_before) return false;
+    return m_before - start >= m_estimate;
 }
 
-void Scheduler::Lib::Task::SetState(TaskState state)
+Scheduler::Lib::Task* Scheduler::Lib::Task::SetEstimate(
+    const Clock::duration& estimate)
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    SetStateLocked(state, lock);
+    std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
+    if (GetState() != TaskState::NEW) return this;
 
-    lock.unlock();
-    m_cond.notify_all();
+    m_estimate = std::max(estimate, Clock::duration::zero());
+    return this;
 }
 
-void Scheduler::Lib::Task::SetStateLocked(
-    TaskState state,
-    std::unique_lock<std::mutex>& lock)
+Scheduler::Lib::Task* Scheduler::Lib::Task::SetPriority(TaskPriority priority)
 {
-    if (!lock.owns_lock()) lock.lock();
-    if (IsComplete()) return;
+    std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
+    if (GetState() != TaskState::NEW) return this;
 
-    m_state = state;
+    m_priority = priority;
+    return this;
+}
+
+Scheduler::Lib::Task* Scheduler::Lib::Task::SetRecurrence(
+    const Recurrence& recurrence)
+{
+    {
+        std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
+        if (GetState() != TaskState::NEW) return this;
+        m_recurrence = recurrence;
+    }
+
+    if (!recurrence.IsValid()) SetValid(false);
+    return this;
+}
+
+Scheduler::Lib::Task* Scheduler::Lib::Task::SetRetryLimit(unsigned limit)
+{
+    std::lock_guard<std::mutex> lock(ParkingLot::GetMutex(this));
+    if (GetState() != TaskState::NEW) return this;
+
+    m_retryLimit = limit;
+    return this;
+}
+
+void Scheduler::Lib::Task::SetState(TaskState state)
+{
+    if (Transition(state)) ParkingLot::NotifyAll(this);
+}
+
+bool Scheduler::Lib::Task::Transition(TaskState state)
+{
+    assert(state != TaskState::NEW);
+    if (state == TaskState::NEW) return false;
+
+    // Sequentially consistent, so a waiter counting itself on the stripe
+    // either sees the new state or is seen by the notify which follows.
+    TaskState current = m_state.load();
+    do
+    {
+        if (IsFinal(current) || current == state) return false;
+    } while (!m_state.compare_exchange_weak(current, state));
+
+    if (state == TaskState::CANCELLED)
+        m_cancelled.store(true, std::memory_order_release);
+    return true;
 }
 
 void Scheduler::Lib::Task::SetValid(bool status)
@@ -190,8 +581,13 @@ void Scheduler::Lib::Task::SetValid(bool status)
     // complete or has begun running.
     assert(!IsComplete());
     assert(!IsActive());
-    if (!m_valid) return;
-    m_valid = status;
+    if (!m_valid || status) return;
+
+    // Attached even without edges, so a dependent wired at the same time
+    // either sees the change or is marked by it.
+    GraphLock lock(Attach());
+    m_valid = false;
+    Invalidate();
 }
 
 std::string Scheduler::Lib::Task::ToString(bool asShort) const
@@ -199,23 +595,20 @@ std::string Scheduler::Lib::Task::ToString(bool asShort) const
     if (asShort) return m_id.ToString();
 
     std::ostringstream o;
-    o << "<" << Instance() << ": " << m_id << " (" << m_state << ")>";
+    o << "<" << Instance() << ": " << m_id << " (" << GetState() << ")>";
     return o.str();
 }
 
 void Scheduler::Lib::Task::Wait(bool complete) const
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    if (IsComplete()) return;
+    TaskState state = m_state.load();
+    if (IsFinal(state)) return;
 
-    TaskState state = m_state;
-    m_cond.wait(lock, [&]{
-        if (complete) return IsComplete();
-        return (state != m_state);
+    ParkingLot::Wait(this, [&]{
+        TaskState current = m_state.load();
+        if (complete) return IsFinal(current);
+        return current != state;
     });
-
-    lock.unlock();
-    m_cond.notify_all();
 }
 
 std::ostream& Scheduler::Lib::operator<<(std::ostream& o, const Task* task)
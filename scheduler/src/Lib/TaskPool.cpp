@@ -0,0 +1,216 @@
+#include <Scheduler/Lib/TaskPool.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <assert.h>
+
+namespace {
+
+    using Scheduler::Lib::TaskPool;
+
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct Batch
+    {
+        Block* head;
+        size_t count;
+    };
+
+    struct Depot
+    {
+        std::mutex mutex;
+        std::vector<Batch> batches[TaskPool::SIZE_CLASSES];
+        std::atomic<uint64_t> fresh{0};
+        std::atomic<uint64_t> released{0};
+    };
+
+    // Never destroyed, so threads which exit during shutdown can still hand
+    // their blocks back.
+    Depot& GetDepot()
+    {
+        static Depot* depot = new Depot();
+        return *depot;
+    }
+
+    inline size_t SizeClass(size_t size)
+    {
+        return size ? (size - 1) / TaskPool::BLOCK_SIZE : 0;
+    }
+
+    inline size_t BlockSize(size_t sizeClass)
+    {
+        return (sizeClass + 1) * TaskPool::BLOCK_SIZE;
+    }
+
+    void ReleaseBatch(const Batch& batch, Depot& depot)
+    {
+        Block* block = batch.head;
+        while (block)
+        {
+            Block* next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+        depot.released.fetch_add(batch.count, std::memory_order_relaxed);
+    }
+
+    // Hand a chain of blocks to the depot, or back to the heap if the depot
+    // already holds enough of them.
+    void ReturnBatch(size_t sizeClass, const Batch& batch)
+    {
+        Depot& depot = GetDepot();
+        {
+            std::lock_guard<std::mutex> lock(depot.mutex);
+            std::vector<Batch>& batches = depot.batches[sizeClass];
+            if (batches.size() < TaskPool::DEPOT_BATCHES)
+            {
+                batches.push_back(batch);
+                return;
+            }
+        }
+        ReleaseBatch(batch, depot);
+    }
+
+    class Cache
+    {
+    public:
+        ~Cache();
+
+        Block* Pop(size_t sizeClass);
+        void Push(size_t sizeClass, Block* block);
+
+    private:
+        bool Refill(size_t sizeClass);
+        void Spill(size_t sizeClass);
+
+        Block* m_heads[TaskPool::SIZE_CLASSES] = {};
+        size_t m_counts[TaskPool::SIZE_CLASSES] = {};
+    };
+
+    thread_local Cache t_cache;
+
+    // Set once the thread's cache is gone, for blocks freed by thread-local
+    // objects destroyed after it.
+    thread_local bool t_exited = false;
+
+    Cache::~Cache()
+    {
+        t_exited = true;
+        for (size_t c = 0; c < TaskPool::SIZE_CLASSES; ++c)
+        {
+            while (m_heads[c]) Spill(c);
+        }
+    }
+
+    Block* Cache::Pop(size_t sizeClass)
+    {
+        if (!m_heads[sizeClass] && !Refill(sizeClass)) return nullptr;
+
+        Block* block = m_heads[sizeClass];
+        m_heads[sizeClass] = block->next;
+        m_counts[sizeClass] -= 1;
+        return block;
+    }
+
+    void Cache::Push(size_t sizeClass, Block* block)
+    {
+        block->next = m_heads[sizeClass];
+        m_heads[sizeClass] = block;
+        m_counts[sizeClass] += 1;
+
+        // Keep a batch in hand after spilling so a thread alternating
+        // between freeing and allocating does not go back and forth to the
+        // depot.
+        if (m_counts[sizeClass] >= 2 * TaskPool::BATCH_SIZE) Spill(sizeClass);
+    }
+
+    bool Cache::Refill(size_t sizeClass)
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        std::vector<Batch>& batches = depot.batches[sizeClass];
+        if (batches.empty()) return false;
+
+        Batch batch = batches.back();
+        batches.pop_back();
+        m_heads[sizeClass] = batch.head;
+        m_counts[sizeClass] = batch.count;
+        return true;
+    }
+
+    void Cache::Spill(size_t sizeClass)
+    {
+        Batch batch = { m_heads[sizeClass], 0 };
+        Block* tail = nullptr;
+        for (Block* block = batch.head;
+            block && batch.count < TaskPool::BATCH_SIZE;
+            block = block->next)
+        {
+            tail = block;
+            batch.count += 1;
+        }
+        assert(tail);
+
+        m_heads[sizeClass] = tail->next;
+        m_counts[sizeClass] -= batch.count;
+        tail->next = nullptr;
+        ReturnBatch(sizeClass, batch);
+    }
+
+}  // namespace
+
+const size_t Scheduler::Lib::TaskPool::BLOCK_SIZE;
+const size_t Scheduler::Lib::TaskPool::SIZE_CLASSES;
+const size_t Scheduler::Lib::TaskPool::BATCH_SIZE;
+const size_t Scheduler::Lib::TaskPool::DEPOT_BATCHES;
+
+void* Scheduler::Lib::TaskPool::Allocate(size_t size)
+{
+    size_t sizeClass = SizeClass(size);
+    if (sizeClass < SIZE_CLASSES)
+    {
+        if (!t_exited)
+        {
+            if (Block* block = t_cache.Pop(sizeClass)) return block;
+        }
+        size = BlockSize(sizeClass);
+    }
+
+    GetDepot().fresh.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void Scheduler::Lib::TaskPool::Deallocate(void* block, size_t size)
+{
+    if (!block) return;
+
+    size_t sizeClass = SizeClass(size);
+    if (sizeClass < SIZE_CLASSES)
+    {
+        // Once the thread's cache is gone blocks go straight to the heap,
+        // as a depot slot spent on a single block would turn a full batch
+        // away.
+        if (!t_exited)
+        {
+            t_cache.Push(sizeClass, static_cast<Block*>(block));
+            return;
+        }
+    }
+
+    GetDepot().released.fetch_add(1, std::memory_order_relaxed);
+    ::operator delete(block);
+}
+
+Scheduler::Lib::TaskPoolStats Scheduler::Lib::TaskPool::GetStats()
+{
+    Depot& depot = GetDepot();
+
+    TaskPoolStats stats;
+    stats.fresh = depot.fresh.load(std::memory_order_relaxed);
+    stats.released = depot.released.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -3,11 +3,18 @@
 #include <Scheduler/Common/Console.h>
 #include <Scheduler/Lib/Scheduler.h>
 #include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/TaskPool.h>
 #include <Scheduler/Lib/TaskManager.h>
 
 #include <iostream>
 #include <assert.h>
 
+void Scheduler::Lib::ExecutorHistograms::Read(ExecutorStats& stats) const
+{
+    queued.Read(stats.queued);
+    running.Read(stats.running);
+}
+
 Scheduler::Lib::TaskRunner::TaskRunner(TaskPtr&& task)
     : m_task(std::move(task))
 { }
@@ -21,26 +28,100 @@ Scheduler::Lib::TaskRunner::TaskRunner(
 
 Scheduler::Lib::TaskRunner::~TaskRunner() { Release(); }
 
+Scheduler::Lib::TaskRunnerPtr Scheduler::Lib::TaskRunner::Create(
+    TaskPtr&& task,
+    std::weak_ptr<TaskScheduler>&& scheduler)
+{
+    return std::allocate_shared<TaskRunner>(
+        PoolAllocator<TaskRunner>(),
+        std::move(task),
+        std::move(scheduler));
+}
+
+Scheduler::Clock::time_point Scheduler::Lib::TaskRunner::Before() const
+{
+    return m_task->Before();
+}
+
 const Scheduler::Lib::UUID& Scheduler::Lib::TaskRunner::Id() const
 {
     return m_task->Id();
 }
 
+bool Scheduler::Lib::TaskRunner::IsFeasible(
+    const Clock::time_point& start) const
+{
+    return m_task->IsFeasible(start);
+}
+
 bool Scheduler::Lib::TaskRunner::IsValid() const { return m_task->IsValid(); }
 
-void Scheduler::Lib::TaskRunner::Run()
+Scheduler::Lib::TaskPriority Scheduler::Lib::TaskRunner::Priority() const
+{
+    return m_task->GetPriority();
+}
+
+void Scheduler::Lib::TaskRunner::Run(ExecutorHistograms* histograms)
 {
+    // The scheduler is held for the whole run rather than locked again
+    // for every task.
     std::shared_ptr<TaskScheduler> scheduler = m_scheduler.lock();
 
+    // Dependents made ready by the task run on this worker straight after
+    // it, up to a limit, rather than waiting on a pass of the scheduler.
+    std::shared_ptr<Task> next = RunTask(scheduler.get(), true, histograms);
+    for (unsigned count = 1; next; ++count)
+    {
+        m_task = std::move(next);
+        next = RunTask(
+            scheduler.get(),
+            count < MAX_CONTINUATIONS,
+            histograms);
+    }
+}
+
+std::shared_ptr<Scheduler::Lib::Task> Scheduler::Lib::TaskRunner::RunTask(
+    TaskScheduler* scheduler,
+    bool continuing,
+    ExecutorHistograms* histograms)
+{
+    // The scheduler cancels tasks which expire while still queued on the
+    // executor. There is no point running them.
+    if (m_task->IsComplete()) return nullptr;
+
+    // A runner cancelled through the executor alone still owes the
+    // scheduler an outcome for its task.
+    if (IsCancelled())
+    {
+        Console(std::cout) << "Task '" << m_task->Id()
+            << "' cancelled before it could run\n";
+        if (scheduler) scheduler->Notify(
+            m_task,
+            TaskState::CANCELLED);
+        else m_task->SetState(TaskState::CANCELLED);
+        return nullptr;
+    }
+
     if (scheduler) scheduler->Notify(
         m_task,
         TaskState::ACTIVE);
     else m_task->SetState(TaskState::ACTIVE);
 
-    Clock::time_point start = Clock::now();
+    Clock::time_point start = Now();
     ResultPtr resultPtr;
     TaskResult result = m_task->Run(resultPtr);
-    Clock::time_point stop = Clock::now();
+    Clock::time_point stop = Now();
+
+    TaskTimes& times = m_task->m_times;
+    times.started = start;
+    times.finished = stop;
+    if (histograms)
+    {
+        // Tasks handed to the executor directly were never dispatched.
+        if (times.dispatched != Clock::time_point::min())
+            histograms->queued.Record(start - times.dispatched);
+        histograms->running.Record(stop - start);
+    }
 
     int64_t length = std::chrono::duration_cast<
         std::chrono::milliseconds>(stop - start).count();
@@ -49,6 +130,7 @@ void Scheduler::Lib::TaskRunner::Run()
     {
         Console(std::cout) << "Task '" << m_task->Id()
             << "' successfully executed in: " << length << "ms\n";
+        if (scheduler && continuing) return scheduler->Continue(m_task);
         if (scheduler) scheduler->Notify(
             m_task,
             TaskState::SUCCESS);
@@ -65,19 +147,28 @@ void Scheduler::Lib::TaskRunner::Run()
     }
     else if (result == TaskResult::RETRY)
     {
+        // The scheduler decides when, and whether, the task runs again.
         Console(std::cout) << "Task '" << m_task->Id()
-            << "' retrying to execute after running for: "
-            << length << "ms. Next attempt in: "
-            << std::chrono::duration_cast<std::chrono::milliseconds>(
-                m_task->GetRetryInterval()).count()
-            << "ms\n";
-        m_task->SetAfterTime(Clock::now() + m_task->GetRetryInterval());
+            << "' asked to retry after running for: " << length << "ms\n";
         if (scheduler) scheduler->Notify(
             m_task,
             TaskState::PENDING);
         else m_task->SetState(TaskState::PENDING);
     }
     else { assert(!"Unknown TaskResult value"); }
+    return nullptr;
+}
+
+void Scheduler::Lib::TaskRunner::Shed()
+{
+    std::shared_ptr<TaskScheduler> scheduler = m_scheduler.lock();
+
+    Console(std::cout) << "Task '" << m_task->Id()
+        << "' shed as it can no longer meet its deadline\n";
+    if (scheduler) scheduler->Notify(
+        m_task,
+        TaskState::CANCELLED);
+    else m_task->SetState(TaskState::CANCELLED);
 }
 
 void Scheduler::Lib::TaskRunner::Release()
@@ -0,0 +1,216 @@
+#include <Scheduler/Lib/TimerWheel.h>
+
+#include <limits>
+#include <assert.h>
+
+namespace {
+
+    inline unsigned LowestBit(uint64_t value)
+    {
+        assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+        unsigned bit = 0;
+        while (!(value & 1)) { value >>= 1; ++bit; }
+        return bit;
+#endif
+    }
+
+    const uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
+
+}  // namespace
+
+const Scheduler::Clock::duration Scheduler::Lib::TimerWheel::DEFAULT_SLACK
+    = std::chrono::milliseconds(1);
+
+Scheduler::Lib::TimerWheel::TimerWheel(
+    const Clock::duration& slack,
+    const Clock::time_point& now)
+    : m_slack(slack > Clock::duration::zero() ? slack : Clock::duration(1)),
+      m_origin(now)
+{
+    m_occupied.fill(0);
+}
+
+Scheduler::Lib::TimerWheel::~TimerWheel() { }
+
+bool Scheduler::Lib::TimerWheel::Cancel(SlotHandle handle)
+{
+    if (m_timers.erase(handle) == 0) return false;
+
+    // Once nothing is armed the stale entries can be dropped wholesale
+    // which also allows the wheel to jump straight to any future time.
+    if (m_timers.empty()) Clear();
+    return true;
+}
+
+void Scheduler::Lib::TimerWheel::Clear()
+{
+    for (auto& level : m_slots)
+        for (Slot& slot : level) slot.clear();
+    m_occupied.fill(0);
+    m_due.clear();
+    m_overflow.clear();
+    m_timers.clear();
+}
+
+size_t Scheduler::Lib::TimerWheel::Expire(
+    const Clock::time_point& now,
+    std::vector<SlotHandle>& expired)
+{
+    size_t count = expired.size();
+
+    uint64_t target = m_current;
+    if (now > m_origin)
+        target = static_cast<uint64_t>((now - m_origin).count() / m_slack.count());
+
+    Release(m_due, expired);
+    while (!m_timers.empty())
+    {
+        uint64_t tick = NextTick();
+        if (tick > target) break;
+        Process(tick, expired);
+    }
+
+    // No occupied slot lies between the current tick and the target so the
+    // wheel can skip the idle stretch without cascading anything.
+    if (target > m_current) m_current = target;
+    return expired.size() - count;
+}
+
+Scheduler::Clock::time_point Scheduler::Lib::TimerWheel::NextExpiry() const
+{
+    if (m_timers.empty()) return Clock::time_point::max();
+
+    uint64_t tick = m_due.empty() ? NextTick() : m_current;
+    if (tick == NO_TICK) return Clock::time_point::max();
+
+    Clock::rep limit = (Clock::time_point::max() - m_origin).count()
+        / m_slack.count();
+    if (tick >= static_cast<uint64_t>(limit)) return Clock::time_point::max();
+    return m_origin + m_slack * static_cast<Clock::rep>(tick);
+}
+
+uint64_t Scheduler::Lib::TimerWheel::NextTick() const
+{
+    for (unsigned level = 0; level < LEVELS; ++level)
+    {
+        if (!m_occupied[level]) continue;
+
+        // Every occupied slot on a level is ahead of the current position
+        // so the lowest one is the next to be reached. The lower levels
+        // always fire before the higher ones.
+        unsigned shift = BITS * level;
+        uint64_t base = (m_current >> (shift + BITS)) << (shift + BITS);
+        return base | (static_cast<uint64_t>(LowestBit(m_occupied[level])) << shift);
+    }
+    if (!m_overflow.empty())
+    {
+        unsigned shift = BITS * LEVELS;
+        return ((m_current >> shift) + 1) << shift;
+    }
+    return NO_TICK;
+}
+
+void Scheduler::Lib::TimerWheel::Place(Entry&& entry)
+{
+    if (entry.tick <= m_current)
+    {
+        m_due.emplace_back(std::move(entry));
+        return;
+    }
+
+    // A timer lives on the lowest level where it shares every higher order
+    // bit with the current tick. It is cascaded down when the wheel reaches
+    // its slot on that level.
+    for (unsigned level = 0; level < LEVELS; ++level)
+    {
+        unsigned shift = BITS * (level + 1);
+        if ((entry.tick >> shift) != (m_current >> shift)) continue;
+
+        unsigned slot = (entry.tick >> (BITS * level)) & (SLOTS - 1);
+        m_slots[level][slot].emplace_back(std::move(entry));
+        m_occupied[level] |= (uint64_t(1) << slot);
+        return;
+    }
+    m_overflow.emplace_back(std::move(entry));
+}
+
+void Scheduler::Lib::TimerWheel::Process(
+    uint64_t tick,
+    std::vector<SlotHandle>& expired)
+{
+    assert(tick > m_current);
+    m_current = tick;
+
+    Slot cascade;
+    if ((tick & ((uint64_t(1) << (BITS * LEVELS)) - 1)) == 0)
+        cascade.swap(m_overflow);
+
+    for (unsigned level = LEVELS - 1; level > 0; --level)
+    {
+        unsigned shift = BITS * level;
+        if ((tick & ((uint64_t(1) << shift) - 1)) != 0) continue;
+
+        unsigned slot = (tick >> shift) & (SLOTS - 1);
+        if (!(m_occupied[level] & (uint64_t(1) << slot))) continue;
+
+        Slot& entries = m_slots[level][slot];
+        cascade.insert(cascade.end(),
+            std::make_move_iterator(entries.begin()),
+            std::make_move_iterator(entries.end()));
+        entries.clear();
+        m_occupied[level] &= ~(uint64_t(1) << slot);
+    }
+
+    for (Entry& entry : cascade)
+    {
+        auto iter = m_timers.find(entry.handle);
+        if (iter == m_timers.end() || iter->second != entry.generation)
+            continue;
+        Place(std::move(entry));
+    }
+
+    unsigned slot = tick & (SLOTS - 1);
+    if (m_occupied[0] & (uint64_t(1) << slot))
+    {
+        Release(m_slots[0][slot], expired);
+        m_occupied[0] &= ~(uint64_t(1) << slot);
+    }
+    Release(m_due, expired);
+}
+
+void Scheduler::Lib::TimerWheel::Release(
+    Slot& slot,
+    std::vector<SlotHandle>& expired)
+{
+    for (Entry& entry : slot)
+    {
+        auto iter = m_timers.find(entry.handle);
+        if (iter == m_timers.end() || iter->second != entry.generation)
+            continue;
+        m_timers.erase(iter);
+        expired.emplace_back(entry.handle);
+    }
+    slot.clear();
+}
+
+void Scheduler::Lib::TimerWheel::Schedule(
+    SlotHandle handle,
+    const Clock::time_point& deadline)
+{
+    uint64_t tick = 0;
+    if (deadline == Clock::time_point::max())
+        tick = NO_TICK;
+    else if (deadline > m_origin)
+    {
+        Clock::rep delta = (deadline - m_origin).count();
+        tick = static_cast<uint64_t>(delta / m_slack.count());
+        if (delta % m_slack.count()) ++tick;
+    }
+
+    uint64_t generation = ++m_generation;
+    m_timers[handle] = generation;
+    Place(Entry{ handle, tick, generation });
+}
@@ -3,8 +3,10 @@
 #include <Scheduler/Common/ASCII.h>
 #include <Scheduler/Common/Random.h>
 
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <thread>
 #include <string.h>
 
 Scheduler::Lib::UUID Scheduler::Lib::UUID::FromString(
@@ -53,7 +55,12 @@ size_t Scheduler::Lib::UUID::Hash() const
 
 void Scheduler::Lib::UUID::Initialize()
 {
-    static Generator<uint8_t> generator(0, 15);
+    // The engine is not safe to share, and tasks are created on many
+    // threads at once. Threads started together would read the same time,
+    // so their ids go into the seed as well.
+    thread_local Generator<uint8_t> generator(0, 15,
+        static_cast<uint64_t>(Clock::now().time_since_epoch().count())
+        ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
 
     if (m_initialized) return;
 
@@ -0,0 +1,968 @@
+#include <Scheduler/Lib/DecentralizedTaskScheduler.h>
+
+#include <Scheduler/Common/Console.h>
+#include <Scheduler/Lib/TaskRunner.h>
+
+#include <algorithm>
+#include <iostream>
+#include <assert.h>
+
+// #define SCHEDULER_DEBUGGING 1
+
+namespace {
+
+    // Length of time a pending task may wait on a dependency which was never
+    // queued with the scheduler before it is failed.
+    const Scheduler::Clock::duration TASK_TIMEOUT_INTERVAL = std::chrono::seconds(30);
+
+}  // namespace
+
+Scheduler::Lib::DecentralizedTaskScheduler::DecentralizedTaskScheduler(
+    const SchedulerParams& params,
+    std::shared_ptr<ScheduleReporter>&& reporter,
+    std::shared_ptr<TaskManager>&& manager,
+    std::shared_ptr<Executor>&& executor,
+    std::shared_ptr<Admission>&& admission,
+    std::shared_ptr<Backoff>&& backoff)
+    : m_intakeBatchSize(std::max<size_t>(params.intakeBatchSize, 1)),
+      m_policy(params.dispatchPolicy),
+      m_timers(params.timerSlack),
+      m_admission(std::move(admission)),
+      m_backoff(std::move(backoff)),
+      m_executor(std::move(executor)),
+      m_reporter(std::move(reporter)),
+      m_manager(std::move(manager))
+{ }
+
+Scheduler::Lib::DecentralizedTaskScheduler::~DecentralizedTaskScheduler()
+{
+    Shutdown(false);
+
+    // The timer thread holds a reference to the scheduler, so it may be the
+    // one dropping the last of them.
+    if (!m_thread.joinable()) return;
+    if (m_thread.get_id() == std::this_thread::get_id()) m_thread.detach();
+    else m_thread.join();
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Admit(
+    const std::vector<TaskPtr>& tasks)
+{
+    for (size_t first = 0; first < tasks.size(); first += m_intakeBatchSize)
+    {
+        Clock::time_point start = Clock::now();
+        size_t last = std::min(first + m_intakeBatchSize, tasks.size());
+
+        // The whole chunk is checked against one reading of the clock.
+        Clock::time_point now = Now();
+
+        for (size_t i = first; i < last; ++i)
+        {
+            const TaskPtr& task = tasks[i];
+            if (task->IsComplete() || task->IsExpired(now))
+            {
+                if (task->IsComplete())
+                {
+                    Console(std::cout) << "Task '" << task->Id()
+                        << "' cancelled while in queue\n";
+                }
+                else
+                {
+                    Console(std::cout) << "Task '" << task->Id()
+                        << "' expired while in queue\n";
+                }
+                task->SetState(TaskState::CANCELLED);
+                m_manager->Expire(task);
+                m_admission->Release(1);
+
+                // Only tasks which something is already waiting on have a
+                // node to settle.
+                NodePtr node = Find(task->Id());
+                if (node && Settle(*node) != Phase::DONE) Complete(node);
+                continue;
+            }
+
+            // A task queued more than once only holds room once.
+            NodePtr node = Admit(task);
+            if (!node)
+            {
+                m_admission->Release(1);
+                continue;
+            }
+            node->admitted = true;
+
+            task->m_times.pending = now;
+            m_intakeLatency.Record(now - task->m_times.enqueued);
+
+            if (task->IsPremature(now))
+            {
+                ScheduleTimer(node, Timer::START, task->After());
+                continue;
+            }
+            Resolve(node);
+        }
+
+        Clock::duration elapsed = Clock::now() - start;
+
+#ifdef SCHEDULER_DEBUGGING
+        Console(std::cout) << "Intake of " << last - first << " tasks in "
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+                elapsed).count() << "us\n";
+#endif  // SCHEDULER_DEBUGGING
+
+        if (m_reporter) m_reporter->ReportIntake(last - first, elapsed);
+    }
+}
+
+Scheduler::Error Scheduler::Lib::DecentralizedTaskScheduler::Cancel(
+    const UUID& id)
+{
+    if (m_shutdown) return E_CANCELLED;
+
+    NodePtr node = Find(id);
+    if (!node)
+    {
+        TaskPtr task;
+        // A task the manager has let go is reported by its outcome.
+        Error error = m_manager->GetTask(id, task);
+        if (error == E_COMPLETED || error == E_FAILURE || error == E_CANCELLED)
+            return E_COMPLETED;
+        if (error != E_SUCCESS) return error;
+        if (!task || task->IsComplete()) return E_COMPLETED;
+
+        // The task is still on its way in, which drops it once it sees it
+        // has been cancelled.
+        Console(std::cout) << "Cancelling task '" << id << "'\n";
+        task->SetState(TaskState::CANCELLED);
+        return E_SUCCESS;
+    }
+
+    Phase previous = Settle(*node);
+    if (previous == Phase::DONE) return E_COMPLETED;
+
+    Console(std::cout) << "Cancelling task '" << id << "'\n";
+    CancelNode(node, previous);
+    return E_SUCCESS;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::CancelNode(
+    const NodePtr& node,
+    Phase previous)
+{
+    assert(node->phase == Phase::DONE);
+
+    // Cancelling the task also raises its cancellation flag for the body
+    // if it is already running. A runner still queued on the executor is
+    // tombstoned there so it is skipped rather than run.
+    const TaskPtr& task = node->task;
+    task->SetState(TaskState::CANCELLED);
+    if (previous == Phase::RUNNING) m_executor->Cancel(task->Id());
+
+    m_manager->Expire(task);
+    Complete(node);
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Complete(
+    const NodePtr& root,
+    NodePtr* claim)
+{
+    // A failure is swept through the whole dependent subgraph in one go.
+    // Success only ever makes direct dependents ready.
+    std::vector<NodePtr> sweep(1, root);
+    while (!sweep.empty())
+    {
+        NodePtr node = std::move(sweep.back());
+        sweep.pop_back();
+        assert(node->phase == Phase::DONE);
+
+        const TaskPtr& task = node->task;
+        bool succeeded = task->GetState() == TaskState::SUCCESS;
+
+        std::vector<NodePtr> dependents;
+        {
+            std::lock_guard<std::mutex> lock(node->mutex);
+            node->done = true;
+            dependents.swap(node->dependents);
+        }
+
+        for (NodePtr& dependent : dependents)
+        {
+            if (!succeeded)
+            {
+                // Dependents which have already failed or expired are no
+                // longer waiting on anything.
+                if (Settle(*dependent) == Phase::DONE) continue;
+
+                Console(std::cout) << "Failing task '" << dependent->task->Id()
+                    << "' due to failed dependency '" << task->Id() << "'\n";
+                dependent->task->Fail();
+                m_manager->Finalize(dependent->task);
+                sweep.emplace_back(std::move(dependent));
+                continue;
+            }
+
+            if (dependent->outstanding.fetch_sub(1) != 1) continue;
+            assert(!dependent->task->IsPremature());
+
+            // Tasks which would be shed are left for Dispatch to deal with.
+            if (claim && !*claim && m_started
+                && (m_policy != DispatchPolicy::DEADLINE
+                    || dependent->task->IsFeasible(Now())))
+            {
+                if (Claim(dependent)) *claim = std::move(dependent);
+                continue;
+            }
+            Dispatch(dependent);
+        }
+
+        Release(node);
+    }
+}
+
+Scheduler::Lib::TaskPtr Scheduler::Lib::DecentralizedTaskScheduler::Continue(
+    TaskPtr& task)
+{
+    if (m_shutdown) return nullptr;
+
+    // The task may have been expired or cancelled while it was running.
+    NodePtr node = Find(task->Id());
+    if (node && Recur(node)) return nullptr;
+
+    Phase expected = Phase::RUNNING;
+    if (!node || !node->phase.compare_exchange_strong(expected, Phase::DONE))
+    {
+        assert(task->IsComplete());
+        return nullptr;
+    }
+
+    Console(std::cout) << "Task '" << task->Id()
+        << "' moving to SUCCESS state\n";
+    task->SetState(TaskState::SUCCESS);
+    m_manager->Finalize(task);
+
+    NodePtr next;
+    Complete(node, &next);
+    if (!next) return nullptr;
+
+    Clock::time_point now = Now();
+    next->task->m_times.dispatched = now;
+    m_waitLatency.Record(now - next->task->ReadySince());
+
+    Console(std::cout) << "Task '" << next->task->Id()
+        << "' continuing on the worker of '" << task->Id() << "'\n";
+    return next->task;
+}
+
+bool Scheduler::Lib::DecentralizedTaskScheduler::Claim(const NodePtr& node)
+{
+    Phase expected = Phase::PENDING;
+    if (!node->phase.compare_exchange_strong(expected, Phase::RUNNING))
+        return false;
+
+    const TaskPtr& task = node->task;
+    if (task->IsComplete())
+    {
+        // Cancelled on its way in, after the intake had looked at it.
+        node->phase = Phase::DONE;
+        m_manager->Expire(task);
+        Complete(node);
+        return false;
+    }
+    return true;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Dispatch(const NodePtr& node)
+{
+    // Tasks made ready before the scheduler is started wait for it.
+    if (!m_started)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_started)
+        {
+            m_held.emplace_back(node);
+            return;
+        }
+    }
+
+    if (!Claim(node)) return;
+
+    const TaskPtr& task = node->task;
+    Clock::time_point now = Now();
+    if (m_policy == DispatchPolicy::DEADLINE && !task->IsFeasible(now))
+    {
+        Console(std::cout) << "Task '" << task->Id()
+            << "' shed as it can no longer meet its deadline\n";
+        node->phase = Phase::DONE;
+        task->SetState(TaskState::CANCELLED);
+        m_manager->Expire(task);
+        Complete(node);
+        return;
+    }
+    if (m_shutdown) return;
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Enqueuing task '" << task->ToString(true)
+        << "' with executor" << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+    task->m_times.dispatched = now;
+    m_waitLatency.Record(now - task->ReadySince());
+
+    TaskPtr taskPtr = task;
+    std::weak_ptr<TaskScheduler> scheduler(m_self);
+    TaskRunnerPtr runner = TaskRunner::Create(
+        std::move(taskPtr),
+        std::move(scheduler));
+
+    m_executor->Enqueue(std::move(runner));
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Enqueue(Chain* chain)
+{
+    ChainPtr chainPtr = chain->shared_from_this();
+
+    if (!chain->IsValid())
+    {
+        Console(std::cout) << "Invalid chain '" << chain->ToString(true)
+            << "' enqued to scheduler\n";
+        return;
+    }
+    if (!chain->HasChildren())
+    {
+        Console(std::cout) << "Chain '" << chain->Id()
+            << "' posted with no children\n";
+    }
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Enqueue chain: " << chain->Id() << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+    m_admission->Force(chain->GetChildren().size() + 1);
+
+    std::vector<TaskPtr> batch(chain->GetChildren());
+    batch.emplace_back(std::move(chainPtr));
+    EnqueueBatch(std::move(batch));
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Enqueue(Task* task)
+{
+    TaskPtr taskPtr = task->shared_from_this();
+
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return;
+    }
+
+    m_admission->Force(1);
+    EnqueueBatch(std::vector<TaskPtr>(1, std::move(taskPtr)));
+}
+
+Scheduler::Error Scheduler::Lib::DecentralizedTaskScheduler::Enqueue(
+    Chain* chain,
+    const Clock::duration& timeout)
+{
+    ChainPtr chainPtr = chain->shared_from_this();
+
+    if (!chain->IsValid())
+    {
+        Console(std::cout) << "Invalid chain '" << chain->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(
+        chain->GetChildren().size() + 1,
+        timeout);
+    if (error != E_SUCCESS) return error;
+
+    std::vector<TaskPtr> batch(chain->GetChildren());
+    batch.emplace_back(std::move(chainPtr));
+    EnqueueBatch(std::move(batch));
+    return E_SUCCESS;
+}
+
+Scheduler::Error Scheduler::Lib::DecentralizedTaskScheduler::Enqueue(
+    Task* task,
+    const Clock::duration& timeout)
+{
+    TaskPtr taskPtr = task->shared_from_this();
+
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(1, timeout);
+    if (error != E_SUCCESS) return error;
+
+    EnqueueBatch(std::vector<TaskPtr>(1, std::move(taskPtr)));
+    return E_SUCCESS;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::EnqueueBatch(
+    std::vector<TaskPtr>&& batch)
+{
+    if (batch.empty()) return;
+
+#ifdef SCHEDULER_DEBUGGING
+    for (const TaskPtr& task : batch)
+        Console(std::cout) << "Enqueue: " << task->Id() << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+    Clock::time_point now = Now();
+    for (const TaskPtr& task : batch) task->m_times.enqueued = now;
+
+    // The producer takes the batch in itself. The manager still has to know
+    // about every task before any of them can be completed.
+    std::vector<TaskPtr> tasks(batch);
+    m_manager->Add(std::move(batch));
+    Admit(tasks);
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Expire(const NodePtr& node)
+{
+    Phase previous = Settle(*node);
+    if (previous == Phase::DONE) return;
+
+    const TaskPtr& task = node->task;
+    if (task->IsActive())
+    {
+        Console(std::cout) << "Task '" << task->Id()
+            << "' expired while running\n";
+    }
+    else
+    {
+        Console(std::cout) << "Task '" << task->Id()
+            << "' expired while in queue\n";
+    }
+    CancelNode(node, previous);
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::FailNode(const NodePtr& node)
+{
+    if (Settle(*node) == Phase::DONE) return;
+
+    node->task->Fail();
+    m_manager->Finalize(node->task);
+    Complete(node);
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::GetStats(
+    SchedulerStats& stats) const
+{
+    m_intakeLatency.Read(stats.intake);
+    m_waitLatency.Read(stats.waiting);
+    m_executor->GetStats(stats.executor);
+}
+
+Scheduler::Lib::DecentralizedTaskScheduler::NodePtr
+Scheduler::Lib::DecentralizedTaskScheduler::Admit(const TaskPtr& task)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    NodePtr node = Track(task);
+    Phase expected = Phase::NEW;
+    if (!node->phase.compare_exchange_strong(expected, Phase::PENDING))
+        return nullptr;
+    return node;
+}
+
+Scheduler::Lib::DecentralizedTaskScheduler::NodePtr
+Scheduler::Lib::DecentralizedTaskScheduler::Find(const UUID& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_nodes.find(id);
+    if (iter == m_nodes.end()) return nullptr;
+    return iter->second;
+}
+
+Scheduler::Error Scheduler::Lib::DecentralizedTaskScheduler::Initialize()
+{
+    return E_SUCCESS;
+}
+
+bool Scheduler::Lib::DecentralizedTaskScheduler::IsUnqueued(
+    const TaskPtr& task)
+{
+    NodePtr node = Find(task->Id());
+    return node && node->phase == Phase::NEW;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Notify()
+{
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    m_notify = true;
+    m_timerCond.notify_all();
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Notify(
+    TaskPtr& task,
+    TaskState state)
+{
+    // Tasks still running on the executor after shutdown report back to a
+    // scheduler which has already dropped them.
+    if (m_shutdown) return;
+
+    // The task may have been expired and cancelled while the executor was
+    // still running it. There is nothing left to track in that case.
+    NodePtr node = Find(task->Id());
+    if (!node || node->phase != Phase::RUNNING)
+    {
+        assert(state == TaskState::ACTIVE || task->IsComplete());
+        return;
+    }
+
+    Phase expected = Phase::RUNNING;
+    switch (state)
+    {
+        case TaskState::ACTIVE:
+        {
+            Console(std::cout) << "Task '" << task->Id()
+                << "' moving to ACTIVE state\n";
+            task->SetState(TaskState::ACTIVE);
+            break;
+        }
+        case TaskState::SUCCESS:
+        {
+            if (Recur(node)) break;
+            if (!node->phase.compare_exchange_strong(expected, Phase::DONE))
+                break;
+            Console(std::cout) << "Task '" << task->Id()
+                << "' moving to SUCCESS state\n";
+            task->SetState(TaskState::SUCCESS);
+            m_manager->Finalize(task);
+            Complete(node);
+            break;
+        }
+        case TaskState::FAILED:
+        {
+            if (!node->phase.compare_exchange_strong(expected, Phase::DONE))
+                break;
+            Console(std::cout) << "Task '" << task->Id()
+                << "' moving to FAILURE state\n";
+            task->Fail();
+            m_manager->Finalize(task);
+            Complete(node);
+            break;
+        }
+        case TaskState::CANCELLED:
+        {
+            // The executor shed the task instead of running it.
+            if (!node->phase.compare_exchange_strong(expected, Phase::DONE))
+                break;
+            task->SetState(TaskState::CANCELLED);
+            m_manager->Expire(task);
+            Complete(node);
+            break;
+        }
+        case TaskState::PENDING:
+        {
+            assert(task->IsRetryable());
+            Clock::time_point now = Now();
+            if (m_backoff->Retry(*task, now) != E_SUCCESS)
+            {
+                if (!node->phase.compare_exchange_strong(expected, Phase::DONE))
+                    break;
+                Console(std::cout) << "Task '" << task->Id()
+                    << "' moving to FAILURE state as it is out of retries\n";
+                task->Fail();
+                m_manager->Finalize(task);
+                Complete(node);
+                break;
+            }
+
+            // The deadline timer stays armed while the task waits to retry.
+            if (!node->phase.compare_exchange_strong(expected, Phase::PENDING))
+                break;
+            Console(std::cout) << "Task '" << task->Id()
+                << "' moving back to PENDING state for retry "
+                << task->GetRetryCount() << " in: "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    task->After() - now).count() << "ms\n";
+            task->SetState(TaskState::PENDING);
+            ScheduleTimer(node, Timer::START, task->After());
+            break;
+        }
+        default:
+            assert(!"Unhandled TaskState state");
+    }
+}
+
+bool Scheduler::Lib::DecentralizedTaskScheduler::Recur(const NodePtr& node)
+{
+    const TaskPtr& task = node->task;
+    if (!task->IsRecurring() || node->phase != Phase::RUNNING) return false;
+
+    Clock::time_point now = Now();
+    if (!task->Recur(now)) return false;
+
+    // Losing the race means the task was cancelled or expired as it
+    // finished, which ends the recurrence.
+    Phase expected = Phase::RUNNING;
+    if (!node->phase.compare_exchange_strong(expected, Phase::PENDING))
+        return true;
+
+    Console(std::cout) << "Task '" << task->Id()
+        << "' moving back to PENDING state after run "
+        << task->GetRunCount() << ", next in: "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(
+            task->After() - now).count() << "ms\n";
+    task->SetState(TaskState::PENDING);
+    if (task->After() > now) ScheduleTimer(node, Timer::START, task->After());
+    else Dispatch(node);
+    return true;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Release(const NodePtr& node)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_nodes.find(node->task->Id());
+        if (iter != m_nodes.end() && iter->second == node) m_nodes.erase(iter);
+
+        // A dependency which was never queued only has a node for the sake
+        // of its dependents. Queued ones settle their dependents themselves.
+        for (const TaskPtr& dep : node->task->GetDependencies())
+        {
+            auto depIter = m_nodes.find(dep->Id());
+            if (depIter == m_nodes.end()) continue;
+
+            // Held until the lock on it is dropped.
+            NodePtr depNode = depIter->second;
+            if (depNode->phase != Phase::NEW) continue;
+
+            std::lock_guard<std::mutex> depLock(depNode->mutex);
+            std::vector<NodePtr>& dependents = depNode->dependents;
+            dependents.erase(
+                std::remove(dependents.begin(), dependents.end(), node),
+                dependents.end());
+            if (dependents.empty()) m_nodes.erase(depIter);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        for (SlotHandle handle : { node->deadline, node->timeout })
+        {
+            if (!m_timerEntries.Erase(handle)) continue;
+            m_timers.Cancel(handle);
+        }
+        node->deadline = INVALID_HANDLE;
+        node->timeout = INVALID_HANDLE;
+    }
+
+    if (node->admitted) m_admission->Release(1);
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Resolve(const NodePtr& node)
+{
+    Task* task = node->task.get();
+    assert(!task->IsPremature());
+
+    node->resolved = true;
+    task->SetState(TaskState::PENDING);
+    if (task->Before() != Clock::time_point::max())
+        ScheduleTimer(node, Timer::DEADLINE, task->Before());
+
+    // The count is held above zero until every dependency is registered so
+    // a dependency completing meanwhile cannot dispatch the task early.
+    node->outstanding = 1;
+    bool unqueued = false;
+    Clock::time_point now = Now();
+
+    for (const TaskPtr& dep : task->GetDependencies())
+    {
+        if (dep->GetState() == TaskState::SUCCESS) continue;
+        if (dep->IsComplete())
+        {
+            Console(std::cout) << "Failing task '" << task->Id()
+                << "' due to failed dependency '" << dep->Id() << "'\n";
+            FailNode(node);
+            return;
+        }
+        if (dep->IsExpired(now))
+        {
+            Console(std::cout) << "Failing task '" << task->Id()
+                << "' due to expired dependency '" << dep->Id() << "'\n";
+            FailNode(node);
+            return;
+        }
+        // A dependency which completed since it was looked at has already
+        // settled its dependents, so its outcome is taken here instead. The
+        // node is registered with before the node lock is dropped, so the
+        // node of a dependency which was never queued is not dropped by the
+        // release of its other dependents in between.
+        bool failed = false;
+        bool waiting = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            NodePtr depNode = Track(dep);
+            waiting = depNode->phase == Phase::NEW;
+
+            std::lock_guard<std::mutex> depLock(depNode->mutex);
+            if (depNode->done || dep->IsComplete())
+            {
+                failed = dep->GetState() != TaskState::SUCCESS;
+            }
+            else
+            {
+                node->outstanding.fetch_add(1);
+                depNode->dependents.emplace_back(node);
+            }
+        }
+        if (waiting && !failed)
+        {
+            Console(std::cout) << "Task '" << task->Id()
+                << "' is waiting on a unqueued dependency '" << dep->Id()
+                << "'\n";
+            unqueued = true;
+        }
+        if (failed)
+        {
+            Console(std::cout) << "Failing task '" << task->Id()
+                << "' due to failed dependency '" << dep->Id() << "'\n";
+            FailNode(node);
+            return;
+        }
+    }
+
+    if (unqueued)
+        ScheduleTimer(node, Timer::TIMEOUT, Now() + TASK_TIMEOUT_INTERVAL);
+
+    if (node->outstanding.fetch_sub(1) == 1)
+    {
+#ifdef SCHEDULER_DEBUGGING
+        Console(std::cout) << "Processing task with no dependencies: "
+            << task->Id() << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+        Dispatch(node);
+    }
+}
+
+bool Scheduler::Lib::DecentralizedTaskScheduler::RunOnce()
+{
+    std::unique_lock<std::mutex> lock(m_timerMutex);
+
+    if (m_shutdown)
+    {
+        m_shutdownComplete = true;
+        m_timerCond.notify_all();
+        return false;
+    }
+
+    Clock::time_point now = Now();
+    std::vector<SlotHandle> expired;
+    if (!m_timers.Empty()) m_timers.Expire(now, expired);
+
+    if (expired.empty())
+    {
+        // Producers and workers only wake the thread for a timer due before
+        // the one it is already waiting on.
+        if (!m_notify)
+        {
+            m_wakeup = m_timers.NextExpiry();
+            // Timers are kept on the time source, which need not be the
+            // clock the condition waits on, so wait for what is left.
+            if (m_wakeup == Clock::time_point::max())
+                m_timerCond.wait(lock);
+            else if (m_wakeup > now)
+                m_timerCond.wait_for(lock, m_wakeup - now);
+            m_wakeup = Clock::time_point::min();
+        }
+        m_notify = false;
+        return true;
+    }
+
+    std::vector<Timer> due;
+    due.reserve(expired.size());
+    for (SlotHandle handle : expired)
+    {
+        Timer* timer = m_timerEntries.Get(handle);
+        if (!timer) continue;
+        due.emplace_back(std::move(*timer));
+        m_timerEntries.Erase(handle);
+    }
+    lock.unlock();
+
+    for (Timer& timer : due)
+    {
+        NodePtr node = timer.node.lock();
+        if (!node) continue;
+
+        const TaskPtr& task = node->task;
+        switch (timer.kind)
+        {
+            case Timer::START:
+            {
+                if (node->phase != Phase::PENDING || task->IsComplete())
+                    break;
+
+                // Retried and recurring tasks are already pending with
+                // every dependency resolved and only need to be handed back to the executor.
+                if (!node->resolved) Resolve(node);
+                else if (node->outstanding == 0) Dispatch(node);
+                break;
+            }
+            case Timer::DEADLINE:
+            {
+                if (node->phase == Phase::DONE) break;
+
+                // The wheel never fires early but may fire on the very
+                // instant of the deadline, which does not count as expired
+                // yet.
+                if (!(now > task->Before()))
+                {
+                    ScheduleTimer(
+                        node,
+                        Timer::DEADLINE,
+                        task->Before() + Clock::duration(1));
+                    break;
+                }
+                Expire(node);
+                break;
+            }
+            case Timer::TIMEOUT:
+            {
+                if (node->phase != Phase::PENDING) break;
+
+                bool waiting = false;
+                for (const TaskPtr& dep : task->GetDependencies())
+                {
+                    if (!IsUnqueued(dep)) continue;
+                    waiting = true;
+                    break;
+                }
+                if (!waiting) break;
+
+                Console(std::cout) << "Failing task '" << task->Id()
+                    << "' due to time out on dependency\n";
+                FailNode(node);
+                break;
+            }
+            default:
+                assert(!"Unhandled Timer kind");
+        }
+    }
+    return true;
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::ScheduleTimer(
+    const NodePtr& node,
+    Timer::Kind kind,
+    const Clock::time_point& when)
+{
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    if (m_shutdown) return;
+
+    Timer timer;
+    timer.kind = kind;
+    timer.node = node;
+    SlotHandle handle = m_timerEntries.Insert(std::move(timer));
+    m_timers.Schedule(handle, when);
+
+    if (kind == Timer::DEADLINE) node->deadline = handle;
+    else if (kind == Timer::TIMEOUT) node->timeout = handle;
+
+    if (when < m_wakeup)
+    {
+        m_notify = true;
+        m_timerCond.notify_all();
+    }
+}
+
+Scheduler::Lib::DecentralizedTaskScheduler::Phase
+Scheduler::Lib::DecentralizedTaskScheduler::Settle(Node& node)
+{
+    Phase phase = node.phase;
+    while (phase != Phase::DONE
+        && !node.phase.compare_exchange_weak(phase, Phase::DONE))
+    { }
+    return phase;
+}
+
+std::shared_ptr<Scheduler::Lib::DecentralizedTaskScheduler>
+Scheduler::Lib::DecentralizedTaskScheduler::shared_from_this()
+{
+    return std::static_pointer_cast<DecentralizedTaskScheduler>(
+        TaskScheduler::shared_from_this());
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Shutdown(bool wait)
+{
+    if (m_shutdown.exchange(true)) return;
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Decentralized scheduler shutdown (wait="
+        << std::boolalpha << wait << ")\n";
+#endif  // SCHEDULER_DEBUGGING
+
+    m_admission->Shutdown();
+
+    bool started = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        started = m_started;
+        m_nodes.clear();
+        m_held.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        m_timers.Clear();
+        m_timerEntries.Clear();
+        m_notify = true;
+        m_timerCond.notify_all();
+    }
+
+    // Workers still running tasks notice the shutdown when they report back
+    // and leave the tasks be.
+    m_executor->Shutdown(wait);
+    m_manager->Shutdown(wait);
+    if (m_reporter) m_reporter->Shutdown(wait);
+
+    if (!started)
+    {
+        m_shutdownComplete = true;
+        return;
+    }
+    if (!wait) return;
+
+    if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+        m_thread.join();
+}
+
+void Scheduler::Lib::DecentralizedTaskScheduler::Start()
+{
+    std::vector<NodePtr> held;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_started || m_shutdown) return;
+
+        // Dispatching reads it without the lock once the scheduler counts
+        // as started.
+        m_self = shared_from_this();
+        m_started = true;
+        held.swap(m_held);
+    }
+
+    std::shared_ptr<DecentralizedTaskScheduler> self(shared_from_this());
+    m_thread = std::thread([ self{std::move(self)} ](){
+        self->Run();
+    });
+
+    for (const NodePtr& node : held) Dispatch(node);
+}
+
+Scheduler::Lib::DecentralizedTaskScheduler::NodePtr
+Scheduler::Lib::DecentralizedTaskScheduler::Track(const TaskPtr& task)
+{
+    NodePtr& node = m_nodes[task->Id()];
+    if (!node)
+    {
+        node = std::allocate_shared<Node>(PoolAllocator<Node>());
+        node->task = task;
+    }
+    return node;
+}
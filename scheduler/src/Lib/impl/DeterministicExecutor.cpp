@@ -0,0 +1,108 @@
+#include <Scheduler/Lib/DeterministicExecutor.h>
+
+#include <Scheduler/Common/Console.h>
+#include <Scheduler/Lib/Task.h>
+
+#include <iostream>
+#include <assert.h>
+
+Scheduler::Lib::DeterministicExecutor::DeterministicExecutor(
+    const ExecutorParams& params)
+    : m_policy(params.dispatchPolicy)
+{ }
+
+Scheduler::Lib::DeterministicExecutor::~DeterministicExecutor()
+{
+    Shutdown(true);
+}
+
+Scheduler::Error Scheduler::Lib::DeterministicExecutor::Cancel(const UUID& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_index.find(id);
+    if (iter == m_index.end()) return E_NOT_FOUND;
+
+    // The runner is left queued as a tombstone for RunPending to drop.
+    iter->second->Cancel();
+    m_index.erase(iter);
+    return E_SUCCESS;
+}
+
+void Scheduler::Lib::DeterministicExecutor::Enqueue(TaskRunnerPtr&& task)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+    {
+        Console(std::cout) << "Task '" << task->Id()
+            << "' enqueued after shutdown\n";
+        return;
+    }
+
+    size_t priority = static_cast<size_t>(task->Priority());
+    assert(priority < TASK_PRIORITY_COUNT);
+    m_index[task->Id()] = task.get();
+    m_queues[priority].emplace_back(std::move(task));
+}
+
+void Scheduler::Lib::DeterministicExecutor::GetWorkerStats(
+    std::vector<ExecutorStats>& stats) const
+{
+    stats.assign(1, ExecutorStats());
+    m_histograms.Read(stats.front());
+}
+
+Scheduler::Error Scheduler::Lib::DeterministicExecutor::Initialize()
+{
+    return E_SUCCESS;
+}
+
+bool Scheduler::Lib::DeterministicExecutor::Pop(TaskRunnerPtr& task)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t priority = TASK_PRIORITY_COUNT; priority-- > 0;)
+    {
+        auto& queue = m_queues[priority];
+        if (queue.empty()) continue;
+
+        task = std::move(queue.front());
+        queue.pop_front();
+
+        auto iter = m_index.find(task->Id());
+        if (iter != m_index.end() && iter->second == task.get()) m_index.erase(iter);
+        return true;
+    }
+    return false;
+}
+
+size_t Scheduler::Lib::DeterministicExecutor::RunPending()
+{
+    size_t count = 0;
+    TaskRunnerPtr task;
+    while (Pop(task))
+    {
+        // Tombstones are left for the runner to drop, the same as on the
+        // thread pool.
+        if (m_policy == DispatchPolicy::DEADLINE && !task->IsCancelled()
+            && !task->IsFeasible(Now()))
+        {
+            task->Shed();
+        }
+        else
+        {
+            task->Run(&m_histograms);
+        }
+        task.reset();
+        ++count;
+    }
+    return count;
+}
+
+void Scheduler::Lib::DeterministicExecutor::Shutdown(bool)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return;
+
+    m_shutdown = true;
+    for (auto& queue : m_queues) queue.clear();
+    m_index.clear();
+}
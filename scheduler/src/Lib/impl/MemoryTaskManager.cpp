@@ -18,11 +18,25 @@ void Scheduler::Lib::MemoryTaskManager::Add(TaskPtr&& task)
     m_tasks.emplace(task->Id(), std::move(task));
 }
 
+void Scheduler::Lib::MemoryTaskManager::Add(std::vector<TaskPtr>&& tasks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Console(std::cout) << "Add: " << tasks.size() << " tasks\n";
+
+    m_tasks.reserve(m_tasks.size() + tasks.size());
+    for (TaskPtr& task : tasks)
+    {
+        UUID id = task->Id();
+        m_tasks.emplace(std::move(id), std::move(task));
+    }
+    tasks.clear();
+}
+
 void Scheduler::Lib::MemoryTaskManager::Expire(const TaskPtr& task)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     Console(std::cout) << "Expire: " << task << '\n';
-    m_cache.emplace(task->Id(), TaskState::CANCELLED);
+    Remember(task->Id(), TaskState::CANCELLED);
     m_tasks.erase(task->Id());
 }
 
@@ -38,13 +52,30 @@ void Scheduler::Lib::MemoryTaskManager::Finalize(const TaskPtr& task)
     std::lock_guard<std::mutex> lock(m_mutex);
     Console(std::cout) << "Finalize: " << task << '\n';
 
-    m_cache.emplace(task->Id(), task->GetState());
+    // Finished tasks are never run again so there is no need to hold on to
+    // them, only to their outcome.
+    Remember(task->Id(), task->GetState());
+    m_tasks.erase(task->Id());
+}
+
+size_t Scheduler::Lib::MemoryTaskManager::GetOutcomeCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cache.size();
+}
+
+size_t Scheduler::Lib::MemoryTaskManager::GetTaskCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tasks.size();
 }
 
 Scheduler::Error Scheduler::Lib::MemoryTaskManager::GetTask(
     const UUID& id,
     TaskPtr& task) const
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     auto iter = m_tasks.find(id);
     if (iter == m_tasks.end())
     {
@@ -62,15 +93,51 @@ Scheduler::Error Scheduler::Lib::MemoryTaskManager::GetTask(
         return E_NOT_FOUND;
     }
 
-    task = iter->second->shared_from_this();
+    task = iter->second;
     return E_SUCCESS;
 }
 
+Scheduler::Error Scheduler::Lib::MemoryTaskManager::GetTasks(
+    const std::vector<UUID>& ids,
+    std::vector<TaskPtr>& tasks) const
+{
+    Error error = E_SUCCESS;
+    tasks.resize(ids.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        auto iter = m_tasks.find(ids[i]);
+        if (iter == m_tasks.end())
+        {
+            tasks[i].reset();
+            error = E_NOT_FOUND;
+            continue;
+        }
+        tasks[i] = iter->second;
+    }
+    return error;
+}
+
 Scheduler::Error Scheduler::Lib::MemoryTaskManager::Initialize()
 {
     return E_SUCCESS;
 }
 
+void Scheduler::Lib::MemoryTaskManager::Remember(
+    const UUID& id,
+    TaskState state)
+{
+    if (!m_cache.emplace(id, state).second) return;
+    m_order.emplace_back(id);
+
+    while (m_cache.size() > m_params.outcomes)
+    {
+        m_cache.erase(m_order.front());
+        m_order.pop_front();
+    }
+}
+
 std::shared_ptr<Scheduler::Lib::MemoryTaskManager>
 Scheduler::Lib::MemoryTaskManager::shared_from_this()
 {
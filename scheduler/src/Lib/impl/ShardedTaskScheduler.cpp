@@ -0,0 +1,264 @@
+#include <Scheduler/Lib/ShardedTaskScheduler.h>
+
+#include <Scheduler/Common/Console.h>
+
+#include <algorithm>
+#include <iostream>
+#include <assert.h>
+
+// #define SCHEDULER_DEBUGGING 1
+
+Scheduler::Lib::ShardedTaskScheduler::ShardedTaskScheduler(
+    const SchedulerParams& params,
+    std::shared_ptr<ScheduleReporter>&& reporter,
+    std::shared_ptr<TaskManager>&& manager,
+    std::shared_ptr<Executor>&& executor,
+    std::shared_ptr<Admission>&& admission,
+    std::shared_ptr<Backoff>&& backoff)
+    : m_admission(std::move(admission)),
+      m_backoff(std::move(backoff))
+{
+    unsigned shards = std::max(params.shards, 1u);
+    m_shards.reserve(shards);
+
+    for (unsigned i = 0; i < shards; ++i)
+    {
+        std::shared_ptr<StandardTaskScheduler> shard(
+            new StandardTaskScheduler(params,
+                ScheduleReporterPtr(reporter),
+                TaskManagerPtr(manager),
+                ExecutorPtr(executor),
+                AdmissionPtr(m_admission),
+                BackoffPtr(m_backoff)));
+        m_shards.emplace_back(std::move(shard));
+    }
+}
+
+Scheduler::Lib::ShardedTaskScheduler::~ShardedTaskScheduler() { Shutdown(false); }
+
+void Scheduler::Lib::ShardedTaskScheduler::Enqueue(Chain* chain)
+{
+    ChainPtr chainPtr = chain->shared_from_this();
+
+    if (!chain->IsValid())
+    {
+        Console(std::cout) << "Invalid chain '" << chain->ToString(true)
+            << "' enqued to scheduler\n";
+        return;
+    }
+    if (!chain->HasChildren())
+    {
+        Console(std::cout) << "Chain '" << chain->Id()
+            << "' posted with no children\n";
+    }
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Enqueue chain: " << chain->Id() << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+    m_admission->Force(chain->GetChildren().size() + 1);
+    EnqueueChain(std::move(chainPtr));
+}
+
+Scheduler::Error Scheduler::Lib::ShardedTaskScheduler::Enqueue(
+    Chain* chain,
+    const Clock::duration& timeout)
+{
+    ChainPtr chainPtr = chain->shared_from_this();
+
+    if (!chain->IsValid())
+    {
+        Console(std::cout) << "Invalid chain '" << chain->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(
+        chain->GetChildren().size() + 1,
+        timeout);
+    if (error != E_SUCCESS) return error;
+
+    EnqueueChain(std::move(chainPtr));
+    return E_SUCCESS;
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::EnqueueBatch(
+    std::vector<TaskPtr>&& batch)
+{
+    // Split the batch by owner, keeping its order within each shard, and
+    // hand every shard its part in one go.
+    std::vector<std::vector<TaskPtr>> parts(m_shards.size());
+    for (TaskPtr& task : batch)
+    {
+        unsigned shard = m_shards.front()->Owner(task->Id());
+        parts[shard].emplace_back(std::move(task));
+    }
+    batch.clear();
+
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        if (m_shards[i]->EnqueueTasks(std::move(parts[i])))
+            m_shards[i]->Notify();
+    }
+}
+
+Scheduler::Error Scheduler::Lib::ShardedTaskScheduler::Cancel(const UUID& id)
+{
+    return Owner(id).Cancel(id);
+}
+
+Scheduler::Lib::TaskPtr Scheduler::Lib::ShardedTaskScheduler::Continue(
+    TaskPtr& task)
+{
+    // Only dependents on the shard which owns the task can be claimed.
+    return Owner(task->Id()).Continue(task);
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::EnqueueChain(ChainPtr&& chain)
+{
+    // Children land on whichever shard owns them. Each shard is only woken
+    // once no matter how many of the children it received.
+    std::vector<bool> wake(m_shards.size(), false);
+    for (TaskPtr& child : chain->GetChildren())
+    {
+        StandardTaskScheduler& shard = Owner(child->Id());
+        TaskPtr childPtr = child;
+        if (shard.EnqueueTask(std::move(childPtr))) wake[shard.m_shard] = true;
+    }
+
+    StandardTaskScheduler& owner = Owner(chain->Id());
+    if (owner.EnqueueTask(std::move(chain))) wake[owner.m_shard] = true;
+
+    for (size_t i = 0; i < m_shards.size(); ++i)
+        if (wake[i]) m_shards[i]->Notify();
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::Enqueue(Task* task)
+{
+    TaskPtr taskPtr = task->shared_from_this();
+
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return;
+    }
+
+    m_admission->Force(1);
+    StandardTaskScheduler& shard = Owner(task->Id());
+    if (shard.EnqueueTask(std::move(taskPtr))) shard.Notify();
+}
+
+Scheduler::Error Scheduler::Lib::ShardedTaskScheduler::Enqueue(
+    Task* task,
+    const Clock::duration& timeout)
+{
+    TaskPtr taskPtr = task->shared_from_this();
+
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(1, timeout);
+    if (error != E_SUCCESS) return error;
+
+    StandardTaskScheduler& shard = Owner(task->Id());
+    if (shard.EnqueueTask(std::move(taskPtr))) shard.Notify();
+    return E_SUCCESS;
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::GetStats(SchedulerStats& stats) const
+{
+    for (const auto& shard : m_shards)
+    {
+        shard->m_intakeLatency.Read(stats.intake);
+        shard->m_waitLatency.Read(stats.waiting);
+    }
+
+    // Every shard runs its tasks on the same executor.
+    if (!m_shards.empty()) m_shards.front()->ReadExecutorStats(stats.executor);
+}
+
+Scheduler::Error Scheduler::Lib::ShardedTaskScheduler::Initialize()
+{
+    Error error = E_FAILURE;
+
+    std::vector<std::weak_ptr<StandardTaskScheduler>> shards(
+        m_shards.begin(), m_shards.end());
+
+    for (unsigned i = 0; i < m_shards.size(); ++i)
+    {
+        m_shards[i]->SetShards(i, shards);
+        if ((error = m_shards[i]->Initialize()) != E_SUCCESS) return error;
+    }
+    return E_SUCCESS;
+}
+
+bool Scheduler::Lib::ShardedTaskScheduler::IsShutdown() const
+{
+    for (const auto& shard : m_shards)
+        if (!shard->IsShutdown()) return false;
+    return true;
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::Notify()
+{
+    for (auto& shard : m_shards) shard->Notify();
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::Notify(
+    TaskPtr& task,
+    TaskState state)
+{
+    // Runners are normally handed the shard which dispatched them and
+    // report back to it directly.
+    Owner(task->Id()).Notify(task, state);
+}
+
+Scheduler::Lib::StandardTaskScheduler&
+Scheduler::Lib::ShardedTaskScheduler::Owner(const UUID& id) const
+{
+    assert(!m_shards.empty());
+    return *m_shards[m_shards.front()->Owner(id)];
+}
+
+bool Scheduler::Lib::ShardedTaskScheduler::RunOnce()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_shutdown) m_cond.wait(lock);
+    return false;
+}
+
+std::shared_ptr<Scheduler::Lib::ShardedTaskScheduler>
+Scheduler::Lib::ShardedTaskScheduler::shared_from_this()
+{
+    return std::static_pointer_cast<ShardedTaskScheduler>(
+        TaskScheduler::shared_from_this());
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::Shutdown(bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shutdown) return;
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Sharded scheduler shutdown (wait=" << std::boolalpha
+        << wait << ")\n";
+#endif  // SCHEDULER_DEBUGGING
+
+    m_shutdown = true;
+    m_cond.notify_all();
+    lock.unlock();
+
+    // The executor and manager are shared so the first shard to shut down
+    // takes them down with it. Later shards find them already stopped.
+    for (auto& shard : m_shards) shard->Shutdown(wait);
+}
+
+void Scheduler::Lib::ShardedTaskScheduler::Start()
+{
+    for (auto& shard : m_shards) shard->Start();
+}
@@ -3,23 +3,244 @@
 #include <Scheduler/Common/Console.h>
 #include <Scheduler/Lib/TaskRunner.h>
 
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
 // #define SCHEDULER_DEBUGGING 1
 
+namespace {
+
+    // Length of time a pending task may wait on a dependency which was never
+    // queued with the scheduler before it is failed.
+    const Scheduler::Clock::duration TASK_TIMEOUT_INTERVAL = std::chrono::seconds(30);
+
+}  // namespace
+
 Scheduler::Lib::StandardTaskScheduler::StandardTaskScheduler(
     const SchedulerParams& params,
     std::shared_ptr<ScheduleReporter>&& reporter,
     std::shared_ptr<TaskManager>&& manager,
-    std::shared_ptr<Executor>&& executor)
-    : m_executor(std::move(executor)),
+    std::shared_ptr<Executor>&& executor,
+    std::shared_ptr<Admission>&& admission,
+    std::shared_ptr<Backoff>&& backoff)
+    : m_intakeBatchSize(std::max<size_t>(params.intakeBatchSize, 1)),
+      m_policy(params.dispatchPolicy),
+      m_premature(params.timerSlack),
+      m_deadlines(params.timerSlack),
+      m_admission(std::move(admission)),
+      m_backoff(std::move(backoff)),
+      m_executor(std::move(executor)),
       m_reporter(std::move(reporter)),
       m_manager(std::move(manager))
 { }
 
 Scheduler::Lib::StandardTaskScheduler::~StandardTaskScheduler() { Shutdown(false); }
 
+Scheduler::Error Scheduler::Lib::StandardTaskScheduler::Cancel(const UUID& id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shutdown) return E_CANCELLED;
+
+    SlotHandle handle = Find(id);
+    Record* record = m_tasks.Get(handle);
+
+    TaskPtr task;
+    if (record) task = record->task;
+    else
+    {
+        // A task the manager has let go is reported by its outcome.
+        Error error = m_manager->GetTask(id, task);
+        if (error == E_COMPLETED || error == E_FAILURE || error == E_CANCELLED)
+            return E_COMPLETED;
+        if (error != E_SUCCESS) return error;
+    }
+    if (!task || task->IsComplete()) return E_COMPLETED;
+
+    Console(std::cout) << "Cancelling task '" << id << "'\n";
+
+    // A task without a record is still on the intake, which drops it once
+    // it sees it has been cancelled.
+    if (!record) task->SetState(TaskState::CANCELLED);
+    else CancelTask(handle);
+
+    NotifyLocked(lock);
+    return E_SUCCESS;
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::CancelTask(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+
+    // Cancelling the task also raises its cancellation flag for the body
+    // if it is already running. A runner still queued on the executor is
+    // tombstoned there so it is skipped rather than run.
+    const TaskPtr& task = record->task;
+    task->SetState(TaskState::CANCELLED);
+    if (record->flags & Record::ACTIVE) m_executor->Cancel(task->Id());
+
+    record->flags &= ~(Record::ACTIVE | Record::PENDING);
+    record->outstanding = 0;
+    Unlink(m_timeouts, &Record::timeout, handle);
+    m_premature.Cancel(handle);
+    m_deadlines.Cancel(handle);
+
+    m_manager->Expire(task);
+    m_completed.emplace_back(handle);
+    return true;
+}
+
+Scheduler::Lib::TaskPtr Scheduler::Lib::StandardTaskScheduler::ClaimContinuation(
+    SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+
+    Clock::time_point now = Now();
+    std::vector<SlotHandle>& dependents = record->dependents;
+    for (size_t i = 0; i < dependents.size(); ++i)
+    {
+        Record* dependent = m_tasks.Get(dependents[i]);
+        if (!dependent || !(dependent->flags & Record::PENDING)
+            || dependent->outstanding != 1)
+        {
+            continue;
+        }
+
+        // A dependent cancelled elsewhere is settled rather than claimed.
+        const TaskPtr& next = dependent->task;
+        if (next->IsComplete())
+        {
+            CancelTask(dependents[i]);
+            dependents.erase(dependents.begin() + i--);
+            continue;
+        }
+
+        // Tasks the scheduler would shed are left for it to deal with.
+        assert(!next->IsPremature());
+        if (m_policy == DispatchPolicy::DEADLINE
+            && !next->IsFeasible(now))
+        {
+            continue;
+        }
+
+        next->m_times.dispatched = now;
+        m_waitLatency.Record(now - next->ReadySince());
+
+        dependent->outstanding = 0;
+        dependent->flags &= ~Record::PENDING;
+        dependent->flags |= Record::ACTIVE;
+        Unlink(m_timeouts, &Record::timeout, dependents[i]);
+
+        // The rest of the dependents are resolved by the scheduler as usual.
+        TaskPtr claimed = next;
+        dependents.erase(dependents.begin() + i);
+        return claimed;
+    }
+    return nullptr;
+}
+
+Scheduler::Lib::TaskPtr Scheduler::Lib::StandardTaskScheduler::Continue(
+    TaskPtr& task)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shutdown) return nullptr;
+
+    SlotHandle handle = Find(task->Id());
+    Record* record = m_tasks.Get(handle);
+    if (!record || !(record->flags & Record::ACTIVE))
+    {
+        assert(task->IsComplete());
+        return nullptr;
+    }
+
+    assert(!(record->flags & Record::PENDING));
+    record->flags &= ~Record::ACTIVE;
+    if (RecurTask(handle))
+    {
+        if (m_waiting) NotifyLocked(lock);
+        return nullptr;
+    }
+
+    Console(std::cout) << "Task '" << task->Id()
+        << "' moving to SUCCESS state\n";
+    task->SetState(TaskState::SUCCESS);
+    m_completed.emplace_back(handle);
+
+    TaskPtr next = ClaimContinuation(handle);
+    if (next)
+    {
+        Console(std::cout) << "Task '" << next->Id()
+            << "' continuing on the worker of '" << task->Id() << "'\n";
+    }
+
+    if (m_waiting) NotifyLocked(lock);
+    return next;
+}
+
+void Scheduler::Lib::StandardTaskScheduler::DispatchReadyTasks(
+    const Clock::time_point& now)
+{
+    bool ready = false;
+    for (const auto& queue : m_ready) ready |= !queue.empty();
+    if (!ready) return;
+
+    std::weak_ptr<StandardTaskScheduler> self(shared_from_this());
+    bool deadline = m_policy == DispatchPolicy::DEADLINE;
+
+    for (size_t priority = TASK_PRIORITY_COUNT; priority-- > 0;)
+    {
+        std::deque<SlotHandle>& queue = m_ready[priority];
+        if (deadline && queue.size() > 1)
+        {
+            // Handles which went stale since becoming ready sort last and
+            // are dropped below.
+            auto before = [this](SlotHandle handle) {
+                const Record* record = m_tasks.Get(handle);
+                if (!record) return Clock::time_point::max();
+                return record->task->Before();
+            };
+            std::stable_sort(queue.begin(), queue.end(),
+                [&](SlotHandle a, SlotHandle b) { return before(a) < before(b); });
+        }
+
+        while (!queue.empty())
+        {
+            SlotHandle handle = queue.front();
+            queue.pop_front();
+
+            // The task may have expired since it became ready.
+            Record* record = m_tasks.Get(handle);
+            if (!record || !(record->flags & Record::ACTIVE)) continue;
+
+            if (deadline && !record->task->IsFeasible(now))
+            {
+                Console(std::cout) << "Task '" << record->task->Id()
+                    << "' shed as it can no longer meet its deadline\n";
+                ShedTask(handle);
+                continue;
+            }
+
+#ifdef SCHEDULER_DEBUGGING
+            Console(std::cout) << "Enqueuing task '"
+                << record->task->ToString(true) << "' with executor" << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+            TaskPtr task = record->task;
+            task->m_times.dispatched = now;
+            m_waitLatency.Record(now - task->ReadySince());
+
+            std::weak_ptr<StandardTaskScheduler> scheduler(self);
+            TaskRunnerPtr runner = TaskRunner::Create(
+                std::move(task),
+                std::move(scheduler));
+
+            m_executor->Enqueue(std::move(runner));
+        }
+    }
+}
+
 void Scheduler::Lib::StandardTaskScheduler::Enqueue(Chain* chain)
 {
     ChainPtr chainPtr = chain->shared_from_this();
@@ -36,17 +257,13 @@ void Scheduler::Lib::StandardTaskScheduler::Enqueue(Chain* chain)
             << "' posted with no children\n";
     }
 
-    std::unique_lock<std::mutex> lock(m_mutex);
-
 #ifdef SCHEDULER_DEBUGGING
     Console(std::cout) << "Enqueue chain: " << chain->Id() << '\n';
 #endif  // SCHEDULER_DEBUGGING
 
-    for (TaskPtr& child : chain->GetChildren()) EnqueueLocked(child, lock);
-    m_queue.emplace_back(chain->Id());
+    m_admission->Force(chain->GetChildren().size() + 1);
 
-    m_manager->Add(std::move(chainPtr));
-    if (m_waiting) NotifyLocked(lock);
+    if (EnqueueChain(std::move(chainPtr))) Notify();
 }
 
 void Scheduler::Lib::StandardTaskScheduler::Enqueue(Task* task)
@@ -60,34 +277,184 @@ void Scheduler::Lib::StandardTaskScheduler::Enqueue(Task* task)
         return;
     }
 
-    std::unique_lock<std::mutex> lock(m_mutex);
-    EnqueueLocked(std::move(taskPtr), lock);
+    m_admission->Force(1);
+    if (EnqueueTask(std::move(taskPtr))) Notify();
 }
 
-void Scheduler::Lib::StandardTaskScheduler::EnqueueLocked(
-    TaskPtr& task,
-    std::unique_lock<std::mutex>& lock)
+Scheduler::Error Scheduler::Lib::StandardTaskScheduler::Enqueue(
+    Chain* chain,
+    const Clock::duration& timeout)
+{
+    ChainPtr chainPtr = chain->shared_from_this();
+
+    if (!chain->IsValid())
+    {
+        Console(std::cout) << "Invalid chain '" << chain->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(
+        chain->GetChildren().size() + 1,
+        timeout);
+    if (error != E_SUCCESS) return error;
+
+    if (EnqueueChain(std::move(chainPtr))) Notify();
+    return E_SUCCESS;
+}
+
+Scheduler::Error Scheduler::Lib::StandardTaskScheduler::Enqueue(
+    Task* task,
+    const Clock::duration& timeout)
 {
-    assert(lock.owns_lock());
     TaskPtr taskPtr = task->shared_from_this();
-    EnqueueLocked(std::move(taskPtr), lock);
+
+    if (!task->IsValid())
+    {
+        Console(std::cout) << "Invalid task '" << task->ToString(true)
+            << "' enqued to scheduler\n";
+        return E_INVALID_ARGUMENT;
+    }
+
+    Error error = m_admission->Acquire(1, timeout);
+    if (error != E_SUCCESS) return error;
+
+    if (EnqueueTask(std::move(taskPtr))) Notify();
+    return E_SUCCESS;
 }
 
-void Scheduler::Lib::StandardTaskScheduler::EnqueueLocked(
-    TaskPtr&& task,
-    std::unique_lock<std::mutex>& lock)
+bool Scheduler::Lib::StandardTaskScheduler::EnqueueChain(ChainPtr&& chain)
 {
-    assert(lock.owns_lock());
-    assert(task->IsValid());
+    bool wake = false;
+    for (TaskPtr& child : chain->GetChildren())
+    {
+        TaskPtr childPtr = child;
+        wake |= EnqueueTask(std::move(childPtr));
+    }
+    wake |= EnqueueTask(std::move(chain));
+    return wake;
+}
 
-    m_queue.emplace_back(task->Id());
+void Scheduler::Lib::StandardTaskScheduler::EnqueueBatch(
+    std::vector<TaskPtr>&& batch)
+{
+    if (EnqueueTasks(std::move(batch))) Notify();
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::EnqueueTask(TaskPtr&& task)
+{
+    assert(task->IsValid());
 
 #ifdef SCHEDULER_DEBUGGING
     Console(std::cout) << "Enqueue: " << task->Id() << '\n';
 #endif  // SCHEDULER_DEBUGGING
 
+    task->m_times.enqueued = Now();
+
+    // The task has to be known to the manager before the scheduler can
+    // see its ID come through the intake queue.
+    Message message;
+    message.id = task->Id();
     m_manager->Add(std::move(task));
-    if (m_waiting) NotifyLocked(lock);
+    return m_intake.Push(std::move(message));
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::EnqueueTasks(
+    std::vector<TaskPtr>&& tasks)
+{
+    if (tasks.empty()) return false;
+
+    Clock::time_point now = Now();
+    std::vector<Message> messages(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        assert(tasks[i]->IsValid());
+        tasks[i]->m_times.enqueued = now;
+        messages[i].id = tasks[i]->Id();
+    }
+
+    // As with a single task the whole batch has to be known to the manager
+    // before any of it can come through the intake.
+    m_manager->Add(std::move(tasks));
+    return m_intake.Push(std::move(messages));
+}
+
+void Scheduler::Lib::StandardTaskScheduler::FailTask(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+
+    record->flags &= ~Record::PENDING;
+    record->outstanding = 0;
+    Unlink(m_timeouts, &Record::timeout, handle);
+
+    record->task->Fail();
+    m_manager->Finalize(record->task);
+
+    // Dependents of the failed task are failed along with it on the next
+    // pass.
+    m_completed.emplace_back(handle);
+}
+
+void Scheduler::Lib::StandardTaskScheduler::FailDependents(SlotHandle handle)
+{
+    // Failing a task fails everything which depends on it, directly or not,
+    // so the whole subgraph is swept through the reverse dependency index in
+    // one go rather than a level per pass. Records are released as soon as
+    // they have been swept.
+    std::vector<SlotHandle> sweep(1, handle);
+    while (!sweep.empty())
+    {
+        SlotHandle current = sweep.back();
+        sweep.pop_back();
+
+        Record* record = m_tasks.Get(current);
+        if (!record) continue;
+
+        NotifyWatchers(*record);
+
+        std::vector<SlotHandle> dependents = std::move(record->dependents);
+        record->dependents.clear();
+        for (SlotHandle dependentHandle : dependents)
+        {
+            // Dependents which have already failed or expired are no longer
+            // waiting on anything.
+            Record* dependent = m_tasks.Get(dependentHandle);
+            if (!dependent || !(dependent->flags & Record::PENDING)
+                || dependent->outstanding == 0)
+            {
+                continue;
+            }
+
+            assert(dependent->task->GetState() == TaskState::PENDING);
+            Console(std::cout) << "Failing task '" << dependent->task->Id()
+                << "' due to failed dependency '" << record->task->Id()
+                << "'\n";
+
+            dependent->flags &= ~Record::PENDING;
+            dependent->outstanding = 0;
+            dependent->task->Fail();
+            m_manager->Finalize(dependent->task);
+            sweep.emplace_back(dependentHandle);
+        }
+
+        Release(current);
+    }
+}
+
+void Scheduler::Lib::StandardTaskScheduler::GetStats(SchedulerStats& stats) const
+{
+    m_intakeLatency.Read(stats.intake);
+    m_waitLatency.Read(stats.waiting);
+    ReadExecutorStats(stats.executor);
+}
+
+Scheduler::Lib::SlotHandle Scheduler::Lib::StandardTaskScheduler::Find(
+    const UUID& id) const
+{
+    auto iter = m_handles.find(id);
+    if (iter == m_handles.end()) return INVALID_HANDLE;
+    return iter->second;
 }
 
 Scheduler::Error Scheduler::Lib::StandardTaskScheduler::Initialize()
@@ -96,57 +463,98 @@ Scheduler::Error Scheduler::Lib::StandardTaskScheduler::Initialize()
 }
 
 bool Scheduler::Lib::StandardTaskScheduler::IsTimedOut(
-    const TaskPtr& task) const
+    const Record& record,
+    const Clock::time_point& now) const
 {
-    static Clock::duration TASK_TIMEOUT_INTERVAL = std::chrono::seconds(30);
-
-    assert(task->IsValid());
-    auto iter = m_timeouts.find(task->Id());
-    if (iter == m_timeouts.end()) return false;
-    return iter->second + TASK_TIMEOUT_INTERVAL > Clock::now();
+    if (record.timeout == NPOS) return false;
+    return record.since + TASK_TIMEOUT_INTERVAL < now;
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::HandleTask(TaskPtr& task)
+unsigned Scheduler::Lib::StandardTaskScheduler::Owner(const UUID& id) const
 {
-    assert(task != nullptr);
-    assert(m_active.count(task->Id()) == 0);
-    m_active.insert(task->Id());
+    if (m_shards.empty()) return m_shard;
+    return static_cast<unsigned>(id.Hash() % m_shards.size());
+}
 
-#ifdef SCHEDULER_DEBUGGING
-    Console(std::cout) << "Enqueuing task '" << task->ToString(true)
-        << "' with executor" << '\n';
-#endif  // SCHEDULER_DEBUGGING
+bool Scheduler::Lib::StandardTaskScheduler::HandleTask(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+    assert(!(record->flags & Record::ACTIVE));
 
-    std::weak_ptr<StandardTaskScheduler> self(shared_from_this());
-    TaskRunnerPtr runner = std::make_shared<TaskRunner>(
-        std::move(task),
-        std::move(self));
+    record->flags |= Record::ACTIVE;
 
-    m_executor->Enqueue(runner);
+    size_t priority = static_cast<size_t>(record->task->GetPriority());
+    assert(priority < TASK_PRIORITY_COUNT);
+    m_ready[priority].emplace_back(handle);
     return true;
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::HandleExpiredTask(TaskPtr& task)
+bool Scheduler::Lib::StandardTaskScheduler::HandleExpiredTask(SlotHandle handle)
 {
-    assert(task != nullptr);
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+
+    const TaskPtr& task = record->task;
     assert(task->IsExpired());
 
     if (task->IsActive())
     {
         Console(std::cout) << "Task '" << task->Id()
             << "' expired while running\n";
-        // Cancel the task in the executor
-        task->SetState(TaskState::CANCELLED);
     }
     else
     {
         Console(std::cout) << "Task '" << task->Id()
             << "' expired while in queue\n";
     }
+    return CancelTask(handle);
+}
 
-    PrunePrematureTasks();
-    m_manager->Expire(task->Id());
-    return true;
+bool Scheduler::Lib::StandardTaskScheduler::IsUnqueued(
+    const Task& task,
+    const Clock::time_point& now) const
+{
+    if (task.GetState() != TaskState::NEW) return false;
+    if (task.IsPremature(now)) return false;
+
+    SlotHandle handle = Find(task.Id());
+    if (handle == INVALID_HANDLE) return true;
+    return !(m_tasks.Get(handle)->flags & Record::ADMITTED);
+}
+
+void Scheduler::Lib::StandardTaskScheduler::Link(
+    std::vector<SlotHandle>& list,
+    uint32_t Record::* position,
+    SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+    if (record->*position != NPOS) return;
+
+    record->*position = static_cast<uint32_t>(list.size());
+    list.emplace_back(handle);
+}
+
+Scheduler::Clock::time_point Scheduler::Lib::StandardTaskScheduler::NextExpiry()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return NextExpiryLocked();
+}
+
+Scheduler::Clock::time_point
+Scheduler::Lib::StandardTaskScheduler::NextExpiryLocked() const
+{
+    Clock::time_point lowest = std::min(
+        m_premature.NextExpiry(),
+        m_deadlines.NextExpiry());
+    for (SlotHandle handle : m_timeouts)
+    {
+        const Record* record = m_tasks.Get(handle);
+        if (record->since + TASK_TIMEOUT_INTERVAL < lowest)
+            lowest = record->since + TASK_TIMEOUT_INTERVAL;
+    }
+    return lowest;
 }
 
 void Scheduler::Lib::StandardTaskScheduler::Notify()
@@ -161,12 +569,25 @@ void Scheduler::Lib::StandardTaskScheduler::Notify(
 {
     std::unique_lock<std::mutex> lock(m_mutex);
 
+    // Tasks still running on the executor after shutdown report back to a
+    // scheduler which has already dropped them.
+    if (m_shutdown) return;
+
+    // The task may have been expired and cancelled while the executor was
+    // still running it. There is nothing left to track in that case.
+    SlotHandle handle = Find(task->Id());
+    Record* record = m_tasks.Get(handle);
+    if (!record || !(record->flags & Record::ACTIVE))
+    {
+        assert(state == TaskState::ACTIVE || task->IsComplete());
+        return;
+    }
+
     switch (state)
     {
         case TaskState::ACTIVE:
         {
-            assert(m_pending.count(task->Id()) == 0);
-            m_active.insert(task->Id());
+            assert(!(record->flags & Record::PENDING));
             Console(std::cout) << "Task '" << task->Id()
                 << "' moving to ACTIVE state\n";
             task->SetState(TaskState::ACTIVE);
@@ -174,33 +595,60 @@ void Scheduler::Lib::StandardTaskScheduler::Notify(
         }
         case TaskState::SUCCESS:
         {
-            assert(m_pending.count(task->Id()) == 0);
-            assert(m_active.count(task->Id()) > 0);
-            m_active.erase(task->Id());
+            assert(!(record->flags & Record::PENDING));
+            record->flags &= ~Record::ACTIVE;
+            if (RecurTask(handle)) break;
+
             Console(std::cout) << "Task '" << task->Id()
                 << "' moving to SUCCESS state\n";
             task->SetState(TaskState::SUCCESS);
+            m_completed.emplace_back(handle);
             break;
         }
         case TaskState::FAILED:
         {
-            assert(m_pending.count(task->Id()) == 0);
-            assert(m_active.count(task->Id()) > 0);
-            m_active.erase(task->Id());
+            assert(!(record->flags & Record::PENDING));
+            record->flags &= ~Record::ACTIVE;
             Console(std::cout) << "Task '" << task->Id()
                 << "' moving to FAILURE state\n";
             task->Fail();
+            m_manager->Finalize(task);
+            m_completed.emplace_back(handle);
+            break;
+        }
+        case TaskState::CANCELLED:
+        {
+            // The executor shed the task instead of running it.
+            assert(!(record->flags & Record::PENDING));
+            ShedTask(handle);
             break;
         }
         case TaskState::PENDING:
         {
             assert(task->IsRetryable());
-            assert(m_pending.count(task->Id()) == 0);
-            assert(m_active.count(task->Id()) > 0);
-            m_active.erase(task->Id());
-            m_pending.insert(task->Id());
+            assert(!(record->flags & Record::PENDING));
+            record->flags &= ~Record::ACTIVE;
+
+            Clock::time_point now = Now();
+            if (m_backoff->Retry(*task, now) != E_SUCCESS)
+            {
+                Console(std::cout) << "Task '" << task->Id()
+                    << "' moving to FAILURE state as it is out of retries\n";
+                task->Fail();
+                m_manager->Finalize(task);
+                m_completed.emplace_back(handle);
+                break;
+            }
+
+            // The retry waits on the premature timers like any task with a
+            // start time. The deadline timer stays armed meanwhile.
+            record->flags |= Record::PENDING;
+            m_premature.Schedule(handle, task->After());
             Console(std::cout) << "Task '" << task->Id()
-                << "' moving back to PENDING state for retry\n";
+                << "' moving back to PENDING state for retry "
+                << task->GetRetryCount() << " in: "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    task->After() - now).count() << "ms\n";
             task->SetState(TaskState::PENDING);
             break;
         }
@@ -228,274 +676,567 @@ void Scheduler::Lib::StandardTaskScheduler::NotifyLocked(
     m_cond.notify_all();
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::ProcessActiveTasks()
+bool Scheduler::Lib::StandardTaskScheduler::ProcessCompletedTasks()
+{
+    if (m_completed.empty()) return true;
+
+    // Only the tasks which completed before this pass are resolved. Tasks
+    // which fail are swept along with their dependents, so only a task
+    // failed by something other than a dependency waits for the next pass.
+    std::deque<SlotHandle> completed;
+    completed.swap(m_completed);
+
+    for (SlotHandle handle : completed)
+    {
+        Record* record = m_tasks.Get(handle);
+        if (!record) continue;
+
+        if (record->task->GetState() != TaskState::SUCCESS)
+        {
+            FailDependents(handle);
+            continue;
+        }
+
+        // The manager only keeps the outcome of a finished task. Records
+        // of tasks queued elsewhere are left to their own scheduler.
+        NotifyWatchers(*record);
+        if (record->flags & Record::ADMITTED) m_manager->Finalize(record->task);
+        if (!record->dependents.empty() && !ResolveDependents(handle))
+            return false;
+
+        // Nothing is left waiting on the task so the scheduler is done
+        // with it.
+        Release(handle);
+    }
+    return true;
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::ProcessExpiredTasks(
+    const Clock::time_point& now)
 {
-    if (m_active.empty()) return true;
+    if (m_deadlines.Empty()) return true;
+
+    std::vector<SlotHandle> expired;
+    if (m_deadlines.Expire(now, expired) == 0) return true;
 
-    std::set<UUID> active;
-    for (const UUID& uuid : m_active)
+    for (SlotHandle handle : expired)
     {
-        Error error = E_FAILURE;
+        // Tasks which completed since their timer was armed are released
+        // on the next pass along with the timer.
+        Record* record = m_tasks.Get(handle);
+        if (!record || !(record->flags & (Record::ACTIVE | Record::PENDING)))
+            continue;
 
-        TaskPtr task;
-        if ((error = m_manager->GetTask(uuid, task)) != E_SUCCESS)
+        // The wheel never fires early but may fire on the very instant of
+        // the deadline, which does not count as expired yet.
+        const TaskPtr& task = record->task;
+        if (!(now > task->Before()))
         {
-            assert(m_pending.count(uuid) == 0);
-            Console(std::cout) << "Unknown active task: " << uuid << "(" << error
-                << ")\n";
+            m_deadlines.Schedule(handle, task->Before() + Clock::duration(1));
+            continue;
+        }
+        if (!HandleExpiredTask(handle)) return false;
+    }
+    return true;
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::ProcessPendingQueue(
+    const Clock::time_point& now)
+{
+    if (m_intake.Empty()) return true;
+
+    Clock::time_point start = Clock::now();
+
+    // Take in a bounded batch so completions are not starved while a
+    // producer is flooding the queue, and resolve the whole batch with a
+    // single lookup against the manager.
+    std::vector<UUID> batch;
+    Message message;
+    for (size_t taken = 0; taken < m_intakeBatchSize; ++taken)
+    {
+        if (!m_intake.Pop(message)) break;
+
+        switch (message.type)
+        {
+            case Message::ENQUEUE:
+                batch.emplace_back(std::move(message.id));
+                break;
+            case Message::WATCH:
+                WatchTask(message.task, message.shard);
+                message.task.reset();
+                break;
+            case Message::UNWATCH:
+                UnwatchTask(message.id, message.shard);
+                break;
+            case Message::COMPLETED:
+            {
+                SlotHandle handle = Find(message.id);
+                if (handle != INVALID_HANDLE) m_completed.emplace_back(handle);
+                break;
+            }
+            default:
+                assert(!"Unhandled Message type");
+        }
+    }
+
+    size_t count = batch.size();
+    if (count == 0) return true;
+
+    std::vector<TaskPtr> tasks;
+    m_manager->GetTasks(batch, tasks);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        TaskPtr& task = tasks[i];
+        if (!task)
+        {
+            Console(std::cout) << "Unknown queued task: " << batch[i]
+                << "(" << E_NOT_FOUND << ")\n";
+            m_admission->Release(1);
             continue;
         }
 
         assert(task->IsValid());
 
-        if (task->IsComplete())
+        if (task->IsComplete() || task->IsExpired(now))
         {
-            Console(std::cout) << "Completed task: " << task->Id() << '\n';
-            m_manager->Finalize(task);
+            if (task->IsComplete())
+            {
+                Console(std::cout) << "Task '" << task->Id()
+                    << "' cancelled while in queue\n";
+            }
+            else
+            {
+                Console(std::cout) << "Task '" << task->Id()
+                    << "' expired while in queue\n";
+            }
+            task->SetState(TaskState::CANCELLED);
+            m_manager->Expire(task);
+            m_admission->Release(1);
+
+            // Only tasks which something is already waiting on have a
+            // record to resolve.
+            SlotHandle handle = Find(task->Id());
+            if (handle != INVALID_HANDLE) m_completed.emplace_back(handle);
             continue;
         }
-        if (task->IsExpired())
+
+        // The reference read from the manager moves into the record, which
+        // the loop borrows from here on.
+        SlotHandle handle = Track(std::move(task));
+        Record* record = m_tasks.Get(handle);
+        assert(!(record->flags & Record::ACTIVE));
+        Task* tracked = record->task.get();
+
+        // A task queued more than once only holds room once.
+        if (record->flags & Record::ADMITTED) m_admission->Release(1);
+        record->flags |= Record::ADMITTED;
+
+        tracked->m_times.pending = now;
+        m_intakeLatency.Record(now - tracked->m_times.enqueued);
+
+        if (tracked->IsPremature(now))
         {
-            assert(!task->IsPremature());
-            if (!HandleExpiredTask(task)) return false;
+            m_premature.Schedule(handle, tracked->After());
             continue;
         }
-        active.insert(task->Id());
+        if (!ResolveTask(handle, now)) return false;
     }
-    active.swap(m_active);
+
+    Clock::duration elapsed = Clock::now() - start;
+
+#ifdef SCHEDULER_DEBUGGING
+    Console(std::cout) << "Intake of " << count << " tasks in "
+        << std::chrono::duration_cast<std::chrono::microseconds>(
+            elapsed).count() << "us\n";
+#endif  // SCHEDULER_DEBUGGING
+
+    if (m_reporter) m_reporter->ReportIntake(count, elapsed);
     return true;
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::ProcessPendingQueue()
+bool Scheduler::Lib::StandardTaskScheduler::ProcessPendingTasks(
+    const Clock::time_point& now)
 {
-    if (m_queue.empty()) return true;
+    // Only the pending tasks which are waiting on a dependency that was
+    // never queued need to be visited. Everything else is driven by
+    // completions through the reverse dependency index, and expiry by the
+    // deadline timers.
+    if (m_timeouts.empty()) return true;
+
+    std::vector<SlotHandle> timedOut;
+    for (size_t i = m_timeouts.size(); i-- > 0;)
+    {
+        SlotHandle handle = m_timeouts[i];
+        Record* record = m_tasks.Get(handle);
+        assert(record != nullptr);
 
-    Error error = E_FAILURE;
-    UUID uuid = std::move(m_queue.front());
-    m_queue.pop_front();
+        bool waiting = false;
+        for (const TaskPtr& dep : record->task->GetDependencies())
+        {
+            if (!IsUnqueued(*dep, now)) continue;
+            waiting = true;
+            break;
+        }
 
-    TaskPtr task;
-    if ((error = m_manager->GetTask(uuid, task)) != E_SUCCESS)
+        if (!waiting)
+        {
+            Unlink(m_timeouts, &Record::timeout, handle);
+            continue;
+        }
+        if (IsTimedOut(*record, now)) timedOut.emplace_back(handle);
+    }
+    for (SlotHandle handle : timedOut)
     {
-        assert(m_active.count(uuid) == 0);
-        assert(m_pending.count(uuid) == 0);
+        Console(std::cout) << "Failing task '" << m_tasks.Get(handle)->task->Id()
+            << "' due to time out on dependency\n";
+        FailTask(handle);
+    }
+    return true;
+}
 
-        Console(std::cout) << "Unknown queued task: " << uuid
-            << "(" << error << ")\n";
-        return true;
+void Scheduler::Lib::StandardTaskScheduler::NotifyWatchers(
+    const Record& record)
+{
+    for (unsigned shard : record.watchers)
+    {
+        Message message;
+        message.type = Message::COMPLETED;
+        message.shard = m_shard;
+        message.id = record.task->Id();
+        Post(shard, std::move(message));
     }
+}
 
-    assert(task != nullptr);
-    assert(task->IsValid());
-    assert(m_active.count(task->Id()) == 0);
+void Scheduler::Lib::StandardTaskScheduler::Post(
+    unsigned shard,
+    Message&& message)
+{
+    assert(shard < m_shards.size());
+    assert(shard != m_shard);
+
+    std::shared_ptr<StandardTaskScheduler> target = m_shards[shard].lock();
+    if (!target) return;
 
-    if (task->IsExpired())
+    // The scheduler lock is held while posting so the target is only woken
+    // once the current pass is over. Waking it here would take its lock
+    // while holding ours.
+    if (target->m_intake.Push(std::move(message)))
+        m_wakeups.emplace_back(std::move(target));
+}
+
+void Scheduler::Lib::StandardTaskScheduler::PrunePrematureTasks(
+    const Clock::time_point& now)
+{
+    if (m_premature.Empty()) return;
+
+    std::vector<SlotHandle> ready;
+    if (m_premature.Expire(now, ready) == 0) return;
+
+    for (SlotHandle handle : ready)
     {
-        Console(std::cout) << "Task '" << task->Id()
-            << "' expired while in queue\n";
-        m_manager->Expire(task->Id());
-        return true;
+        Record* record = m_tasks.Get(handle);
+        if (!record || record->task->IsComplete()) continue;
+
+        // Retried and recurring tasks are already pending with every
+        // dependency resolved and only need to be handed back to the executor.
+        if (record->flags & Record::PENDING)
+        {
+            assert(record->outstanding == 0);
+            record->flags &= ~Record::PENDING;
+            HandleTask(handle);
+            continue;
+        }
+        ResolveTask(handle, now);
     }
-    if (task->IsPremature())
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::RecurTask(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    const TaskPtr& task = record->task;
+    if (!task->IsRecurring()) return false;
+
+    Clock::time_point now = Now();
+    if (!task->Recur(now)) return false;
+
+    // The task keeps its record, its identifier and its place with the
+    // manager. Only its start time moves on to the next run, which skips
+    // the premature timers when it is already due.
+    if (task->After() > now)
     {
-        m_premature.emplace(task->Id(), task->After());
-        return true;
+        record->flags |= Record::PENDING;
+        m_premature.Schedule(handle, task->After());
     }
-
-    m_pending.insert(task->Id());
+    else
+    {
+        HandleTask(handle);
+    }
+    Console(std::cout) << "Task '" << task->Id()
+        << "' moving back to PENDING state after run "
+        << task->GetRunCount() << ", next in: "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(
+            task->After() - now).count() << "ms\n";
     task->SetState(TaskState::PENDING);
     return true;
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::ProcessPendingTasks()
+void Scheduler::Lib::StandardTaskScheduler::ReadExecutorStats(
+    ExecutorStats& stats) const
 {
-    if (m_pending.empty()) return false;
+    ExecutorPtr executor;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_executor)
+        {
+            stats.Merge(m_executorStats);
+            return;
+        }
+        executor = m_executor;
+    }
+    executor->GetStats(stats);
+}
 
-    bool failed = false;
+void Scheduler::Lib::StandardTaskScheduler::Release(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    if (!record) return;
 
-    std::set<UUID> pending;
-    for (const UUID& uuid : m_pending)
-    {
-        Error error = E_FAILURE;
+    assert(!(record->flags & (Record::ACTIVE | Record::PENDING)));
+    Unlink(m_timeouts, &Record::timeout, handle);
+    m_premature.Cancel(handle);
+    m_deadlines.Cancel(handle);
 
-#ifdef SCHEDULER_DEBUGGING
-        Console(std::cout) << "Processing pending task: " << uuid << '\n';
-#endif  // SCHEDULER_DEBUGGING
+    if (record->flags & Record::ADMITTED) m_admission->Release(1);
 
-        TaskPtr task;
-        if ((error = m_manager->GetTask(uuid, task)) != E_SUCCESS)
+    // Dependencies which were never queued only have a record for the tasks
+    // waiting on them, so it goes once the last of those has gone.
+    for (const TaskPtr& dep : record->task->GetDependencies())
+    {
+        auto iter = m_handles.find(dep->Id());
+        if (iter == m_handles.end()) continue;
+
+        SlotHandle depHandle = iter->second;
+        Record* depRecord = m_tasks.Get(depHandle);
+        if (depRecord->flags & Record::ADMITTED) continue;
+
+        std::vector<SlotHandle>& dependents = depRecord->dependents;
+        dependents.erase(
+            std::remove(dependents.begin(), dependents.end(), handle),
+            dependents.end());
+        if (!dependents.empty() || !depRecord->watchers.empty()) continue;
+
+        assert(!(depRecord->flags & (Record::ACTIVE | Record::PENDING)));
+        m_handles.erase(iter);
+        m_tasks.Erase(depHandle);
+
+        // The owning shard keeps a record for us while we watch the task.
+        unsigned owner = Owner(dep->Id());
+        if (owner != m_shard)
         {
-            assert(m_active.count(uuid) == 0);
-            Console(std::cout) << "Unknown pending task: " << uuid
-                << "(" << error << ")\n";
-            continue;
+            Message message;
+            message.type = Message::UNWATCH;
+            message.shard = m_shard;
+            message.id = dep->Id();
+            Post(owner, std::move(message));
         }
+    }
 
-        assert(task->IsValid());
-        assert(!task->IsComplete());
-        assert(!task->IsActive());
-        assert(task->GetState() == TaskState::PENDING);
+    m_handles.erase(record->task->Id());
+    m_tasks.Erase(handle);
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::ResolveDependents(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
 
-        if (task->IsExpired())
+    assert(record->task->GetState() == TaskState::SUCCESS);
+
+    std::vector<SlotHandle> dependents = std::move(record->dependents);
+    record->dependents.clear();
+
+    for (SlotHandle dependentHandle : dependents)
+    {
+        // Dependents which have since failed or expired are skipped. Their
+        // handles are stale or they are no longer waiting on anything.
+        Record* dependent = m_tasks.Get(dependentHandle);
+        if (!dependent || !(dependent->flags & Record::PENDING)
+            || dependent->outstanding == 0)
         {
-            assert(pending.count(task->Id()) == 0);
-            if (!HandleExpiredTask(task)) return false;
             continue;
         }
-        if (task->IsPremature())
-        {
-            // This could happen that a task is retried and given an interval which
-            // has not yet occurred. If this is the case, we add it to the premature
-            // list.
-            if (m_premature.find(task->Id()) == m_premature.end())
-                m_premature.emplace(task->Id(), task->After());
 
-            pending.insert(task->Id());
+        if (dependent->task->IsComplete())
+        {
+            CancelTask(dependentHandle);
             continue;
         }
-        if (!task->HasDependencies())
-        {
-            assert(!task->IsExpired());
-            assert(!task->IsPremature());
 
-#ifdef SCHEDULER_DEBUGGING
-            Console(std::cout) << "Processing task with no dependencies: "
-                << task->Id() << '\n';
-#endif  // SCHEDULER_DEBUGGING
+        assert(dependent->task->GetState() == TaskState::PENDING);
+        if (--dependent->outstanding > 0) continue;
 
-            if (!HandleTask(task)) return false;
-            continue;
-        }
+        dependent->flags &= ~Record::PENDING;
+        Unlink(m_timeouts, &Record::timeout, dependentHandle);
+
+        assert(!dependent->task->IsPremature());
+        if (!HandleTask(dependentHandle)) return false;
+    }
+    return true;
+}
+
+bool Scheduler::Lib::StandardTaskScheduler::ResolveTask(
+    SlotHandle handle,
+    const Clock::time_point& now)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+
+    // The record may move as dependencies are tracked below but the task
+    // itself is kept alive by it throughout.
+    Task* task = record->task.get();
+    assert(!task->IsComplete());
+    assert(!task->IsPremature(now));
+    assert(record->outstanding == 0);
+
+    record->flags |= Record::PENDING;
+    if (task->Before() != Clock::time_point::max())
+        m_deadlines.Schedule(handle, task->Before());
+    task->SetState(TaskState::PENDING);
 
-        bool ready = true;
+    bool unqueued = false;
 
-        for (const TaskPtr& dep : task->GetDependencies())
+    // Dependencies owned by other shards can change state while the task is
+    // being resolved so the set waited on is captured once.
+    std::vector<const TaskPtr*> waiting;
+
+    for (const TaskPtr& dep : task->GetDependencies())
+    {
+        if (dep->GetState() == TaskState::SUCCESS) continue;
+        if (dep->IsComplete())
         {
-            if (dep->GetState() == TaskState::SUCCESS) continue;
-            if (dep->IsPremature()) ready = false;
-            else if (dep->GetState() == TaskState::FAILED)
-            {
-                ready = false;
-                Console(std::cout) << "Failing task '" << task->Id()
-                    << "' due to failed dependency '" << dep->Id() << "'\n";
-                task->Fail();
-                failed = true;
-                break;
-            }
-            else if (dep->IsExpired())
-            {
-                ready = false;
-                Console(std::cout) << "Failing task '" << task->Id()
-                    << "' due to expired dependency '" << dep->Id() << "'\n";
-                task->Fail();
-                failed = true;
-                break;
-            }
-            else if (dep->GetState() == TaskState::NEW)
-            {
-                ready = false;
-                if (IsTimedOut(task))
-                {
-                    Console(std::cout) << "Failing task '" << task->Id()
-                        << "' due to time out on dependency\n";
-                    task->Fail();
-                    failed = true;
-                    break;
-                }
-                else
-                {
-                    if (m_timeouts.find(task->Id()) == m_timeouts.end())
-                        m_timeouts.emplace(task->Id(), Clock::now());
-
-                    Console(std::cout) << "Task '" << task->Id()
-                        << "' is waiting on a unqueued dependency '" << dep->Id()
-                        << "'\n";
-                }
-            }
-            else if (m_pending.count(dep->Id()))
-            {
-                // assert(dep->GetState() == TaskState::PENDING);
-                ready = false;
-            }
-            else if (m_active.count(dep->Id()))
-            {
-                // assert(dep->GetState() == TaskState::ACTIVE);
-                ready = false;
-            }
-            if (!ready) break;
+            Console(std::cout) << "Failing task '" << task->Id()
+                << "' due to failed dependency '" << dep->Id() << "'\n";
+            FailTask(handle);
+            return true;
         }
-
-        if (ready)
+        if (dep->IsExpired(now))
         {
-            assert(!task->IsComplete());
-            if (!HandleTask(task)) return false;
-            continue;
+            Console(std::cout) << "Failing task '" << task->Id()
+                << "' due to expired dependency '" << dep->Id() << "'\n";
+            FailTask(handle);
+            return true;
         }
+        if (IsUnqueued(*dep, now))
+        {
+            Console(std::cout) << "Task '" << task->Id()
+                << "' is waiting on a unqueued dependency '" << dep->Id()
+                << "'\n";
+            unqueued = true;
+        }
+        waiting.emplace_back(&dep);
+    }
 
-        // Tasks with dependencies
-        if (!task->IsComplete()) pending.insert(task->Id());
+    if (waiting.empty())
+    {
+#ifdef SCHEDULER_DEBUGGING
+        Console(std::cout) << "Processing task with no dependencies: "
+            << task->Id() << '\n';
+#endif  // SCHEDULER_DEBUGGING
+
+        record->flags &= ~Record::PENDING;
+        return HandleTask(handle);
     }
 
-    // After we determine the remaining pending UUIDs we can swap the stored
-    // list for the newly generated one and move on.
-    pending.swap(m_pending);
-    return failed;
-}
+    for (const TaskPtr* dep : waiting)
+    {
+        const UUID& id = (*dep)->Id();
+        SlotHandle depHandle = Track(*dep);
+        Record* depRecord = m_tasks.Get(depHandle);
+
+        // The first task on this shard to wait on a task owned by another
+        // shard asks the owner to report back once it completes.
+        unsigned owner = Owner(id);
+        if (depRecord->dependents.empty() && owner != m_shard)
+        {
+            Message message;
+            message.type = Message::WATCH;
+            message.shard = m_shard;
+            message.id = id;
+            message.task = *dep;
+            Post(owner, std::move(message));
+        }
+        depRecord->dependents.emplace_back(handle);
+    }
 
-void Scheduler::Lib::StandardTaskScheduler::PrunePrematureTasks()
-{
-    for (auto iter = m_premature.begin(); iter != m_premature.end();)
+    record = m_tasks.Get(handle);
+    record->outstanding = static_cast<uint32_t>(waiting.size());
+    if (unqueued)
     {
-        if (Clock::now() < iter->second)
-            iter = m_premature.erase(iter);
-        else
-            ++iter;
+        record->since = now;
+        Link(m_timeouts, &Record::timeout, handle);
     }
+    return true;
 }
 
-bool Scheduler::Lib::StandardTaskScheduler::RunOnce()
+bool Scheduler::Lib::StandardTaskScheduler::Pass(
+    std::unique_lock<std::mutex>& lock)
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    Error error = E_FAILURE;
-
+    assert(lock.owns_lock());
     if (m_shutdown)
     {
-        assert(m_queue.empty());
-        assert(m_active.empty());
-        assert(m_pending.empty());
+        assert(m_tasks.Empty());
 
         m_shutdownComplete = true;
         m_cond.notify_all();
         return false;
     }
 
-    // Process tasks
-    if (!m_queue.empty())
+    // Every check in the pass is made against a single reading of the
+    // clock rather than one per task.
+    Clock::time_point now = Now();
+    if (!ProcessPendingQueue(now)) return false;
+    if (!ProcessCompletedTasks()) return false;
+    if (!ProcessExpiredTasks(now)) return false;
+    if (!ProcessPendingTasks(now)) return false;
+    PrunePrematureTasks(now);
+    DispatchReadyTasks(now);
+
+    if (!m_wakeups.empty())
     {
-        if (!ProcessPendingQueue()) return false;
-        return true;
+        std::vector<std::shared_ptr<StandardTaskScheduler>> wakeups;
+        wakeups.swap(m_wakeups);
+
+        lock.unlock();
+        for (auto& shard : wakeups) shard->Notify();
+        wakeups.clear();
+        lock.lock();
     }
+    return true;
+}
 
-    if (!ProcessActiveTasks()) return false;
-    if (ProcessPendingTasks()) return true;
+bool Scheduler::Lib::StandardTaskScheduler::RunOnce()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!Pass(lock)) return false;
 
-    // Wait for new tasks to come in
+    // Shutdown only signals a scheduler which is waiting, so one which came
+    // in while the lock was released is picked up on the next pass.
+    if (m_shutdown) return true;
+    if (!m_intake.Empty() || !m_completed.empty()) return true;
+
+    // Wait for new tasks to come in. Producers only take the lock to wake
+    // the scheduler when it has parked itself on the intake queue.
 
     assert(!m_waiting);
     m_waiting = true;
-    if (!m_notify)
+    if (!m_notify && m_intake.Park())
     {
         Clock::duration timeout = std::chrono::milliseconds(-1);
-
-        if (!m_premature.empty())
+        Clock::time_point lowest = NextExpiryLocked();
+        if (lowest != Clock::time_point::max())
         {
-            Clock::time_point now = Clock::now();
-            Clock::time_point lowest = now;
-
-            for (const auto& point : m_premature)
-                if (point.second < lowest)
-                    lowest = point.second;
-
+            Clock::time_point now = Now();
             if (lowest < now)
                 timeout = std::chrono::seconds(0);
             else
@@ -514,12 +1255,37 @@ bool Scheduler::Lib::StandardTaskScheduler::RunOnce()
 
     assert(lock.owns_lock());
     assert(m_waiting);
+    m_intake.Unpark();
     m_notify = false;
     m_waiting = false;
-    PrunePrematureTasks();
     return true;
 }
 
+void Scheduler::Lib::StandardTaskScheduler::ShedTask(SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    assert(record != nullptr);
+    assert(record->flags & Record::ACTIVE);
+
+    record->flags &= ~Record::ACTIVE;
+
+    // Dependents are failed the same as for a task which expired.
+    record->task->SetState(TaskState::CANCELLED);
+    m_manager->Expire(record->task);
+    m_completed.emplace_back(handle);
+}
+
+void Scheduler::Lib::StandardTaskScheduler::SetShards(
+    unsigned shard,
+    const std::vector<std::weak_ptr<StandardTaskScheduler>>& shards)
+{
+    assert(shard < shards.size());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_shard = shard;
+    m_shards = shards;
+}
+
 std::shared_ptr<Scheduler::Lib::StandardTaskScheduler>
 Scheduler::Lib::StandardTaskScheduler::shared_from_this()
 {
@@ -552,20 +1318,17 @@ void Scheduler::Lib::StandardTaskScheduler::Shutdown(bool wait)
     if(m_reporter) reporter = std::move(m_reporter);
     m_reporter.reset();
 
-    std::deque<UUID> queue = std::move(m_queue);
-    m_queue.clear();
-
-    std::set<UUID> active = std::move(m_active);
-    m_active.clear();
+    m_intake.Clear();
+    m_admission->Shutdown();
 
-    std::set<UUID> pending = std::move(m_pending);
-    m_pending.clear();
-
-    auto premature = std::move(m_premature);
-    m_premature.clear();
-
-    auto timeouts = std::move(m_timeouts);
+    m_tasks.Clear();
+    m_handles.clear();
     m_timeouts.clear();
+    m_completed.clear();
+    for (auto& ready : m_ready) ready.clear();
+    m_premature.Clear();
+    m_deadlines.Clear();
+    m_wakeups.clear();
 
     if (m_waiting) NotifyLocked(lock);
     lock.unlock();
@@ -576,6 +1339,13 @@ void Scheduler::Lib::StandardTaskScheduler::Shutdown(bool wait)
 
     executor->Shutdown(wait);
 
+    // The executor goes with the scheduler, so what it recorded is kept.
+    ExecutorStats executorStats;
+    executor->GetStats(executorStats);
+    lock.lock();
+    m_executorStats = std::move(executorStats);
+    lock.unlock();
+
 #ifdef SCHEDULER_DEBUGGING
     Console(std::cout) << "Shutting down manager\n";
 #endif  // SCHEDULER_DEBUGGING
@@ -583,14 +1353,12 @@ void Scheduler::Lib::StandardTaskScheduler::Shutdown(bool wait)
     manager->Shutdown(wait);
     if (reporter) reporter->Shutdown(wait);
 
-    for (const UUID& id : queue) (void)id;
-    for (const UUID& id : active) (void)id;
-    for (const UUID& id : pending) (void)id;
-    for (const auto& id : premature) (void)id;
-
     if (!wait) return;
 
     lock.lock();
+
+    // A scheduler which was only ever stepped has no loop left to finish.
+    if (!m_thread.joinable()) m_shutdownComplete = true;
     while (!m_shutdownComplete) m_cond.wait(lock);
 
     if (m_thread.joinable()) m_thread.join();
@@ -599,6 +1367,13 @@ void Scheduler::Lib::StandardTaskScheduler::Shutdown(bool wait)
     reporter.reset();
 }
 
+bool Scheduler::Lib::StandardTaskScheduler::Step()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!Pass(lock)) return false;
+    return !m_intake.Empty() || !m_completed.empty();
+}
+
 void Scheduler::Lib::StandardTaskScheduler::Start()
 {
     std::shared_ptr<StandardTaskScheduler> self(shared_from_this());
@@ -606,3 +1381,98 @@ void Scheduler::Lib::StandardTaskScheduler::Start()
         self->Run();
     });
 }
+
+Scheduler::Lib::SlotHandle Scheduler::Lib::StandardTaskScheduler::Track(
+    const TaskPtr& task)
+{
+    auto iter = m_handles.find(task->Id());
+    if (iter != m_handles.end()) return iter->second;
+
+    Record record;
+    record.task = task;
+    SlotHandle handle = m_tasks.Insert(std::move(record));
+    m_handles.emplace(task->Id(), handle);
+    return handle;
+}
+
+Scheduler::Lib::SlotHandle Scheduler::Lib::StandardTaskScheduler::Track(
+    TaskPtr&& task)
+{
+    auto iter = m_handles.find(task->Id());
+    if (iter != m_handles.end()) return iter->second;
+
+    Record record;
+    record.task = std::move(task);
+    SlotHandle handle = m_tasks.Insert(std::move(record));
+    m_handles.emplace(m_tasks.Get(handle)->task->Id(), handle);
+    return handle;
+}
+
+void Scheduler::Lib::StandardTaskScheduler::Unlink(
+    std::vector<SlotHandle>& list,
+    uint32_t Record::* position,
+    SlotHandle handle)
+{
+    Record* record = m_tasks.Get(handle);
+    if (!record || record->*position == NPOS) return;
+
+    uint32_t index = record->*position;
+    assert(index < list.size() && list[index] == handle);
+
+    SlotHandle last = list.back();
+    list[index] = last;
+    list.pop_back();
+    if (last != handle) m_tasks.Get(last)->*position = index;
+    record->*position = NPOS;
+}
+
+void Scheduler::Lib::StandardTaskScheduler::WatchTask(
+    TaskPtr& task,
+    unsigned shard)
+{
+    assert(task != nullptr);
+    assert(Owner(task->Id()) == m_shard);
+
+    // The task may have finished before the watch arrived, in which case its
+    // completion has already gone by and is reported straight back.
+    if (task->IsComplete() || task->IsExpired())
+    {
+        Message message;
+        message.type = Message::COMPLETED;
+        message.shard = m_shard;
+        message.id = task->Id();
+        Post(shard, std::move(message));
+        return;
+    }
+
+    Record* record = m_tasks.Get(Track(task));
+    std::vector<unsigned>& watchers = record->watchers;
+    if (std::find(watchers.begin(), watchers.end(), shard) == watchers.end())
+        watchers.emplace_back(shard);
+}
+
+void Scheduler::Lib::StandardTaskScheduler::UnwatchTask(
+    const UUID& id,
+    unsigned shard)
+{
+    assert(Owner(id) == m_shard);
+
+    // The task may have completed and been released since the watch.
+    auto iter = m_handles.find(id);
+    if (iter == m_handles.end()) return;
+
+    SlotHandle handle = iter->second;
+    Record* record = m_tasks.Get(handle);
+    std::vector<unsigned>& watchers = record->watchers;
+    watchers.erase(
+        std::remove(watchers.begin(), watchers.end(), shard),
+        watchers.end());
+
+    // A queued task is released once it completes, as usual.
+    if (record->flags & Record::ADMITTED) return;
+    if (!watchers.empty() || !record->dependents.empty()) return;
+
+    assert(!(record->flags & (Record::ACTIVE | Record::PENDING)));
+    m_handles.erase(iter);
+    m_tasks.Erase(handle);
+}
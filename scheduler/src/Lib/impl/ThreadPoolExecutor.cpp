@@ -21,10 +21,15 @@ Scheduler::Lib::ThreadPoolExecutor::~ThreadPoolExecutor()
 
 Scheduler::Error Scheduler::Lib::ThreadPoolExecutor::Cancel(const UUID& id)
 {
-    return E_SUCCESS;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return E_NOT_FOUND;
+
+    // Tasks are always queued on the worker their ID hashes to.
+    size_t hash = std::hash<UUID>{}(id);
+    return m_workers[hash % m_params.concurrency]->Cancel(id);
 }
 
-void Scheduler::Lib::ThreadPoolExecutor::Enqueue(TaskRunnerPtr& task)
+void Scheduler::Lib::ThreadPoolExecutor::Enqueue(TaskRunnerPtr&& task)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     unsigned concurrency = m_params.concurrency;
@@ -40,14 +45,29 @@ void Scheduler::Lib::ThreadPoolExecutor::Enqueue(TaskRunnerPtr& task)
     Console(std::cout) << "Executor accepted task: " << task->Id() << '\n';
 #endif  // THREAD_POOL_DEBUGGING
 
-    TaskRunnerPtr taskPtr = task->shared_from_this();
-    size_t hash = std::hash<UUID>{}(taskPtr->Id());
-    m_workers[hash % concurrency]->Enqueue(std::move(taskPtr));
+    size_t hash = std::hash<UUID>{}(task->Id());
 
 #ifdef THREAD_POOL_DEBUGGING
     Console(std::cout) << "Task '" << task->Id() << "' enqueued on worker '"
         << (hash % concurrency) << "'\n";
 #endif  // THREAD_POOL_DEBUGGING
+
+    m_workers[hash % concurrency]->Enqueue(std::move(task));
+}
+
+void Scheduler::Lib::ThreadPoolExecutor::GetWorkerStats(
+    std::vector<ExecutorStats>& stats) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+    {
+        stats = m_retired;
+        return;
+    }
+
+    stats.assign(m_workers.size(), ExecutorStats());
+    for (size_t i = 0; i < m_workers.size(); ++i)
+        m_workers[i]->GetStats(stats[i]);
 }
 
 Scheduler::Error Scheduler::Lib::ThreadPoolExecutor::Initialize()
@@ -58,7 +78,10 @@ Scheduler::Error Scheduler::Lib::ThreadPoolExecutor::Initialize()
     for (unsigned i = 0; i < concurrency; ++i)
     {
         std::weak_ptr<ThreadPoolExecutor> self(shared_from_this());
-        WorkerPtr worker(new ThreadPoolWorker(std::move(self)));
+        WorkerPtr worker(new ThreadPoolWorker(
+            std::move(self),
+            m_params.agingInterval,
+            m_params.dispatchPolicy));
         worker->Start();
 
         m_workers.emplace_back(std::move(worker));
@@ -98,5 +121,12 @@ void Scheduler::Lib::ThreadPoolExecutor::Shutdown(bool wait)
 #endif  // THREAD_POOL_DEBUGGING
 
     for (WorkerPtr& worker : workers) worker->Shutdown(wait);
+
+    // The workers go with the executor, so what they recorded is kept.
+    std::vector<ExecutorStats> retired(workers.size());
+    for (size_t i = 0; i < workers.size(); ++i) workers[i]->GetStats(retired[i]);
     workers.clear();
+
+    lock.lock();
+    m_retired = std::move(retired);
 }
@@ -2,6 +2,7 @@
 
 #include <Scheduler/Common/Console.h>
 #include <Scheduler/Lib/ThreadPoolExecutor.h>
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
@@ -9,13 +10,29 @@
 // #define THREAD_POOL_DEBUGGING 1
 
 Scheduler::Lib::ThreadPoolWorker::ThreadPoolWorker(
-    std::weak_ptr<ThreadPoolExecutor>&& executor)
+    std::weak_ptr<ThreadPoolExecutor>&& executor,
+    const Clock::duration& agingInterval,
+    DispatchPolicy policy)
     : m_executor(std::move(executor)),
+      m_agingInterval(agingInterval),
+      m_policy(policy),
       m_threadId(std::thread::id())
 { }
 
 Scheduler::Lib::ThreadPoolWorker::~ThreadPoolWorker() { Shutdown(); }
 
+Scheduler::Error Scheduler::Lib::ThreadPoolWorker::Cancel(const UUID& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto iter = m_index.find(id);
+    if (iter == m_index.end()) return E_NOT_FOUND;
+
+    iter->second->Cancel();
+    m_index.erase(iter);
+    return E_SUCCESS;
+}
+
 void Scheduler::Lib::ThreadPoolWorker::Enqueue(TaskRunnerPtr&& task)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -24,11 +41,25 @@ void Scheduler::Lib::ThreadPoolWorker::Enqueue(TaskRunnerPtr&& task)
     Console(std::cout) << "Worker enqueued task: " << task->Id() << '\n';
 #endif  // THREAD_POOL_DEBUGGING
 
-    assert(m_threadId != std::this_thread::get_id());
+    // The worker may queue onto itself when a task it ran makes another
+    // ready, as with the decentralized scheduler. The lock is never held
+    // while a task runs so that is safe.
     assert(task->IsValid());
 
     if (m_shutdown) return;
-    m_queue.emplace_back(std::move(task));
+
+    size_t priority = static_cast<size_t>(task->Priority());
+    assert(priority < TASK_PRIORITY_COUNT);
+    Clock::time_point deadline = Clock::time_point::max();
+    if (m_policy == DispatchPolicy::DEADLINE) deadline = task->Before();
+
+    m_index[task->Id()] = task.get();
+
+    std::vector<Entry>& queue = m_queues[priority];
+    queue.emplace_back(Entry{
+        std::move(task), Now(), deadline, m_sequence++ });
+    std::push_heap(queue.begin(), queue.end());
+    ++m_queued;
     if (m_waiting) m_cond.notify_all();
 }
 
@@ -38,6 +69,58 @@ Scheduler::Lib::ThreadPoolWorker::Id() const
     return std::hash<std::thread::id>{}(m_threadId);
 }
 
+bool Scheduler::Lib::ThreadPoolWorker::Pop(TaskRunnerPtr& task)
+{
+    if (m_queued == 0) return false;
+
+    size_t best = TASK_PRIORITY_COUNT;
+    for (size_t priority = TASK_PRIORITY_COUNT; priority-- > 0;)
+    {
+        if (m_queues[priority].empty()) continue;
+        best = priority;
+        break;
+    }
+
+    // Once per aging interval the task which has waited the longest gets
+    // to go ahead of the higher classes, provided it has waited at least a
+    // full interval. Only the head of each class is looked at, which is its
+    // oldest task unless the class is ordered by deadline.
+    if (m_agingInterval > Clock::duration::zero())
+    {
+        Clock::time_point now = Now();
+        if (now - m_aged >= m_agingInterval)
+        {
+            Clock::time_point oldest = now - m_agingInterval;
+            size_t aged = TASK_PRIORITY_COUNT;
+            for (size_t priority = 0; priority < best; ++priority)
+            {
+                const std::vector<Entry>& queue = m_queues[priority];
+                if (queue.empty() || queue.front().queued > oldest) continue;
+
+                aged = priority;
+                oldest = queue.front().queued;
+            }
+            if (aged != TASK_PRIORITY_COUNT)
+            {
+                best = aged;
+                m_aged = now;
+            }
+        }
+    }
+
+    assert(best < TASK_PRIORITY_COUNT);
+    std::vector<Entry>& queue = m_queues[best];
+    std::pop_heap(queue.begin(), queue.end());
+    task = std::move(queue.back().task);
+    queue.pop_back();
+    --m_queued;
+
+    // A task queued more than once is indexed by its latest runner.
+    auto iter = m_index.find(task->Id());
+    if (iter != m_index.end() && iter->second == task.get()) m_index.erase(iter);
+    return true;
+}
+
 void Scheduler::Lib::ThreadPoolWorker::Run()
 {
     assert(m_threadId == std::thread::id());
@@ -68,7 +151,7 @@ bool Scheduler::Lib::ThreadPoolWorker::RunOnce()
 
     if (m_shutdown)
     {
-        assert(m_queue.empty());
+        assert(m_queued == 0);
         m_shutdownComplete = true;
         lock.unlock();
 
@@ -77,7 +160,7 @@ bool Scheduler::Lib::ThreadPoolWorker::RunOnce()
     }
 
     assert(!m_waiting);
-    if (m_queue.empty())
+    if (m_queued == 0)
     {
         m_waiting = true;
         m_cond.wait(lock);
@@ -86,14 +169,24 @@ bool Scheduler::Lib::ThreadPoolWorker::RunOnce()
         m_waiting = false;
     }
     if (m_shutdown) return true;
-    if (m_queue.empty()) return true;
 
     assert(lock.owns_lock());
-    TaskRunnerPtr task = std::move(m_queue.front());
-    m_queue.pop_front();
+    TaskRunnerPtr task;
+    if (!Pop(task)) return true;
 
     lock.unlock();
-    task->Run();
+
+    // Running a task which is bound to miss its deadline only takes the
+    // worker away from those which can still make theirs. Tombstones are
+    // left for the runner to drop.
+    if (m_policy == DispatchPolicy::DEADLINE && !task->IsCancelled()
+        && !task->IsFeasible(Now()))
+    {
+        task->Shed();
+        return true;
+    }
+
+    task->Run(&m_histograms);
     return true;
 }
 
@@ -111,8 +204,10 @@ void Scheduler::Lib::ThreadPoolWorker::Shutdown(bool wait)
 
     m_shutdown = true;
 
-    std::deque<TaskRunnerPtr> queue = std::move(m_queue);
-    m_queue.clear();
+    auto queues = std::move(m_queues);
+    for (auto& queue : m_queues) queue.clear();
+    m_queued = 0;
+    m_index.clear();
 
     lock.unlock();
     m_cond.notify_all();
@@ -49,6 +49,24 @@ namespace Tests {
         bool m_retried = false;
     };
 
+    /// Task which asks to be retried every time it runs.
+    class Unavailable : public Lib::ImmutableTask<Unavailable>
+    {
+    public:
+        ~Unavailable() { }
+
+    protected:
+        using Lib::ImmutableTask<Unavailable>::ImmutableTask;
+
+    private:
+        Clock::duration GetRetryInterval() const override
+        {
+            return std::chrono::milliseconds(1);
+        }
+
+        Lib::TaskResult Run(Lib::ResultPtr&) override { return Lib::TaskResult::RETRY; }
+    };
+
     class Success : public Lib::ImmutableTask<Success>
     {
     public:
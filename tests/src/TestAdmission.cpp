@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Admission.h>
+#include <atomic>
+#include <thread>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(Admission, AcquireUpToCapacity)
+{
+    Admission admission(4);
+
+    ASSERT_TRUE(admission.TryAcquire(3));
+    ASSERT_FALSE(admission.TryAcquire(2));
+    ASSERT_TRUE(admission.TryAcquire(1));
+    ASSERT_EQ(admission.Used(), 4U);
+    ASSERT_EQ(admission.Acquire(1, milliseconds(5)), E_FULL);
+
+    admission.Release(2);
+    ASSERT_EQ(admission.Acquire(2, Clock::duration::zero()), E_SUCCESS);
+
+    // Forcing goes past the capacity, which then has to drain before
+    // anything else is admitted.
+    admission.Force(2);
+    admission.Release(2);
+    ASSERT_FALSE(admission.TryAcquire(1));
+    admission.Release(1);
+    ASSERT_TRUE(admission.TryAcquire(1));
+
+    // More than the whole capacity can never be admitted.
+    admission.Release(4);
+    ASSERT_EQ(admission.Acquire(5, seconds(60)), E_FULL);
+}
+
+TEST(Admission, UnboundedAdmitsEverything)
+{
+    Admission admission;
+    for (int i = 0; i < 100; ++i) ASSERT_TRUE(admission.TryAcquire(1000));
+    ASSERT_EQ(admission.Used(), 100000U);
+}
+
+TEST(Admission, BlockedAcquireWokenByRelease)
+{
+    Admission admission(1);
+    ASSERT_TRUE(admission.TryAcquire(1));
+
+    std::atomic<bool> acquired{false};
+    std::thread producer([&]{
+        ASSERT_EQ(admission.Acquire(1, seconds(60)), E_SUCCESS);
+        acquired = true;
+    });
+
+    std::this_thread::sleep_for(milliseconds(20));
+    ASSERT_FALSE(acquired);
+
+    admission.Release(1);
+    producer.join();
+    ASSERT_TRUE(acquired);
+    ASSERT_EQ(admission.Used(), 1U);
+}
+
+TEST(Admission, ShutdownCancelsWaiters)
+{
+    Admission admission(1);
+    ASSERT_TRUE(admission.TryAcquire(1));
+
+    std::thread producer([&]{
+        ASSERT_EQ(admission.Acquire(1, seconds(60)), E_CANCELLED);
+    });
+
+    std::this_thread::sleep_for(milliseconds(20));
+    admission.Shutdown();
+    producer.join();
+    ASSERT_EQ(admission.Acquire(1, Clock::duration::zero()), E_CANCELLED);
+}
+
+TEST(Admission, UnboundedTimeoutWaitsForRelease)
+{
+    Admission admission(1);
+    ASSERT_TRUE(admission.TryAcquire(1));
+
+    // The longest timeout cannot be added to the clock and has to wait
+    // rather than give up straight away.
+    std::atomic<bool> acquired{false};
+    std::thread producer([&]{
+        ASSERT_EQ(admission.Acquire(1, Clock::duration::max()), E_SUCCESS);
+        acquired = true;
+    });
+
+    std::this_thread::sleep_for(milliseconds(20));
+    ASSERT_FALSE(acquired);
+
+    admission.Release(1);
+    producer.join();
+    ASSERT_TRUE(acquired);
+}
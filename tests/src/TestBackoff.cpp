@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Backoff.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Tests/Tasks.h>
+#include <set>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(Backoff, DelaysGrowWithJitterUpToCap)
+{
+    Backoff backoff(milliseconds(500));
+
+    // The first delay is at least the interval and at most three times it.
+    // Each one after grows from the last, up to the cap.
+    Clock::duration previous = Clock::duration::zero();
+    for (int i = 0; i < 16; ++i)
+    {
+        Clock::duration delay = backoff.Next(milliseconds(10), previous);
+        ASSERT_GE(delay, milliseconds(10));
+        ASSERT_LE(delay, std::max(previous, Clock::duration(milliseconds(10))) * 3);
+        ASSERT_LE(delay, milliseconds(500));
+        previous = delay;
+    }
+
+    // Delays for tasks which failed together are spread out.
+    std::set<Clock::rep> delays;
+    for (int i = 0; i < 32; ++i)
+        delays.insert(backoff.Next(milliseconds(10)).count());
+    ASSERT_GT(delays.size(), 1U);
+
+    // An interval longer than the cap is still honoured.
+    ASSERT_EQ(backoff.Next(seconds(1), seconds(1)), Clock::duration(seconds(1)));
+}
+
+TEST(Backoff, RetryCountsAgainstTaskLimit)
+{
+    Backoff backoff(seconds(1));
+    TaskPtr task = Task::Create<Unavailable>();
+    task->SetRetryLimit(2);
+
+    Clock::time_point now = Clock::now();
+    ASSERT_EQ(backoff.Retry(*task, now), E_SUCCESS);
+    ASSERT_EQ(task->GetRetryCount(), 1U);
+    ASSERT_GT(task->After(), now);
+    ASSERT_TRUE(task->IsPremature());
+
+    ASSERT_EQ(backoff.Retry(*task, now), E_SUCCESS);
+    ASSERT_EQ(task->GetRetryCount(), 2U);
+
+    // The task is out of retries and left as it was.
+    Clock::time_point after = task->After();
+    ASSERT_EQ(backoff.Retry(*task, now), E_FULL);
+    ASSERT_EQ(task->GetRetryCount(), 2U);
+    ASSERT_EQ(task->After(), after);
+}
+
+TEST(Backoff, BudgetRefillsOverTime)
+{
+    Clock::time_point now = Clock::now();
+    Backoff backoff(seconds(1), 2, now);
+
+    TaskPtr taskA = Task::Create<Unavailable>(),
+            taskB = Task::Create<Unavailable>(),
+            taskC = Task::Create<Unavailable>();
+
+    ASSERT_EQ(backoff.Retry(*taskA, now), E_SUCCESS);
+    ASSERT_EQ(backoff.Retry(*taskB, now), E_SUCCESS);
+    ASSERT_EQ(backoff.Retry(*taskC, now), E_FULL);
+    ASSERT_EQ(taskC->GetRetryCount(), 0U);
+
+    // Half a second brings back one retry of the two a second allowed.
+    now += milliseconds(500);
+    ASSERT_EQ(backoff.Retry(*taskC, now), E_SUCCESS);
+    ASSERT_EQ(backoff.Retry(*taskC, now), E_FULL);
+
+    // The budget never holds more than a second's worth.
+    now += seconds(10);
+    ASSERT_EQ(backoff.Retry(*taskA, now), E_SUCCESS);
+    ASSERT_EQ(backoff.Retry(*taskB, now), E_SUCCESS);
+    ASSERT_EQ(backoff.Retry(*taskC, now), E_FULL);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Common/Clock.h>
+#include <thread>
+
+using namespace Scheduler;
+using std::chrono::milliseconds;
+
+TEST(CoarseClock, TicksAtItsPrecision)
+{
+    CoarseClock clock(milliseconds(2));
+    ASSERT_EQ(clock.GetPrecision(), milliseconds(2));
+
+    Clock::time_point first = clock.Now();
+    ASSERT_LE(first, Clock::now());
+
+    // Readings only move when the ticker comes round.
+    std::this_thread::sleep_for(milliseconds(20));
+    Clock::time_point second = clock.Now();
+    ASSERT_GT(second, first);
+    ASSERT_LE(second, Clock::now());
+}
+
+TEST(CoarseClock, NeverGoesBack)
+{
+    CoarseClock clock(std::chrono::microseconds(50));
+    Clock::time_point last = clock.Now();
+    for (int i = 0; i < 100000; ++i)
+    {
+        Clock::time_point now = clock.Now();
+        ASSERT_GE(now, last);
+        last = now;
+    }
+}
+
+TEST(CoarseClock, InstallsAsTimeSource)
+{
+    CoarseClock clock;
+    ASSERT_EQ(SetTimeSource(&clock), nullptr);
+    Clock::time_point now = Now();
+    ASSERT_LE(now, clock.Now());
+    ASSERT_EQ(SetTimeSource(nullptr), &clock);
+}
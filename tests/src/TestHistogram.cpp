@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Histogram.h>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+
+TEST(Histogram, BucketsKeepRelativePrecision)
+{
+    // Small values are exact.
+    for (uint64_t ticks = 0; ticks < 64; ++ticks)
+    {
+        ASSERT_EQ(HistogramBuckets::Index(ticks), ticks);
+        ASSERT_EQ(HistogramBuckets::Highest(ticks), ticks);
+    }
+
+    // Every value falls in a bucket whose top is within 1/32 of it, and
+    // the buckets follow on from each other without gaps.
+    size_t last = HistogramBuckets::Index(63);
+    for (uint64_t ticks = 64; ticks < (uint64_t(1) << 20); ++ticks)
+    {
+        size_t index = HistogramBuckets::Index(ticks);
+        uint64_t highest = HistogramBuckets::Highest(index);
+        ASSERT_GE(highest, ticks);
+        ASSERT_LE(highest - ticks, ticks / HistogramBuckets::SUB_BUCKETS);
+        ASSERT_GE(index, last);
+        ASSERT_LE(index, last + 1);
+        last = index;
+    }
+
+    // Values beyond the range land in the last bucket.
+    ASSERT_EQ(HistogramBuckets::Index(UINT64_MAX), HistogramBuckets::COUNT - 1);
+}
+
+TEST(Histogram, Percentiles)
+{
+    Histogram histogram;
+    HistogramSnapshot empty;
+    histogram.Read(empty);
+    ASSERT_EQ(empty.GetCount(), 0u);
+    ASSERT_EQ(empty.Percentile(50), Clock::duration::zero());
+    ASSERT_EQ(empty.GetMin(), Clock::duration::zero());
+
+    for (int i = 1; i <= 1000; ++i) histogram.Record(microseconds(i));
+    histogram.Record(nanoseconds(-5));
+
+    HistogramSnapshot snapshot;
+    histogram.Read(snapshot);
+    ASSERT_EQ(snapshot.GetCount(), 1001u);
+    ASSERT_EQ(snapshot.GetMin(), Clock::duration::zero());
+    ASSERT_EQ(snapshot.GetMax(), microseconds(1000));
+    ASSERT_EQ(snapshot.Percentile(100), microseconds(1000));
+    ASSERT_EQ(snapshot.Percentile(0), Clock::duration::zero());
+
+    // Percentiles are accurate to the bucket width.
+    Clock::duration median = snapshot.Percentile(50);
+    ASSERT_GE(median, microseconds(500));
+    ASSERT_LE(median, microseconds(500) + microseconds(500) / 32);
+
+    Clock::duration tail = snapshot.Percentile(99);
+    ASSERT_GE(tail, microseconds(990));
+    ASSERT_LE(tail, microseconds(1000));
+}
+
+TEST(Histogram, MergeAndConcurrentRecording)
+{
+    const int THREADS = 4;
+    const int RECORDS = 10000;
+
+    Histogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        threads.emplace_back([&histogram, t]{
+            for (int i = 0; i < RECORDS; ++i)
+                histogram.Record(nanoseconds(1000 * (t + 1)));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    HistogramSnapshot first, second;
+    histogram.Read(first);
+    ASSERT_EQ(first.GetCount(), uint64_t(THREADS * RECORDS));
+    ASSERT_EQ(first.GetMean(), nanoseconds(2500));
+
+    Histogram other;
+    other.Record(microseconds(100));
+    other.Read(second);
+
+    first.Merge(second);
+    ASSERT_EQ(first.GetCount(), uint64_t(THREADS * RECORDS + 1));
+    ASSERT_EQ(first.GetMax(), microseconds(100));
+    ASSERT_EQ(first.GetMin(), nanoseconds(1000));
+}
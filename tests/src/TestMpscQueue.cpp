@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/MpscQueue.h>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler::Lib;
+
+TEST(MpscQueue, PushAndPop)
+{
+    MpscQueue<int> queue;
+    ASSERT_TRUE(queue.Empty());
+
+    int value = 0;
+    ASSERT_FALSE(queue.Pop(value));
+
+    for (int i = 0; i < 10; ++i) queue.Push(int(i));
+    ASSERT_FALSE(queue.Empty());
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.Pop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue.Pop(value));
+    ASSERT_TRUE(queue.Empty());
+}
+
+TEST(MpscQueue, ParkedConsumerWokenOnce)
+{
+    MpscQueue<int> queue;
+
+    ASSERT_TRUE(queue.Park());
+    ASSERT_TRUE(queue.Push(1));
+    ASSERT_FALSE(queue.Push(2));
+
+    // Something is queued so the consumer must not go back to sleep.
+    ASSERT_FALSE(queue.Park());
+    queue.Clear();
+    ASSERT_TRUE(queue.Empty());
+}
+
+TEST(MpscQueue, BatchPush)
+{
+    MpscQueue<int> queue;
+    ASSERT_FALSE(queue.Push(std::vector<int>()));
+
+    ASSERT_TRUE(queue.Park());
+    ASSERT_TRUE(queue.Push(std::vector<int>{ 1, 2, 3 }));
+    ASSERT_FALSE(queue.Push(4));
+
+    int value = 0;
+    for (int i = 1; i <= 4; ++i)
+    {
+        ASSERT_TRUE(queue.Pop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_TRUE(queue.Empty());
+}
+
+TEST(MpscQueue, ConcurrentProducers)
+{
+    static const int PRODUCERS = 8;
+    static const int COUNT = 10000;
+
+    MpscQueue<int> queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p)
+    {
+        producers.emplace_back([&queue, p]{
+            for (int i = 0; i < COUNT; ++i) queue.Push(p * COUNT + i);
+        });
+    }
+
+    // Values from each producer must come out in the order pushed.
+    std::vector<int> last(PRODUCERS, -1);
+    int received = 0, value = 0;
+    while (received < PRODUCERS * COUNT)
+    {
+        if (!queue.Pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = value / COUNT;
+        ASSERT_GT(value, last[producer]);
+        last[producer] = value;
+        ++received;
+    }
+
+    for (std::thread& producer : producers) producer.join();
+    ASSERT_TRUE(queue.Empty());
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Recurrence.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Tests/Tasks.h>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+using std::chrono::milliseconds;
+
+namespace {
+
+    typedef std::chrono::system_clock::time_point WallPoint;
+
+    WallPoint Wall(int64_t seconds)
+    {
+        return WallPoint(std::chrono::duration_cast<WallPoint::duration>(
+            std::chrono::seconds(seconds)));
+    }
+
+    // Seconds since the epoch of some dates in UTC.
+    const int64_t SAT_2024_01_06_1007 = 1704535620;
+    const int64_t SAT_2024_01_06_1015 = 1704536100;
+    const int64_t SUN_2024_01_07_0000 = 1704585600;
+    const int64_t MON_2024_01_08_0900 = 1704704400;
+    const int64_t SAT_2024_01_13_0000 = 1705104000;
+    const int64_t WED_2024_01_31_1200 = 1706702400;
+    const int64_t WED_2023_03_01_0000 = 1677628800;
+    const int64_t THU_2024_02_29_0000 = 1709164800;
+
+}  // namespace
+
+TEST(Recurrence, FixedRateKeepsToGrid)
+{
+    Recurrence recurrence = Recurrence::FixedRate(milliseconds(10));
+    ASSERT_TRUE(recurrence.IsValid());
+
+    Clock::time_point due = Clock::now();
+    unsigned missed = 0;
+
+    // A run which finishes early or on time waits for the next tick.
+    ASSERT_EQ(recurrence.Next(due, due + milliseconds(3), missed), due + milliseconds(10));
+    ASSERT_EQ(recurrence.Next(due, due + milliseconds(10), missed), due + milliseconds(10));
+    ASSERT_EQ(missed, 0u);
+
+    // A run which overran skips the ticks it missed instead of running
+    // late, and the grid does not move.
+    ASSERT_EQ(recurrence.Next(due, due + milliseconds(25), missed), due + milliseconds(30));
+    ASSERT_EQ(missed, 2u);
+
+    ASSERT_FALSE(Recurrence::FixedRate(Clock::duration::zero()).IsValid());
+}
+
+TEST(Recurrence, FixedDelayFollowsCompletion)
+{
+    Recurrence recurrence = Recurrence::FixedDelay(milliseconds(10));
+    Clock::time_point due = Clock::now();
+    unsigned missed = 0;
+
+    ASSERT_EQ(recurrence.Next(due, due + milliseconds(25), missed), due + milliseconds(35));
+    ASSERT_EQ(missed, 0u);
+    ASSERT_EQ(Recurrence().Next(due, due, missed), Clock::time_point::max());
+}
+
+TEST(Recurrence, CronParsing)
+{
+    ASSERT_TRUE(Recurrence::Cron("* * * * *").IsValid());
+    ASSERT_TRUE(Recurrence::Cron("*/15 0-6,22 1 1-12/2 1-5").IsValid());
+    ASSERT_TRUE(Recurrence::Cron("0 0 * * 7").IsValid());
+    ASSERT_TRUE(Recurrence::Cron("@daily").IsValid());
+
+    ASSERT_FALSE(Recurrence::Cron("").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("* * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("60 * * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("* 24 * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("* * 0 * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("*/0 * * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("5-1 * * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("a * * * *").IsValid());
+    ASSERT_FALSE(Recurrence::Cron("1, * * * *").IsValid());
+
+    // A task with a malformed recurrence is never run.
+    TaskPtr task = Task::Create<Success>();
+    task->SetRecurrence(Recurrence::Cron("not cron"));
+    ASSERT_FALSE(task->IsValid());
+}
+
+TEST(Recurrence, CronNextMatch)
+{
+    Recurrence quarter = Recurrence::Cron("*/15 * * * *");
+    ASSERT_EQ(quarter.NextMatch(Wall(SAT_2024_01_06_1007)), Wall(SAT_2024_01_06_1015));
+
+    // Matches are strictly after the given time, at whole minutes.
+    ASSERT_EQ(quarter.NextMatch(Wall(SAT_2024_01_06_1015)), Wall(SAT_2024_01_06_1015 + 900));
+    ASSERT_EQ(
+        quarter.NextMatch(Wall(SAT_2024_01_06_1015) - milliseconds(1)),
+        Wall(SAT_2024_01_06_1015));
+
+    // Weekdays skip the weekend.
+    Recurrence weekdays = Recurrence::Cron("0 9 * * 1-5");
+    ASSERT_EQ(weekdays.NextMatch(Wall(SAT_2024_01_06_1007)), Wall(MON_2024_01_08_0900));
+
+    // Either day field matches when both are restricted.
+    Recurrence either = Recurrence::Cron("0 0 13 * 0");
+    ASSERT_EQ(either.NextMatch(Wall(SAT_2024_01_06_1007)), Wall(SUN_2024_01_07_0000));
+    ASSERT_EQ(
+        either.NextMatch(Wall(SAT_2024_01_13_0000 - 60)),
+        Wall(SAT_2024_01_13_0000));
+
+    // Month lengths and leap years are honoured.
+    ASSERT_EQ(
+        Recurrence::Cron("0 0 1 * *").NextMatch(Wall(WED_2024_01_31_1200)),
+        Wall(WED_2024_01_31_1200 + 12 * 3600));
+    ASSERT_EQ(
+        Recurrence::Cron("0 0 29 2 *").NextMatch(Wall(WED_2023_03_01_0000)),
+        Wall(THU_2024_02_29_0000));
+
+    // A date which never comes does not match.
+    ASSERT_EQ(
+        Recurrence::Cron("0 0 30 2 *").NextMatch(Wall(WED_2023_03_01_0000)),
+        WallPoint::max());
+}
@@ -5,15 +5,34 @@
 #include <Scheduler/Lib/Group.h>
 #include <Scheduler/Lib/Scheduler.h>
 #include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/TaskRunner.h>
 #include <Scheduler/Tests/Tasks.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace Scheduler;
 using namespace Scheduler::Lib;
 using namespace Scheduler::Tests;
 
-TEST(SchedularStartup, InitializeAndShutdown)
+// Every scheduling scenario runs against both the centralized and the
+// decentralized scheduler, the body taking the mode to create it with.
+#define SCHEDULER_TEST(suite, name)                                         \
+    static void suite##_##name##_Body(SchedulingMode mode);                 \
+    TEST(suite, name)                                                       \
+    {                                                                       \
+        suite##_##name##_Body(SchedulingMode::CENTRALIZED);                 \
+    }                                                                       \
+    TEST(suite, name##_Decentralized)                                       \
+    {                                                                       \
+        suite##_##name##_Body(SchedulingMode::DECENTRALIZED);               \
+    }                                                                       \
+    static void suite##_##name##_Body(SchedulingMode mode)
+
+SCHEDULER_TEST(SchedularStartup, InitializeAndShutdown)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -35,9 +54,10 @@ TEST(SchedularStartup, InitializeAndShutdown)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, DependentTasks)
+SCHEDULER_TEST(Scheduler, DependentTasks)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -66,9 +86,10 @@ TEST(Scheduler, DependentTasks)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, ProcessChainAndDependents)
+SCHEDULER_TEST(Scheduler, ProcessChainAndDependents)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -118,9 +139,10 @@ TEST(Scheduler, ProcessChainAndDependents)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, ProcessChainAndDependentsWithFinalFailure)
+SCHEDULER_TEST(Scheduler, ProcessChainAndDependentsWithFinalFailure)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -155,9 +177,10 @@ TEST(Scheduler, ProcessChainAndDependentsWithFinalFailure)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, ProcessChainAndDependentsWithFirstFailure)
+SCHEDULER_TEST(Scheduler, ProcessChainAndDependentsWithFirstFailure)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -201,9 +224,10 @@ TEST(Scheduler, ProcessChainAndDependentsWithFirstFailure)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, ProcessGroupAndDependents)
+SCHEDULER_TEST(Scheduler, ProcessGroupAndDependents)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -253,9 +277,50 @@ TEST(Scheduler, ProcessGroupAndDependents)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, ProcessGroupAndDependentsWithFirstFailure)
+SCHEDULER_TEST(Scheduler, FailureSweepsDependentSubgraph)
 {
     SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // A deep chain hanging off the failing root, with a task which fans in
+    // from both the chain and an unrelated task that succeeds.
+    static const size_t DEPTH = 1000;
+    TaskPtr root = Task::Create<Failure>(),
+            other = Task::Create<Success>(),
+            fanIn = Task::Create<Success>();
+
+    std::vector<TaskPtr> tasks(1, root);
+    for (size_t i = 0; i < DEPTH; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        task->Depends(tasks.back());
+        tasks.emplace_back(std::move(task));
+    }
+    fanIn->Depends(tasks[DEPTH / 2]);
+    fanIn->Depends(other);
+    tasks.emplace_back(other);
+    tasks.emplace_back(fanIn);
+
+    scheduler->Enqueue(tasks);
+    scheduler->Start();
+
+    for (TaskPtr& task : tasks) task->Wait();
+    ASSERT_EQ(other->GetState(), TaskState::SUCCESS);
+    for (size_t i = 0; i <= DEPTH; ++i)
+        ASSERT_EQ(tasks[i]->GetState(), TaskState::FAILED);
+    ASSERT_EQ(fanIn->GetState(), TaskState::FAILED);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, ProcessGroupAndDependentsWithFirstFailure)
+{
+    SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -298,9 +363,10 @@ TEST(Scheduler, ProcessGroupAndDependentsWithFirstFailure)
 }
 
 
-TEST(Scheduler, BasicRetries)
+SCHEDULER_TEST(Scheduler, BasicRetries)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -319,23 +385,189 @@ TEST(Scheduler, BasicRetries)
     scheduler->Enqueue(taskB);
     scheduler->Enqueue(taskA);
 
-    taskA->Wait(false);
+    while (taskA->GetState() == TaskState::NEW) std::this_thread::yield();
     ASSERT_TRUE(taskA->GetState() == TaskState::PENDING
             || taskA->GetState() == TaskState::ACTIVE);
 
     taskA->Wait();
     ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskA->GetRetryCount(), 1u);
 
     taskB->Wait();
     ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetRetryCount(), 0u);
 
     scheduler->Shutdown(true);
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, TasksWithLambdas)
+SCHEDULER_TEST(Scheduler, RetryLimitFailsTask)
 {
     SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.maxRetryDelay = std::chrono::milliseconds(5);
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // A task which never stops asking to be retried fails once it has used
+    // up its retries, taking its dependent with it.
+    TaskPtr taskA = Task::Create<Unavailable>(),
+            taskB = Task::Create<Success>();
+    taskA->SetRetryLimit(3);
+    taskB->Depends(taskA);
+
+    scheduler->Enqueue(taskB);
+    scheduler->Enqueue(taskA);
+
+    taskA->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::FAILED);
+    ASSERT_EQ(taskA->GetRetryCount(), 3u);
+
+    taskB->Wait();
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, RetryBudgetFailsTasks)
+{
+    static const size_t COUNT = 8;
+    static const size_t BUDGET = 4;
+
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.retryBudget = BUDGET;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Every task asks to be retried at once and the budget only covers some
+    // of them. The rest fail straight away rather than piling on.
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        tasks.emplace_back(Task::Create<Unavailable>());
+        tasks.back()->SetRetryLimit(1);
+    }
+    scheduler->Enqueue(tasks);
+
+    size_t retried = 0;
+    for (TaskPtr& task : tasks)
+    {
+        task->Wait();
+        ASSERT_EQ(task->GetState(), TaskState::FAILED);
+        retried += task->GetRetryCount();
+    }
+    ASSERT_GE(retried, 1u);
+    ASSERT_LT(retried, COUNT);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, RecurringTaskRunsInPlace)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // The same task runs again and again until it is cancelled, and its
+    // dependent waits for the recurrence to end.
+    std::atomic<unsigned> runs{0};
+    TaskPtr taskA = Task::Create([&runs]() { ++runs; }),
+            taskB = Task::Create<Success>();
+    taskA->SetRecurrence(Recurrence::FixedRate(std::chrono::milliseconds(2)));
+    taskB->Depends(taskA);
+    UUID id = taskA->Id();
+
+    scheduler->Enqueue(taskB);
+    scheduler->Enqueue(taskA);
+
+    while (runs < 3) std::this_thread::yield();
+    ASSERT_FALSE(taskB->IsComplete());
+    ASSERT_EQ(taskA->Id(), id);
+
+    ASSERT_EQ(scheduler->Cancel(taskA), E_SUCCESS);
+    taskA->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::CANCELLED);
+    ASSERT_GE(taskA->GetRunCount(), 2u);
+
+    taskB->Wait();
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, RecurringTaskEndsAtDeadline)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Once the next run would fall past the deadline the recurrence is over
+    // and the task succeeds, releasing its dependent. The second run leaves
+    // plenty of room before the deadline so a slow pass does not expire it.
+    std::atomic<unsigned> runs{0};
+    TaskPtr taskA = Task::Before(
+        [&runs]() { ++runs; },
+        Clock::now() + std::chrono::milliseconds(50));
+    TaskPtr taskB = Task::Create<Success>();
+    taskA->SetRecurrence(Recurrence::FixedDelay(std::chrono::milliseconds(30)));
+    taskB->Depends(taskA);
+
+    scheduler->Enqueue(taskB);
+    scheduler->Enqueue(taskA);
+
+    taskA->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskA->GetRunCount(), runs.load());
+    ASSERT_GE(runs.load(), 2u);
+
+    taskB->Wait();
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, RecurringTaskStopsOnFailure)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    std::atomic<unsigned> runs{0};
+    TaskPtr task = Task::Create([&runs]() { return ++runs < 3; });
+    task->SetRecurrence(Recurrence::FixedRate(std::chrono::milliseconds(1)));
+    scheduler->Enqueue(task);
+
+    task->Wait();
+    ASSERT_EQ(task->GetState(), TaskState::FAILED);
+    ASSERT_EQ(runs.load(), 3u);
+    ASSERT_EQ(task->GetRunCount(), 2u);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, TasksWithLambdas)
+{
+    SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -377,9 +609,10 @@ TEST(Scheduler, TasksWithLambdas)
     ASSERT_TRUE(scheduler->IsShutdown());
 }
 
-TEST(Scheduler, TasksWithLambdas_WithTaskResult)
+SCHEDULER_TEST(Scheduler, TasksWithLambdas_WithTaskResult)
 {
     SchedulerParams params;
+    params.mode = mode;
     params.executorParams.concurrency = 2;
     SchedulerPtr scheduler;
     ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
@@ -423,3 +656,718 @@ TEST(Scheduler, TasksWithLambdas_WithTaskResult)
     scheduler->Shutdown(true);
     ASSERT_TRUE(scheduler->IsShutdown());
 }
+
+SCHEDULER_TEST(Scheduler, DependencyQueuedAfterDependent)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>(),
+            taskC = Task::Create<Success>();
+
+    taskC->Depends(taskB);
+    taskB->Depends(taskA);
+    ASSERT_TRUE(taskC->IsValid());
+
+    // The dependents are taken in by the scheduler well before the task
+    // they are waiting on has been queued.
+    scheduler->Enqueue(taskC);
+    scheduler->Enqueue(taskB);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(taskC->GetState(), TaskState::PENDING);
+    scheduler->Enqueue(taskA);
+
+    taskC->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskC->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, PrematureTasks)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    Clock::time_point start = Clock::now();
+    TaskPtr taskA = Task::After<Success>(start + std::chrono::milliseconds(50)),
+            taskB = Task::After<Success>(start + std::chrono::milliseconds(20));
+
+    taskA->Depends(taskB);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+
+    taskA->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+    ASSERT_GE(Clock::now() - start, std::chrono::milliseconds(50));
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, DeadlineShedsInfeasibleTasks)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.dispatchPolicy = DispatchPolicy::DEADLINE;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Task A has a deadline it cannot meet given its estimate, so it is
+    // shed instead of run and takes its dependent down with it.
+    std::atomic<bool> ran{false};
+    TaskPtr taskA = Task::Before([&ran]{ ran = true; },
+        Clock::now() + std::chrono::seconds(10));
+    taskA->SetEstimate(std::chrono::seconds(60));
+    TaskPtr taskB = Task::Create<Success>(),
+            taskC = Task::Before<Success>(Clock::now() + std::chrono::seconds(10));
+    taskC->SetEstimate(std::chrono::milliseconds(1));
+
+    taskB->Depends(taskA);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+    scheduler->Enqueue(taskC);
+
+    taskB->Wait();
+    taskC->Wait();
+    ASSERT_FALSE(ran);
+    ASSERT_EQ(taskA->GetState(), TaskState::CANCELLED);
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+    ASSERT_EQ(taskC->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, ExpireWaitingAndRunningTasks)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Task A holds up B past its deadline, while C runs past its own.
+    std::atomic<bool> release{false};
+    Clock::time_point start = Clock::now();
+    TaskPtr taskA = Task::Create([&release]{
+        while (!release) std::this_thread::yield();
+    });
+    TaskPtr taskB = Task::Before<Success>(start + std::chrono::milliseconds(20)),
+            taskC = Task::Before([&release]{
+                while (!release) std::this_thread::yield();
+            }, start + std::chrono::milliseconds(20));
+    taskB->Depends(taskA);
+
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+    scheduler->Enqueue(taskC);
+
+    taskB->Wait();
+    taskC->Wait();
+    ASSERT_EQ(taskB->GetState(), TaskState::CANCELLED);
+    ASSERT_EQ(taskC->GetState(), TaskState::CANCELLED);
+    ASSERT_GE(Clock::now() - start, std::chrono::milliseconds(20));
+
+    release = true;
+    taskA->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, CapacityBackpressure)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.capacity = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    std::atomic<bool> release{false};
+
+    // Fill the scheduler with tasks which hold on to their room until
+    // released.
+    std::vector<TaskPtr> held;
+    for (int i = 0; i < 4; ++i)
+    {
+        held.emplace_back(Task::Create([&release]{
+            while (!release) std::this_thread::yield();
+        }));
+        ASSERT_EQ(scheduler->TryEnqueue(held.back()), E_SUCCESS);
+    }
+
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>(),
+            taskC = Task::Create<Success>();
+    ChainPtr chain = Task::Create<Chain>();
+    chain->Add(taskC);
+
+    size_t admitted = 0;
+    ASSERT_EQ(scheduler->TryEnqueue(taskA), E_FULL);
+    ASSERT_EQ(scheduler->TryEnqueue(chain), E_FULL);
+    ASSERT_EQ(scheduler->Enqueue(taskA, std::chrono::milliseconds(10)), E_FULL);
+    ASSERT_EQ(scheduler->TryEnqueue({ taskA, taskB }, admitted), E_FULL);
+    ASSERT_EQ(admitted, 0U);
+    ASSERT_EQ(taskA->GetState(), TaskState::NEW);
+
+    // Room frees up once the held tasks complete.
+    release = true;
+    ASSERT_EQ(scheduler->Enqueue(taskA, std::chrono::seconds(30)), E_SUCCESS);
+    for (TaskPtr& task : held) task->Wait();
+    taskA->Wait();
+
+    ASSERT_EQ(scheduler->Enqueue(chain, std::chrono::seconds(30)), E_SUCCESS);
+    chain->Wait();
+    ASSERT_EQ(scheduler->Enqueue(taskB, std::chrono::seconds(30)), E_SUCCESS);
+    taskB->Wait();
+
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(chain->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, BulkTryEnqueueAdmitsWhatFits)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.capacity = 3;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // Nothing completes before the scheduler is started so the capacity is
+    // only taken up.
+    std::vector<TaskPtr> tasks;
+    for (int i = 0; i < 5; ++i) tasks.emplace_back(Task::Create<Success>());
+
+    size_t admitted = 0;
+    ASSERT_EQ(scheduler->TryEnqueue(tasks, admitted), E_FULL);
+    ASSERT_EQ(admitted, 3U);
+    ASSERT_EQ(tasks[3]->GetState(), TaskState::NEW);
+
+    scheduler->Start();
+    for (size_t i = 0; i < admitted; ++i) tasks[i]->Wait();
+
+    std::vector<TaskPtr> rest(tasks.begin() + admitted, tasks.end());
+    for (TaskPtr& task : rest)
+        ASSERT_EQ(scheduler->Enqueue(task, std::chrono::seconds(30)), E_SUCCESS);
+    for (TaskPtr& task : rest) task->Wait();
+    for (TaskPtr& task : tasks) ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, BulkEnqueue)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.capacity = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // A plain bulk enqueue goes past the capacity rather than waiting, and
+    // brings the children of a chain along with it.
+    std::vector<TaskPtr> tasks;
+    for (int i = 0; i < 8; ++i) tasks.emplace_back(Task::Create<Success>());
+    TaskPtr child = Task::Create<Success>();
+    ChainPtr chain = Task::Create<Chain>();
+    chain->Add(child);
+    tasks.emplace_back(chain);
+
+    scheduler->Enqueue(tasks);
+    for (TaskPtr& task : tasks) task->Wait();
+    for (TaskPtr& task : tasks) ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(child->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, BulkTryEnqueueCountsChainChildren)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.capacity = 3;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // The chain takes room for itself and its child, leaving no room for
+    // the last task.
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>(),
+            child = Task::Create<Success>();
+    ChainPtr chain = Task::Create<Chain>();
+    chain->Add(child);
+
+    size_t admitted = 0;
+    ASSERT_EQ(scheduler->TryEnqueue({ taskA, chain, taskB }, admitted), E_FULL);
+    ASSERT_EQ(admitted, 2U);
+    ASSERT_EQ(taskB->GetState(), TaskState::NEW);
+
+    scheduler->Start();
+    taskA->Wait();
+    chain->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(chain->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+
+    ASSERT_EQ(scheduler->TryEnqueue({ taskB }, admitted), E_CANCELLED);
+    ASSERT_EQ(admitted, 0U);
+}
+
+SCHEDULER_TEST(Scheduler, CancelPendingTask)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Task A waits on the gate and B waits on A. Cancelling A fails B and
+    // leaves the gate alone.
+    std::atomic<bool> release{false};
+    TaskPtr gate = Task::Create([&release]{
+            while (!release) std::this_thread::yield();
+        }),
+            taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>();
+    taskA->Depends(gate);
+    taskB->Depends(taskA);
+
+    scheduler->Enqueue(gate);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+
+    // The decentralized scheduler takes B in before Enqueue returns, so
+    // there may be no state change left to wait on.
+    while (taskB->GetState() == TaskState::NEW) std::this_thread::yield();
+
+    ASSERT_EQ(scheduler->Cancel(taskA), E_SUCCESS);
+    taskA->Wait();
+    taskB->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::CANCELLED);
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+    ASSERT_EQ(scheduler->Cancel(taskA), E_COMPLETED);
+
+    release = true;
+    gate->Wait();
+    ASSERT_EQ(gate->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(scheduler->Cancel(gate->Id()), E_COMPLETED);
+    ASSERT_EQ(scheduler->Cancel(UUID(true)), E_NOT_FOUND);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, DependentCancelledAsDependencyCompletes)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr other;
+    ASSERT_EQ(TaskScheduler::Create(params, other), E_SUCCESS);
+    params.capacity = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+    other->Start();
+
+    // B waits on the gate. It is also queued with a second scheduler which
+    // cancels it behind the first one's back, so by the time the gate
+    // completes and its worker looks for a dependent to continue with, B
+    // is already cancelled and must be settled rather than claimed.
+    std::atomic<bool> release{false};
+    TaskPtr gate = Task::Create([&release]{
+            while (!release) std::this_thread::yield();
+        }),
+            taskB = Task::Create<Success>();
+    taskB->Depends(gate);
+
+    ASSERT_EQ(scheduler->TryEnqueue(gate), E_SUCCESS);
+    ASSERT_EQ(scheduler->TryEnqueue(taskB), E_SUCCESS);
+    while (taskB->GetState() == TaskState::NEW) std::this_thread::yield();
+
+    other->Enqueue(taskB);
+    ASSERT_EQ(other->Cancel(taskB), E_SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::CANCELLED);
+
+    release = true;
+    gate->Wait();
+    ASSERT_EQ(gate->GetState(), TaskState::SUCCESS);
+
+    // Once B is settled the first scheduler has room for a chain of two
+    // again.
+    TaskPtr taskC = Task::Create<Success>();
+    ChainPtr chain = Task::Create<Chain>();
+    chain->Add(taskC);
+    ASSERT_EQ(scheduler->Enqueue(chain, std::chrono::seconds(5)), E_SUCCESS);
+    chain->Wait();
+    ASSERT_EQ(chain->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::CANCELLED);
+
+    other->Shutdown(true);
+    scheduler->Shutdown(true);
+}
+
+SCHEDULER_TEST(Scheduler, CancelRunningTask)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // The body polls its cancellation flag and gives up once it is set.
+    std::atomic<bool> started{false}, stopped{false};
+    TaskPtr task = Task::Create([&started, &stopped](Task* self){
+        started = true;
+        while (!self->IsCancellationRequested()) std::this_thread::yield();
+        stopped = true;
+    });
+    scheduler->Enqueue(task);
+    while (!started) std::this_thread::yield();
+
+    ASSERT_EQ(scheduler->Cancel(task), E_SUCCESS);
+    task->Wait();
+    ASSERT_EQ(task->GetState(), TaskState::CANCELLED);
+    while (!stopped) std::this_thread::yield();
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, CancelChain)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // Nothing runs before the scheduler is started, so the whole chain is
+    // cancelled before any of it gets the chance.
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>();
+    ChainPtr chain = Task::Create<Chain>(taskA, taskB);
+    scheduler->Enqueue(chain);
+
+    ASSERT_EQ(scheduler->Cancel(chain), E_SUCCESS);
+    scheduler->Start();
+
+    chain->Wait();
+    taskA->Wait();
+    taskB->Wait();
+    ASSERT_EQ(chain->GetState(), TaskState::CANCELLED);
+    ASSERT_EQ(taskA->GetState(), TaskState::CANCELLED);
+    ASSERT_EQ(taskB->GetState(), TaskState::CANCELLED);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, DependentsContinueOnWorker)
+{
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // Each step records the thread it ran on. The whole chain is taken in
+    // before any of it runs, so every step is ready to be handed straight
+    // to the worker which ran the one before it.
+    static const size_t STEPS = TaskRunner::MAX_CONTINUATIONS;
+    std::vector<std::thread::id> threads(STEPS);
+    std::vector<TaskPtr> steps;
+    for (size_t i = 0; i < STEPS; ++i)
+    {
+        std::thread::id* thread = &threads[i];
+        TaskPtr task = Task::Create([thread]{
+            *thread = std::this_thread::get_id();
+        });
+        if (!steps.empty()) task->Depends(steps.back());
+        steps.emplace_back(std::move(task));
+    }
+    scheduler->Enqueue(steps);
+    scheduler->Start();
+
+    for (TaskPtr& task : steps) task->Wait();
+    for (size_t i = 0; i < STEPS; ++i)
+    {
+        ASSERT_EQ(steps[i]->GetState(), TaskState::SUCCESS);
+        ASSERT_EQ(threads[i], threads.front());
+    }
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+namespace {
+
+    class IntakeReporter : public ScheduleReporter
+    {
+    public:
+        void ReportIntake(size_t count, const Clock::duration&) override
+        {
+            m_batches += 1;
+            m_tasks += count;
+        }
+
+        std::atomic<size_t> m_batches{0};
+        std::atomic<size_t> m_tasks{0};
+    };
+
+}  // namespace
+
+SCHEDULER_TEST(Scheduler, BatchedIntake)
+{
+    static const size_t COUNT = 2000;
+
+    std::shared_ptr<IntakeReporter> reporter = std::make_shared<IntakeReporter>();
+
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    params.intakeBatchSize = 64;
+    params.reporter = reporter.get();
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    std::vector<TaskPtr> tasks;
+    GroupPtr group = Task::Create<Group>();
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        tasks.emplace_back(Task::Create<Success>());
+        group->Add(tasks.back());
+    }
+
+    // Queue everything before the scheduler starts so the intake has to
+    // work through the backlog in batches.
+    scheduler->Enqueue(group);
+    scheduler->Start();
+
+    group->Wait();
+    ASSERT_EQ(group->GetState(), TaskState::SUCCESS);
+    for (TaskPtr& task : tasks) ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+
+    ASSERT_EQ(reporter->m_tasks, COUNT + 1);
+    ASSERT_GE(reporter->m_batches, (COUNT + 1) / params.intakeBatchSize);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, ConcurrentProducers)
+{
+    static const size_t PRODUCERS = 8;
+    static const size_t COUNT = 250;
+
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    std::vector<std::vector<TaskPtr>> tasks(PRODUCERS);
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < PRODUCERS; ++p)
+    {
+        producers.emplace_back([&, p]{
+            for (size_t i = 0; i < COUNT; ++i)
+            {
+                TaskPtr task = Task::Create<Success>();
+                if (!tasks[p].empty()) task->Depends(tasks[p].back());
+                scheduler->Enqueue(task);
+                tasks[p].emplace_back(std::move(task));
+            }
+        });
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    for (std::vector<TaskPtr>& chain : tasks)
+    {
+        chain.back()->Wait();
+        for (TaskPtr& task : chain)
+            ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+    }
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+SCHEDULER_TEST(Scheduler, LatencyStats)
+{
+    const size_t TASKS = 64;
+
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // Pairs of tasks where the second waits on the first.
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < TASKS; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        if (i % 2) task->Depends(tasks.back());
+        tasks.emplace_back(std::move(task));
+    }
+    scheduler->Enqueue(tasks);
+
+    for (TaskPtr& task : tasks)
+    {
+        task->Wait();
+        ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+
+        const TaskTimes& times = task->GetTimes();
+        ASSERT_NE(times.enqueued, Clock::time_point::min());
+        ASSERT_LE(times.enqueued, times.pending);
+        ASSERT_LE(times.pending, times.dispatched);
+        ASSERT_LE(times.dispatched, times.started);
+        ASSERT_LE(times.started, times.finished);
+    }
+
+    SchedulerStats stats;
+    scheduler->GetStats(stats);
+    ASSERT_EQ(stats.intake.GetCount(), TASKS);
+    ASSERT_EQ(stats.waiting.GetCount(), TASKS);
+    ASSERT_EQ(stats.executor.queued.GetCount(), TASKS);
+    ASSERT_EQ(stats.executor.running.GetCount(), TASKS);
+    ASSERT_LE(stats.executor.running.Percentile(50), stats.executor.running.GetMax());
+
+    // Stats are still there once the scheduler is gone.
+    scheduler->Shutdown(true);
+    SchedulerStats after;
+    scheduler->GetStats(after);
+    ASSERT_EQ(after.waiting.GetCount(), TASKS);
+    ASSERT_EQ(after.executor.running.GetCount(), TASKS);
+}
+
+namespace {
+
+    /// Simulated time for a scheduler running on its own threads. The clock
+    /// is installed for the life of the object, which should outlive the
+    /// scheduler.
+    class SimulatedTime
+    {
+    public:
+        SimulatedTime() { SetTimeSource(&m_clock); }
+        ~SimulatedTime() { SetTimeSource(nullptr); }
+
+        /// Move time on a second at a time, giving the scheduler a moment
+        /// to serve its timers after each step.
+        void Advance(const SchedulerPtr& scheduler, const Clock::duration& length)
+        {
+            Clock::time_point end = m_clock.Now() + length;
+            while (m_clock.Now() < end)
+            {
+                m_clock.Advance(std::chrono::seconds(1));
+                scheduler->Notify();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        Clock::time_point Now() const { return m_clock.Now(); }
+
+    private:
+        SimulatedClock m_clock;
+    };
+
+}  // namespace
+
+SCHEDULER_TEST(Scheduler, DelayedDependencyIsWaitedOn)
+{
+    SimulatedTime time;
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // A waits for its start time, well past the time allowed for a
+    // dependency which was never queued, which it is not.
+    TaskPtr taskA = Task::After([]() { }, time.Now() + std::chrono::minutes(1));
+    TaskPtr taskB = Task::Create<Success>();
+    taskB->Depends(taskA);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+    while (taskB->GetState() == TaskState::NEW) std::this_thread::yield();
+
+    time.Advance(scheduler, std::chrono::minutes(2));
+    taskA->Wait();
+    taskB->Wait();
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+}
+
+SCHEDULER_TEST(Scheduler, UnqueuedDependencyIsReleased)
+{
+    SimulatedTime time;
+    SchedulerParams params;
+    params.mode = mode;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // B waits on A, which is never queued. Once B times out nothing is left
+    // waiting on A and the scheduler lets go of it.
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>();
+    taskB->Depends(taskA);
+    scheduler->Enqueue(taskB);
+    while (taskB->GetState() == TaskState::NEW) std::this_thread::yield();
+
+    std::weak_ptr<Task> weakA = taskA;
+    taskA.reset();
+
+    time.Advance(scheduler, std::chrono::minutes(1));
+    taskB->Wait();
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+
+    // The scheduler may still be finishing with B when it is failed.
+    std::weak_ptr<Task> weakB = taskB;
+    taskB.reset();
+    for (int i = 0; i < 1000 && !weakB.expired(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_TRUE(weakB.expired());
+    ASSERT_TRUE(weakA.expired());
+
+    scheduler->Shutdown(true);
+}
@@ -0,0 +1,371 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Chain.h>
+#include <Scheduler/Lib/Group.h>
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Tests/Tasks.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+
+TEST(ShardedScheduler, InitializeAndShutdown)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        scheduler->Enqueue(task);
+        tasks.emplace_back(std::move(task));
+    }
+
+    for (TaskPtr& task : tasks)
+    {
+        task->Wait();
+        ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+    }
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, DependenciesAcrossShards)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // With four shards a chain this long is all but guaranteed to cross
+    // between shards on most of its links.
+    std::vector<TaskPtr> chain;
+    for (size_t i = 0; i < 256; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        if (!chain.empty()) task->Depends(chain.back());
+        chain.emplace_back(std::move(task));
+    }
+
+    // Queue the dependents first so most of them are waiting on tasks the
+    // owning shards have not seen yet.
+    for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter)
+        scheduler->Enqueue(*iter);
+
+    chain.back()->Wait();
+    for (TaskPtr& task : chain)
+        ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, FanInAcrossShards)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 8;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    TaskPtr root = Task::Create<Success>(),
+            sink = Task::Create<Success>();
+
+    std::vector<TaskPtr> middle;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        task->Depends(root);
+        sink->Depends(task);
+        middle.emplace_back(std::move(task));
+    }
+    ASSERT_TRUE(sink->IsValid());
+
+    scheduler->Enqueue(sink);
+    for (TaskPtr& task : middle) scheduler->Enqueue(task);
+    scheduler->Enqueue(root);
+
+    sink->Wait();
+    ASSERT_EQ(root->GetState(), TaskState::SUCCESS);
+    for (TaskPtr& task : middle)
+        ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(sink->GetState(), TaskState::SUCCESS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, ProcessChainWithFirstFailure)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    TaskPtr taskA = Task::Create<Failure>(),
+            taskB = Task::Create<Success>(),
+            taskC = Task::Create<Success>(),
+            taskD = Task::Create<Success>();
+
+    ChainPtr chain = Task::Create<Chain>(taskA, taskB, taskC);
+
+    taskD->Depends(chain.get());
+    ASSERT_TRUE(chain->IsValid());
+    ASSERT_TRUE(taskD->Requires(chain.get()));
+
+    scheduler->Enqueue(taskD);
+    scheduler->Enqueue(chain);
+
+    taskA->Wait();
+    ASSERT_EQ(TaskState::FAILED, taskA->GetState());
+    taskB->Wait();
+    ASSERT_EQ(TaskState::FAILED, taskB->GetState());
+    taskC->Wait();
+    ASSERT_EQ(TaskState::FAILED, taskC->GetState());
+    chain->Wait();
+    ASSERT_EQ(TaskState::FAILED, chain->GetState());
+    taskD->Wait();
+    ASSERT_EQ(TaskState::FAILED, taskD->GetState());
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, ProcessGroupAndDependents)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>(),
+            taskC = Task::Create<Success>(),
+            taskD = Task::Create<Success>();
+
+    GroupPtr group = Task::Create<Group>(taskA, taskB, taskC);
+
+    taskD->Depends(group.get());
+    ASSERT_TRUE(group->IsValid());
+
+    scheduler->Enqueue(taskD);
+    scheduler->Enqueue(group);
+
+    taskD->Wait();
+    ASSERT_EQ(TaskState::SUCCESS, taskA->GetState());
+    ASSERT_EQ(TaskState::SUCCESS, taskB->GetState());
+    ASSERT_EQ(TaskState::SUCCESS, taskC->GetState());
+    ASSERT_EQ(TaskState::SUCCESS, group->GetState());
+    ASSERT_EQ(TaskState::SUCCESS, taskD->GetState());
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, ConcurrentProducers)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    static const size_t PRODUCERS = 4;
+    static const size_t TASKS = 250;
+
+    std::atomic<size_t> executed{0};
+    std::vector<std::vector<TaskPtr>> queued(PRODUCERS);
+    std::vector<std::thread> producers;
+
+    for (size_t i = 0; i < PRODUCERS; ++i)
+    {
+        producers.emplace_back([&, i](){
+            for (size_t j = 0; j < TASKS; ++j)
+            {
+                TaskPtr task = Task::Create([&executed]{ ++executed; });
+                if (!queued[i].empty()) task->Depends(queued[i].back());
+                scheduler->Enqueue(task);
+                queued[i].emplace_back(std::move(task));
+            }
+        });
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    for (auto& tasks : queued)
+    {
+        tasks.back()->Wait();
+        ASSERT_EQ(tasks.back()->GetState(), TaskState::SUCCESS);
+    }
+    ASSERT_EQ(executed.load(), PRODUCERS * TASKS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, BoundedProducers)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    params.capacity = 16;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    static const size_t PRODUCERS = 4;
+    static const size_t TASKS = 250;
+
+    // The shards share a single capacity, so producers regularly have to
+    // wait for tasks owned by any of them to finish.
+    std::atomic<size_t> executed{0};
+    std::vector<std::vector<TaskPtr>> queued(PRODUCERS);
+    std::vector<std::thread> producers;
+
+    for (size_t i = 0; i < PRODUCERS; ++i)
+    {
+        producers.emplace_back([&, i](){
+            for (size_t j = 0; j < TASKS; ++j)
+            {
+                TaskPtr task = Task::Create([&executed]{ ++executed; });
+                ASSERT_EQ(scheduler->Enqueue(task, std::chrono::seconds(30)),
+                    E_SUCCESS);
+                queued[i].emplace_back(std::move(task));
+            }
+        });
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    for (auto& tasks : queued)
+        for (TaskPtr& task : tasks) task->Wait();
+    ASSERT_EQ(executed.load(), PRODUCERS * TASKS);
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, BulkEnqueue)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // A batch is split between the shards which own its tasks, including
+    // dependencies which cross from one shard to another.
+    std::atomic<size_t> executed{0};
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < 256; ++i)
+    {
+        TaskPtr task = Task::Create([&executed]{ ++executed; });
+        if (i % 4 == 3) task->Depends(tasks[i - 1]);
+        tasks.emplace_back(std::move(task));
+    }
+
+    scheduler->Enqueue(tasks);
+    for (TaskPtr& task : tasks) task->Wait();
+    ASSERT_EQ(executed.load(), tasks.size());
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, CancelGroup)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+
+    // The children of the group are spread over the shards and each is
+    // cancelled by the shard which owns it.
+    std::vector<TaskPtr> children;
+    GroupPtr group = Task::Create<Group>();
+    for (size_t i = 0; i < 16; ++i)
+    {
+        children.emplace_back(Task::Create<Success>());
+        group->Add(children.back());
+    }
+    scheduler->Enqueue(group);
+
+    ASSERT_EQ(scheduler->Cancel(group), E_SUCCESS);
+    scheduler->Start();
+
+    group->Wait();
+    ASSERT_EQ(group->GetState(), TaskState::CANCELLED);
+    for (TaskPtr& child : children)
+    {
+        child->Wait();
+        ASSERT_EQ(child->GetState(), TaskState::CANCELLED);
+    }
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
+
+TEST(ShardedScheduler, UnqueuedDependencyIsReleased)
+{
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    params.shards = 4;
+    SchedulerPtr scheduler;
+    ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+    scheduler->Start();
+
+    // A is never queued. With this many dependents spread over the shards
+    // the shard owning A is all but certain to be watching it for others.
+    TaskPtr taskA = Task::Create<Success>();
+    std::vector<TaskPtr> dependents;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        task->Depends(taskA);
+        scheduler->Enqueue(task);
+        dependents.emplace_back(std::move(task));
+    }
+    for (TaskPtr& task : dependents)
+        while (task->GetState() == TaskState::NEW) std::this_thread::yield();
+
+    std::weak_ptr<Task> weakA = taskA;
+    taskA.reset();
+
+    // Once the last dependent has gone every shard lets go of A.
+    std::vector<std::weak_ptr<Task>> weakDependents;
+    for (TaskPtr& task : dependents)
+    {
+        ASSERT_EQ(scheduler->Cancel(task), E_SUCCESS);
+        task->Wait();
+        ASSERT_EQ(task->GetState(), TaskState::CANCELLED);
+        weakDependents.emplace_back(task);
+    }
+    dependents.clear();
+
+    for (int i = 0; i < 1000 && !weakA.expired(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (std::weak_ptr<Task>& weak : weakDependents)
+        ASSERT_TRUE(weak.expired());
+    ASSERT_TRUE(weakA.expired());
+
+    scheduler->Shutdown(true);
+    ASSERT_TRUE(scheduler->IsShutdown());
+}
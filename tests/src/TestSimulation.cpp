@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Simulation.h>
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Tests/Tasks.h>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::minutes;
+using std::chrono::seconds;
+
+TEST(Simulation, ClockOnlyMovesWhenTold)
+{
+    SimulatedClock clock(Clock::time_point(hours(1)));
+    ASSERT_EQ(clock.Now(), Clock::time_point(hours(1)));
+
+    clock.Advance(minutes(5));
+    ASSERT_EQ(clock.Now(), Clock::time_point(hours(1) + minutes(5)));
+
+    // Time never goes back.
+    clock.AdvanceTo(Clock::time_point(hours(1)));
+    clock.Advance(minutes(-5));
+    ASSERT_EQ(clock.Now(), Clock::time_point(hours(1) + minutes(5)));
+
+    ASSERT_EQ(SetTimeSource(&clock), nullptr);
+    ASSERT_EQ(Now(), clock.Now());
+    ASSERT_EQ(SetTimeSource(nullptr), &clock);
+    ASSERT_NE(Now(), clock.Now());
+}
+
+TEST(Simulation, OnlyOneAtATime)
+{
+    SimulationPtr simulation, other;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), other), E_FULL);
+    ASSERT_EQ(other, nullptr);
+
+    // The first simulation still owns the time source.
+    ASSERT_EQ(Now(), simulation->Now());
+    simulation.reset();
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), other), E_SUCCESS);
+}
+
+TEST(Simulation, DelayedTasksRunOnTime)
+{
+    static const int COUNT = 24;
+
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    const SchedulerPtr& scheduler = simulation->GetScheduler();
+    Clock::time_point start = simulation->Now();
+
+    // A task every hour of the day, queued in reverse.
+    std::vector<Clock::time_point> ran;
+    for (int i = COUNT; i > 0; --i)
+    {
+        TaskPtr task = Task::After(
+            [&ran]() { ran.emplace_back(Now()); },
+            start + hours(i));
+        scheduler->Enqueue(task);
+    }
+
+    ASSERT_EQ(simulation->RunFor(hours(COUNT) - minutes(1)), size_t(COUNT - 1));
+    ASSERT_EQ(simulation->Now(), start + hours(COUNT) - minutes(1));
+    ASSERT_EQ(simulation->RunFor(minutes(1)), 1u);
+
+    // Each ran on its hour, up to the timer slack, and no time passed while
+    // running them.
+    ASSERT_EQ(ran.size(), size_t(COUNT));
+    for (int i = 0; i < COUNT; ++i)
+    {
+        ASSERT_GE(ran[i], start + hours(i + 1));
+        ASSERT_LT(ran[i], start + hours(i + 1) + milliseconds(1));
+    }
+}
+
+TEST(Simulation, RunsInPriorityOrder)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    const SchedulerPtr& scheduler = simulation->GetScheduler();
+
+    std::vector<int> order;
+    std::vector<TaskPtr> tasks;
+    for (int i = 0; i < 4; ++i)
+    {
+        tasks.emplace_back(Task::Create([&order, i]() { order.emplace_back(i); }));
+        tasks.back()->SetPriority(static_cast<TaskPriority>(i % 2 ? 2 : 0));
+    }
+    scheduler->Enqueue(tasks);
+
+    ASSERT_EQ(simulation->RunUntilIdle(), 4u);
+    ASSERT_EQ(order, (std::vector<int>{ 1, 3, 0, 2 }));
+    ASSERT_EQ(simulation->RunUntilIdle(), 0u);
+}
+
+TEST(Simulation, DeadlinesExpireOnSimulatedTime)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    const SchedulerPtr& scheduler = simulation->GetScheduler();
+    Clock::time_point start = simulation->Now();
+
+    // B must finish within five seconds but waits on A, which starts after
+    // ten.
+    TaskPtr taskA = Task::After<Success>(start + seconds(10)),
+            taskB = Task::Before<Success>(start + seconds(5));
+    taskB->Depends(taskA);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+
+    simulation->RunFor(seconds(4));
+    ASSERT_EQ(taskB->GetState(), TaskState::PENDING);
+
+    simulation->RunFor(seconds(2));
+    ASSERT_EQ(taskB->GetState(), TaskState::CANCELLED);
+    ASSERT_FALSE(taskA->IsComplete());
+
+    simulation->RunFor(seconds(5));
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+}
+
+TEST(Simulation, RecurringTaskOverADay)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+
+    TaskPtr task = Task::Create<Success>();
+    task->SetRecurrence(Recurrence::FixedRate(minutes(1)));
+    simulation->GetScheduler()->Enqueue(task);
+
+    // Once straight away and then every minute of the day, without drift.
+    simulation->RunFor(hours(24));
+    ASSERT_EQ(task->GetRunCount(), 24u * 60 + 1);
+    ASSERT_EQ(task->GetMissedCount(), 0u);
+    ASSERT_EQ(task->GetState(), TaskState::PENDING);
+}
+
+TEST(Simulation, LatencyOnSimulatedTime)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    const SchedulerPtr& scheduler = simulation->GetScheduler();
+    Clock::time_point start = simulation->Now();
+
+    // A task which is held for an hour only counts as waiting once it may
+    // run, so on simulated time its wait is down to the timer slack.
+    TaskPtr task = Task::After<Success>(start + hours(1));
+    scheduler->Enqueue(task);
+    simulation->RunFor(hours(2));
+    ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+
+    const TaskTimes& times = task->GetTimes();
+    ASSERT_EQ(times.enqueued, start);
+    ASSERT_EQ(times.pending, start);
+    ASSERT_GE(times.dispatched, start + hours(1));
+    ASSERT_EQ(times.started, times.dispatched);
+    ASSERT_EQ(times.finished, times.started);
+
+    SchedulerStats stats;
+    scheduler->GetStats(stats);
+    ASSERT_EQ(stats.intake.GetMax(), Clock::duration::zero());
+    ASSERT_EQ(stats.waiting.GetCount(), 1u);
+    ASSERT_LT(stats.waiting.GetMax(), milliseconds(1));
+    ASSERT_EQ(stats.executor.queued.GetMax(), Clock::duration::zero());
+    ASSERT_EQ(stats.executor.running.GetCount(), 1u);
+}
+
+TEST(Simulation, UnqueuedDependencyIsReleased)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+
+    // B waits on A, which is never queued. Once B times out nothing is left
+    // waiting on A and the scheduler lets go of it.
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>();
+    taskB->Depends(taskA);
+    simulation->GetScheduler()->Enqueue(taskB);
+
+    std::weak_ptr<Task> weakA = taskA;
+    taskA.reset();
+
+    simulation->RunFor(minutes(1));
+    ASSERT_EQ(taskB->GetState(), TaskState::FAILED);
+    ASSERT_FALSE(weakA.expired());
+
+    taskB.reset();
+    ASSERT_TRUE(weakA.expired());
+}
+
+TEST(Simulation, RetriesReplayExactly)
+{
+    static const int COUNT = 4;
+
+    // The jitter on retries is the same from one run to the next.
+    auto run = []()
+    {
+        std::vector<Clock::time_point> retried;
+        SimulationPtr simulation;
+        EXPECT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+        if (!simulation) return retried;
+
+        std::vector<TaskPtr> tasks;
+        for (int i = 0; i < COUNT; ++i)
+        {
+            tasks.emplace_back(Task::Create<Unavailable>());
+            tasks.back()->SetRetryLimit(6);
+            simulation->GetScheduler()->Enqueue(tasks.back());
+        }
+
+        simulation->RunFor(hours(1));
+        for (const TaskPtr& task : tasks)
+        {
+            EXPECT_EQ(task->GetState(), TaskState::FAILED);
+            EXPECT_EQ(task->GetRetryCount(), 6u);
+            retried.emplace_back(task->After());
+        }
+        return retried;
+    };
+
+    std::vector<Clock::time_point> first = run();
+    ASSERT_EQ(first.size(), size_t(COUNT));
+    ASSERT_EQ(run(), first);
+}
+
+TEST(Simulation, CronFollowsSimulatedTime)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    Clock::time_point start = simulation->Now();
+
+    // Simulated time starts at midnight on the wall clock, so the first
+    // run is on the hour.
+    std::vector<Clock::time_point> ran;
+    TaskPtr task = Task::After(
+        [&ran]() { ran.emplace_back(Now()); },
+        start + hours(1));
+    task->SetRecurrence(Recurrence::Cron("@hourly"));
+    simulation->GetScheduler()->Enqueue(task);
+
+    simulation->RunFor(hours(24));
+    ASSERT_EQ(ran.size(), 24u);
+    for (size_t i = 0; i < ran.size(); ++i)
+        ASSERT_EQ(ran[i], start + hours(i + 1));
+    ASSERT_EQ(task->GetMissedCount(), 0u);
+}
+
+TEST(Simulation, DelayedDependencyIsWaitedOn)
+{
+    SimulationPtr simulation;
+    ASSERT_EQ(Simulation::Create(SchedulerParams(), simulation), E_SUCCESS);
+    const SchedulerPtr& scheduler = simulation->GetScheduler();
+
+    // A dependency waiting for its start time has been queued, however far
+    // past the unqueued dependency timeout that is.
+    TaskPtr taskA = Task::After(
+        []() { },
+        simulation->Now() + minutes(1));
+    TaskPtr taskB = Task::Create<Success>();
+    taskB->Depends(taskA);
+    scheduler->Enqueue(taskA);
+    scheduler->Enqueue(taskB);
+
+    simulation->RunFor(minutes(2));
+    ASSERT_EQ(taskA->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(taskB->GetState(), TaskState::SUCCESS);
+}
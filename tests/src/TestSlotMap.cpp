@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/SlotMap.h>
+#include <memory>
+#include <vector>
+
+using namespace Scheduler::Lib;
+
+TEST(SlotMap, InsertGetErase)
+{
+    SlotMap<int> map;
+    ASSERT_TRUE(map.Empty());
+    ASSERT_EQ(map.Get(INVALID_HANDLE), nullptr);
+
+    SlotHandle a = map.Insert(1),
+               b = map.Insert(2);
+    ASSERT_NE(a, INVALID_HANDLE);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(map.Size(), 2U);
+    ASSERT_EQ(*map.Get(a), 1);
+    ASSERT_EQ(*map.Get(b), 2);
+
+    ASSERT_TRUE(map.Erase(a));
+    ASSERT_FALSE(map.Erase(a));
+    ASSERT_EQ(map.Get(a), nullptr);
+    ASSERT_EQ(*map.Get(b), 2);
+    ASSERT_EQ(map.Size(), 1U);
+}
+
+TEST(SlotMap, StaleHandleAfterReuse)
+{
+    SlotMap<int> map;
+
+    SlotHandle a = map.Insert(1);
+    ASSERT_TRUE(map.Erase(a));
+
+    // The freed slot is reused but the old handle must not see the value
+    // which now lives in it.
+    SlotHandle b = map.Insert(2);
+    ASSERT_EQ(SlotMap<int>::Index(a), SlotMap<int>::Index(b));
+    ASSERT_NE(a, b);
+    ASSERT_EQ(map.Get(a), nullptr);
+    ASSERT_FALSE(map.Contains(a));
+    ASSERT_EQ(*map.Get(b), 2);
+    ASSERT_EQ(map.Capacity(), 1U);
+}
+
+TEST(SlotMap, ClearReleasesValues)
+{
+    SlotMap<std::shared_ptr<int>> map;
+    std::shared_ptr<int> value = std::make_shared<int>(7);
+
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 16; ++i)
+        handles.emplace_back(map.Insert(std::shared_ptr<int>(value)));
+    ASSERT_EQ(value.use_count(), 17);
+
+    map.Clear();
+    ASSERT_TRUE(map.Empty());
+    ASSERT_EQ(value.use_count(), 1);
+    for (SlotHandle handle : handles) ASSERT_FALSE(map.Contains(handle));
+
+    // Cleared slots are reused before the map grows.
+    map.Insert(std::shared_ptr<int>(value));
+    ASSERT_EQ(map.Capacity(), 16U);
+}
@@ -4,7 +4,10 @@
 #include <Scheduler/Lib/Task.h>
 #include <Scheduler/Tests/ClockUtils.h>
 #include <Scheduler/Tests/Tasks.h>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 using std::chrono::seconds;
 using namespace Scheduler;
@@ -327,3 +330,195 @@ TEST(TaskDependencies, CircularDependencies)
     ASSERT_FALSE(taskB->IsValid());
     ASSERT_FALSE(taskA->IsValid());
 }
+
+TEST(TaskDependencies, DiamondsAreSearchedOnce)
+{
+    // Forty layers of two tasks each depending on both below: 2^40 paths
+    // from top to bottom, which only finishes if each task is visited once.
+    std::vector<TaskPtr> below;
+    TaskPtr bottom = Task::Create<Success>();
+    below.emplace_back(bottom);
+    for (int layer = 0; layer < 40; ++layer)
+    {
+        std::vector<TaskPtr> current;
+        for (int i = 0; i < 2; ++i)
+        {
+            TaskPtr task = Task::Create<Success>();
+            for (TaskPtr& dependency : below) task->Depends(dependency);
+            current.emplace_back(std::move(task));
+        }
+        below.swap(current);
+    }
+
+    TaskPtr top = below.front();
+    ASSERT_TRUE(top->IsValid());
+    ASSERT_TRUE(top->Requires(bottom));
+    ASSERT_TRUE(top->Requires(bottom->Id()));
+    ASSERT_FALSE(bottom->Requires(top));
+    ASSERT_FALSE(top->Requires(below.back()));
+
+    bottom->Depends(top);
+    ASSERT_FALSE(bottom->IsValid());
+    ASSERT_FALSE(top->IsValid());
+    ASSERT_TRUE(bottom->Requires(top));
+    ASSERT_TRUE(top->Requires(bottom));
+}
+
+TEST(TaskDependencies, InvalidityReachesDependents)
+{
+    TaskPtr taskA = Task::Create<Success>(),
+            taskB = Task::Create<Success>(),
+            taskC = Task::Create<Success>();
+
+    taskA->Depends(taskB);
+    taskC->Depends(taskB);
+    ASSERT_TRUE(taskA->IsValid());
+    ASSERT_TRUE(taskC->IsValid());
+
+    // A task invalidated after others came to depend on it takes them
+    // along, and anything depending on it later starts out invalid.
+    taskB->SetRecurrence(Recurrence::FixedRate(Clock::duration::zero()));
+    ASSERT_FALSE(taskB->IsValid());
+    ASSERT_FALSE(taskA->IsValid());
+    ASSERT_FALSE(taskC->IsValid());
+
+    TaskPtr taskD = Task::Create<Success>();
+    taskD->Depends(taskA);
+    ASSERT_FALSE(taskD->IsValid());
+}
+
+TEST(TaskDependencies, InvalidityRacesWiring)
+{
+    static const int COUNT = 1000;
+
+    // Dependents wired while the task is invalidated either see it invalid
+    // or are marked by the invalidation, never neither.
+    TaskPtr task = Task::Create<Success>();
+    std::vector<TaskPtr> dependents;
+    std::atomic<int> wired{0};
+    std::thread thread([&task, &dependents, &wired]()
+    {
+        for (int i = 0; i < COUNT; ++i)
+        {
+            TaskPtr dependent = Task::Create<Success>();
+            dependent->Depends(task);
+            dependents.emplace_back(std::move(dependent));
+            wired.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    while (wired.load(std::memory_order_acquire) < COUNT / 2)
+        std::this_thread::yield();
+    task->SetRecurrence(Recurrence::FixedRate(Clock::duration::zero()));
+    thread.join();
+
+    ASSERT_FALSE(task->IsValid());
+    for (const TaskPtr& dependent : dependents)
+        ASSERT_FALSE(dependent->IsValid());
+}
+
+TEST(TaskDependencies, GraphsWiredConcurrently)
+{
+    static const int THREADS = 4;
+    static const int LENGTH = 200;
+
+    // Each thread builds a line of its own and ties it to a common task
+    // halfway through, joining graphs which other threads are still adding
+    // to.
+    TaskPtr common = Task::Create<Success>();
+    std::vector<TaskPtr> tops(THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; ++i)
+    {
+        threads.emplace_back([&common, &tops, i]()
+        {
+            TaskPtr below = Task::Create<Success>();
+            for (int j = 0; j < LENGTH; ++j)
+            {
+                TaskPtr task = Task::Create<Success>();
+                task->Depends(below);
+                if (j == LENGTH / 2) task->Depends(common);
+                below = std::move(task);
+            }
+            tops[i] = std::move(below);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    for (const TaskPtr& top : tops)
+    {
+        ASSERT_TRUE(top->IsValid());
+        ASSERT_TRUE(top->Requires(common));
+        ASSERT_FALSE(common->Requires(top));
+    }
+
+    // Closing a loop through one line invalidates the tops of all of them.
+    common->Depends(tops.front());
+    for (const TaskPtr& top : tops) ASSERT_FALSE(top->IsValid());
+}
+
+TEST(TaskDependencies, LongLineIsDestroyed)
+{
+    // Each task holds the only reference to the one below, so dropping the
+    // top takes the whole line with it, which must not recurse per task.
+    TaskPtr top = Task::Create<Success>();
+    std::weak_ptr<Task> bottom = top;
+    for (int i = 0; i < 100000; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        task->Depends(top);
+        top = std::move(task);
+    }
+
+    top.reset();
+    ASSERT_TRUE(bottom.expired());
+}
+
+TEST(TaskDependencies, SelfDependency)
+{
+    TaskPtr task = Task::Create<Success>();
+    task->Depends(task);
+    ASSERT_FALSE(task->IsValid());
+}
+
+TEST(TaskConstruction, FeasibilityWithEstimate)
+{
+    Clock::time_point now = Clock::now();
+    TaskPtr task = Task::Before<Success>(now + seconds(10));
+    ASSERT_TRUE(task->IsFeasible(now));
+    ASSERT_FALSE(task->IsFeasible(now + seconds(11)));
+
+    task->SetEstimate(seconds(5));
+    ASSERT_EQ(task->GetEstimate(), seconds(5));
+    ASSERT_TRUE(task->IsFeasible(now + seconds(5)));
+    ASSERT_FALSE(task->IsFeasible(now + seconds(6)));
+
+    // Tasks without a deadline can always be run.
+    TaskPtr unbounded = Task::Create<Success>();
+    unbounded->SetEstimate(seconds(60));
+    ASSERT_TRUE(unbounded->IsFeasible(now + seconds(3600)));
+}
+
+TEST(TaskConstruction, TimeChecksAgainstGivenTime)
+{
+    Clock::time_point now = Clock::now();
+    TaskPtr task = Task::Between<Success>(now + seconds(10), now + seconds(20));
+    ASSERT_TRUE(task->IsPremature(now));
+    ASSERT_FALSE(task->IsPremature(now + seconds(10)));
+    ASSERT_FALSE(task->IsExpired(now + seconds(20)));
+    ASSERT_TRUE(task->IsExpired(now + seconds(21)));
+
+    // Tasks without a window are never premature or expired.
+    TaskPtr unbounded = Task::Create<Success>();
+    ASSERT_FALSE(unbounded->IsPremature(Clock::time_point::min()));
+    ASSERT_FALSE(unbounded->IsExpired(Clock::time_point::max() - seconds(1)));
+}
+
+TEST(TaskConstruction, LayoutStaysSmall)
+{
+    // Every task the scheduler tracks pays for this, and the pool rounds it
+    // up to a whole block. 216 bytes with a 64-bit standard library; grow
+    // the bound on purpose rather than by accident.
+    if (sizeof(void*) != 8) return;
+    ASSERT_LE(sizeof(Task), 216u);
+}
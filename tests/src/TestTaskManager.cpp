@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/MemoryTaskManager.h>
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Tests/Tasks.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+
+    // Run rounds of tasks through a scheduler in the given mode, checking
+    // that neither the tasks nor their outcomes pile up in the manager
+    // however many finish.
+    void RunRounds(SchedulingMode mode)
+    {
+        static const size_t ROUNDS = 20;
+        static const size_t COUNT = 100;
+
+        TaskManagerParams managerParams;
+        managerParams.outcomes = COUNT;
+        std::shared_ptr<MemoryTaskManager> manager =
+            std::make_shared<MemoryTaskManager>(managerParams);
+
+        SchedulerParams params;
+        params.manager = manager.get();
+        params.mode = mode;
+        SchedulerPtr scheduler;
+        ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+        scheduler->Start();
+
+        TaskPtr first, last;
+        for (size_t round = 0; round < ROUNDS; ++round)
+        {
+            std::vector<TaskPtr> tasks;
+            for (size_t i = 0; i < COUNT; ++i)
+                tasks.emplace_back(Task::Create<Success>());
+            if (!first) first = tasks.front();
+            last = tasks.back();
+
+            scheduler->Enqueue(tasks);
+            for (TaskPtr& task : tasks) task->Wait();
+
+            // The manager may hear about a task just after it completes.
+            Clock::time_point until = Clock::now() + seconds(5);
+            while (manager->GetTaskCount() > 0 && Clock::now() < until)
+                std::this_thread::sleep_for(milliseconds(1));
+            ASSERT_EQ(manager->GetTaskCount(), 0u);
+            ASSERT_LE(manager->GetOutcomeCount(), COUNT);
+        }
+
+        // Only the most recent outcomes are remembered.
+        TaskPtr found;
+        ASSERT_EQ(manager->GetTask(last->Id(), found), E_COMPLETED);
+        ASSERT_EQ(manager->GetTask(first->Id(), found), E_NOT_FOUND);
+        scheduler->Shutdown(true);
+    }
+
+    // A manager which rejects every ID it is asked to look up.
+    class RejectingTaskManager : public MemoryTaskManager
+    {
+    public:
+        using MemoryTaskManager::MemoryTaskManager;
+
+        Error GetTask(const UUID&, TaskPtr&) const override
+        {
+            return E_INVALID_ARGUMENT;
+        }
+    };
+
+    // Cancelling a task the scheduler does not hold asks the manager, whose
+    // error is passed on rather than taken to mean the task completed.
+    void CancelWithFailingLookup(SchedulingMode mode)
+    {
+        std::shared_ptr<MemoryTaskManager> manager =
+            std::make_shared<RejectingTaskManager>(TaskManagerParams());
+
+        SchedulerParams params;
+        params.manager = manager.get();
+        params.mode = mode;
+        SchedulerPtr scheduler;
+        ASSERT_EQ(TaskScheduler::Create(params, scheduler), E_SUCCESS);
+        scheduler->Start();
+
+        ASSERT_EQ(scheduler->Cancel(UUID(true)), E_INVALID_ARGUMENT);
+        scheduler->Shutdown(true);
+    }
+
+}  // namespace
+
+TEST(MemoryTaskManager, LetsGoOfFinishedTasks)
+{
+    RunRounds(SchedulingMode::CENTRALIZED);
+}
+
+TEST(MemoryTaskManager, LetsGoOfFinishedTasksDecentralized)
+{
+    RunRounds(SchedulingMode::DECENTRALIZED);
+}
+
+TEST(MemoryTaskManager, CancelPassesOnLookupError)
+{
+    CancelWithFailingLookup(SchedulingMode::CENTRALIZED);
+}
+
+TEST(MemoryTaskManager, CancelPassesOnLookupErrorDecentralized)
+{
+    CancelWithFailingLookup(SchedulingMode::DECENTRALIZED);
+}
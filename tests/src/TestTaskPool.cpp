@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/Task.h>
+#include <Scheduler/Lib/TaskPool.h>
+#include <Scheduler/Tests/Tasks.h>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tests;
+
+TEST(TaskPool, ReusesBlocksOnTheSameThread)
+{
+    TaskPtr first = Task::Create<Success>();
+    const Task* address = first.get();
+    first.reset();
+
+    TaskPoolStats before = TaskPool::GetStats();
+    TaskPtr second = Task::Create<Success>();
+    ASSERT_EQ(second.get(), address);
+    ASSERT_EQ(TaskPool::GetStats().fresh, before.fresh);
+}
+
+TEST(TaskPool, LargeBlocksBypassThePool)
+{
+    const size_t size = TaskPool::BLOCK_SIZE * TaskPool::SIZE_CLASSES + 1;
+
+    TaskPoolStats before = TaskPool::GetStats();
+    void* block = TaskPool::Allocate(size);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(TaskPool::GetStats().fresh, before.fresh + 1);
+
+    TaskPool::Deallocate(block, size);
+    ASSERT_EQ(TaskPool::GetStats().released, before.released + 1);
+}
+
+TEST(TaskPool, CarriesBlocksBackAcrossThreads)
+{
+    static const size_t COUNT = 256;
+
+    // Tasks made on short lived threads and destroyed on this one. Once the
+    // first round has filled the pool, later rounds recycle its blocks
+    // rather than going to the heap for them.
+    uint64_t fresh = 0;
+    for (int round = 0; round < 3; ++round)
+    {
+        std::vector<TaskPtr> tasks;
+        uint64_t before = TaskPool::GetStats().fresh;
+        std::thread producer([&tasks]{
+            for (size_t i = 0; i < COUNT; ++i)
+                tasks.emplace_back(Task::Create<Success>());
+        });
+        producer.join();
+        fresh = TaskPool::GetStats().fresh - before;
+        tasks.clear();
+    }
+    ASSERT_LT(fresh, COUNT / 2);
+}
+
+namespace {
+
+    // Blocks held by a thread-local object made before the thread's cache,
+    // and so freed after the cache is gone.
+    struct LateBlocks
+    {
+        ~LateBlocks()
+        {
+            for (void* block : blocks) TaskPool::Deallocate(block, size);
+        }
+
+        size_t size = 0;
+        std::vector<void*> blocks;
+    };
+
+}  // namespace
+
+TEST(TaskPool, LateFreesDoNotFillTheDepot)
+{
+    const size_t size = TaskPool::BLOCK_SIZE * TaskPool::SIZE_CLASSES;
+
+    // Empty the depot of this block size, which tasks are too small for,
+    // and take enough blocks to spill a full batch back to it later.
+    std::vector<void*> blocks;
+    uint64_t fresh = TaskPool::GetStats().fresh;
+    while (TaskPool::GetStats().fresh == fresh)
+        blocks.emplace_back(TaskPool::Allocate(size));
+    for (size_t i = 0; i < 2 * TaskPool::BATCH_SIZE; ++i)
+        blocks.emplace_back(TaskPool::Allocate(size));
+
+    std::thread late([size]{
+        thread_local LateBlocks late;
+        late.size = size;
+        for (size_t i = 0; i < TaskPool::DEPOT_BATCHES; ++i)
+            late.blocks.emplace_back(TaskPool::Allocate(size));
+    });
+    late.join();
+
+    // The depot still has room for a full batch.
+    uint64_t released = TaskPool::GetStats().released;
+    for (void* block : blocks) TaskPool::Deallocate(block, size);
+    ASSERT_EQ(TaskPool::GetStats().released, released);
+}
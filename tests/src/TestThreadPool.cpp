@@ -4,6 +4,10 @@
 #include <Scheduler/Lib/Task.h>
 #include <Scheduler/Lib/TaskRunner.h>
 #include <Scheduler/Tests/Tasks.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace Scheduler;
 using namespace Scheduler::Lib;
@@ -31,3 +35,288 @@ TEST(ExecutorInit, StartupAndShutdown)
     ASSERT_TRUE(task->IsComplete());
     executor->Shutdown(true);
 }
+
+TEST(ExecutorInit, EnqueueTakesOverTheRunner)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    // Handing the runner over moves the caller's reference rather than
+    // taking another. The executor keeps the only one.
+    TaskPtr task = Task::Create<Success>();
+    TaskPtr t = task;
+    TaskRunnerPtr runner = TaskRunner::Create(
+        std::move(t),
+        std::weak_ptr<TaskScheduler>());
+    executor->Enqueue(std::move(runner));
+    ASSERT_EQ(runner, nullptr);
+
+    task->Wait();
+    ASSERT_EQ(task->GetState(), TaskState::SUCCESS);
+    executor->Shutdown(true);
+}
+
+namespace {
+
+    // Queue a task on the executor without a scheduler. Each task appends
+    // its tag to the shared order once it runs.
+    TaskPtr EnqueueTagged(
+        ExecutorPtr& executor,
+        std::vector<int>& order,
+        std::mutex& mutex,
+        int tag,
+        TaskPriority priority)
+    {
+        TaskPtr task = Task::Create([&order, &mutex, tag]{
+            std::lock_guard<std::mutex> lock(mutex);
+            order.emplace_back(tag);
+        });
+        task->SetPriority(priority);
+
+        TaskPtr t = task;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+        return task;
+    }
+
+}  // namespace
+
+TEST(ThreadPool, PriorityOrdering)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+    params.agingInterval = Clock::duration::zero();
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    // Hold the only worker so everything else queues up behind it.
+    std::atomic<bool> release{false};
+    TaskPtr gate = Task::Create([&release]{
+        while (!release) std::this_thread::yield();
+    });
+    {
+        TaskPtr t = gate;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+    }
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<TaskPtr> tasks;
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 0, TaskPriority::LOW));
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 1, TaskPriority::NORMAL));
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 2, TaskPriority::LOW));
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 3, TaskPriority::CRITICAL));
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 4, TaskPriority::HIGH));
+
+    release = true;
+    for (TaskPtr& task : tasks) task->Wait();
+
+    ASSERT_EQ(order, (std::vector<int>{ 3, 4, 1, 0, 2 }));
+    executor->Shutdown(true);
+}
+
+TEST(ThreadPool, PriorityAging)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+    params.agingInterval = std::chrono::milliseconds(5);
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    std::atomic<bool> release{false};
+    TaskPtr gate = Task::Create([&release]{
+        while (!release) std::this_thread::yield();
+    });
+    {
+        TaskPtr t = gate;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+    }
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<TaskPtr> tasks;
+
+    // The low priority task waits long enough to age past the critical
+    // one queued just before the worker frees up.
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 0, TaskPriority::LOW));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    tasks.emplace_back(EnqueueTagged(executor, order, mutex, 1, TaskPriority::CRITICAL));
+
+    release = true;
+    for (TaskPtr& task : tasks) task->Wait();
+
+    ASSERT_EQ(order, (std::vector<int>{ 0, 1 }));
+    executor->Shutdown(true);
+}
+
+TEST(ThreadPool, DeadlineOrdering)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+    params.agingInterval = Clock::duration::zero();
+    params.dispatchPolicy = DispatchPolicy::DEADLINE;
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    std::atomic<bool> release{false};
+    TaskPtr gate = Task::Create([&release]{
+        while (!release) std::this_thread::yield();
+    });
+    {
+        TaskPtr t = gate;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+    }
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<TaskPtr> tasks;
+
+    // Tasks without a deadline go after those with one, in FIFO order.
+    Clock::time_point now = Clock::now();
+    Clock::time_point deadlines[] = {
+        now + std::chrono::seconds(30),
+        now + std::chrono::seconds(10),
+        Clock::time_point::max(),
+        now + std::chrono::seconds(20),
+        Clock::time_point::max()
+    };
+    for (int tag = 0; tag < 5; ++tag)
+    {
+        TaskPtr task = Task::Before([&order, &mutex, tag]{
+            std::lock_guard<std::mutex> lock(mutex);
+            order.emplace_back(tag);
+        }, deadlines[tag]);
+
+        TaskPtr t = task;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+        tasks.emplace_back(std::move(task));
+    }
+
+    release = true;
+    for (TaskPtr& task : tasks) task->Wait();
+
+    ASSERT_EQ(order, (std::vector<int>{ 1, 3, 0, 2, 4 }));
+    executor->Shutdown(true);
+}
+
+TEST(ThreadPool, DeadlineShedsInfeasibleTasks)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+    params.dispatchPolicy = DispatchPolicy::DEADLINE;
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    // The estimate puts the end of the task well past its deadline so the
+    // worker drops it instead of running it.
+    std::atomic<bool> ran{false};
+    TaskPtr task = Task::Before([&ran]{ ran = true; },
+        Clock::now() + std::chrono::seconds(10));
+    task->SetEstimate(std::chrono::seconds(60));
+    {
+        TaskPtr t = task;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+    }
+
+    task->Wait();
+    ASSERT_FALSE(ran);
+    ASSERT_EQ(task->GetState(), TaskState::CANCELLED);
+    executor->Shutdown(true);
+}
+
+TEST(ThreadPool, CancelQueuedTask)
+{
+    ExecutorParams params;
+    params.concurrency = 1;
+
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    // Hold the only worker so the task stays queued behind it.
+    std::atomic<bool> started{false}, release{false}, ran{false};
+    TaskPtr gate = Task::Create([&started, &release]{
+        started = true;
+        while (!release) std::this_thread::yield();
+    });
+    TaskPtr task = Task::Create([&ran]{ ran = true; });
+    for (TaskPtr* t : { &gate, &task })
+    {
+        TaskPtr copy = *t;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(copy));
+        executor->Enqueue(runner);
+    }
+    while (!started) std::this_thread::yield();
+
+    // The running gate can no longer be cancelled, while the queued task
+    // is tombstoned once and then dropped when its turn comes.
+    ASSERT_EQ(executor->Cancel(gate->Id()), E_NOT_FOUND);
+    ASSERT_EQ(executor->Cancel(task->Id()), E_SUCCESS);
+    ASSERT_EQ(executor->Cancel(task->Id()), E_NOT_FOUND);
+
+    release = true;
+    gate->Wait();
+    task->Wait();
+    ASSERT_FALSE(ran);
+    ASSERT_EQ(gate->GetState(), TaskState::SUCCESS);
+    ASSERT_EQ(task->GetState(), TaskState::CANCELLED);
+    ASSERT_TRUE(task->IsCancellationRequested());
+    executor->Shutdown(true);
+}
+
+TEST(ThreadPoolExecutor, WorkerStats)
+{
+    const size_t TASKS = 32;
+
+    ExecutorParams params;
+    params.concurrency = 2;
+    ExecutorPtr executor;
+    ASSERT_EQ(Executor::Create(params, executor), E_SUCCESS);
+
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < TASKS; ++i)
+    {
+        TaskPtr task = Task::Create<Success>();
+        TaskPtr t = task;
+        TaskRunnerPtr runner = std::make_shared<TaskRunner>(std::move(t));
+        executor->Enqueue(runner);
+        tasks.emplace_back(std::move(task));
+    }
+    for (TaskPtr& task : tasks)
+    {
+        task->Wait();
+        const TaskTimes& times = task->GetTimes();
+        ASSERT_LE(times.started, times.finished);
+    }
+
+    std::vector<ExecutorStats> workers;
+    executor->GetWorkerStats(workers);
+    ASSERT_EQ(workers.size(), 2u);
+
+    // Tasks handed over without a scheduler were never dispatched, so only
+    // their running time is known.
+    ExecutorStats stats;
+    executor->GetStats(stats);
+    ASSERT_EQ(stats.running.GetCount(), TASKS);
+    ASSERT_EQ(stats.queued.GetCount(), 0u);
+    ASSERT_EQ(
+        workers[0].running.GetCount() + workers[1].running.GetCount(),
+        TASKS);
+
+    // What the workers recorded outlives them.
+    executor->Shutdown(true);
+    ExecutorStats retired;
+    executor->GetStats(retired);
+    ASSERT_EQ(retired.running.GetCount(), TASKS);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <Scheduler/Lib/TimerWheel.h>
+#include <Scheduler/Lib/SlotMap.h>
+#include <algorithm>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(TimerWheel, ExpireInOrder)
+{
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(1), origin);
+
+    SlotHandle idA = 1, idB = 2, idC = 3;
+    wheel.Schedule(idC, origin + seconds(90));
+    wheel.Schedule(idA, origin + milliseconds(5));
+    wheel.Schedule(idB, origin + seconds(2));
+    ASSERT_EQ(wheel.Size(), 3U);
+    ASSERT_EQ(wheel.NextExpiry(), origin + milliseconds(5));
+
+    std::vector<SlotHandle> expired;
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(4), expired), 0U);
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(5), expired), 1U);
+    ASSERT_EQ(expired.back(), idA);
+
+    ASSERT_EQ(wheel.Expire(origin + seconds(2) - milliseconds(1), expired), 0U);
+    ASSERT_EQ(wheel.Expire(origin + seconds(2), expired), 1U);
+    ASSERT_EQ(expired.back(), idB);
+
+    ASSERT_EQ(wheel.Expire(origin + seconds(90), expired), 1U);
+    ASSERT_EQ(expired.back(), idC);
+    ASSERT_TRUE(wheel.Empty());
+    ASSERT_EQ(wheel.NextExpiry(), Clock::time_point::max());
+}
+
+TEST(TimerWheel, CancelAndReschedule)
+{
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(1), origin);
+
+    SlotHandle idA = 1, idB = 2;
+    wheel.Schedule(idA, origin + milliseconds(10));
+    wheel.Schedule(idB, origin + milliseconds(10));
+    ASSERT_TRUE(wheel.Cancel(idA));
+    ASSERT_FALSE(wheel.Cancel(idA));
+    ASSERT_FALSE(wheel.Contains(idA));
+
+    // Rescheduling replaces the previous deadline.
+    wheel.Schedule(idB, origin + milliseconds(20));
+
+    std::vector<SlotHandle> expired;
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(15), expired), 0U);
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(20), expired), 1U);
+    ASSERT_EQ(expired.front(), idB);
+    ASSERT_TRUE(wheel.Empty());
+}
+
+TEST(TimerWheel, CoalesceWithinSlack)
+{
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(100), origin);
+
+    std::vector<SlotHandle> ids(10);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        ids[i] = i + 1;
+        wheel.Schedule(ids[i], origin + milliseconds(101 + i * 10));
+    }
+
+    // Every deadline falls into the same window and is released by a
+    // single wakeup at the end of it, never before the deadline itself.
+    ASSERT_EQ(wheel.NextExpiry(), origin + milliseconds(200));
+
+    std::vector<SlotHandle> expired;
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(199), expired), 0U);
+    ASSERT_EQ(wheel.Expire(origin + milliseconds(200), expired), ids.size());
+}
+
+TEST(TimerWheel, PastAndDistantDeadlines)
+{
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(1), origin);
+
+    SlotHandle past = 1, distant = 2;
+    wheel.Schedule(past, origin - seconds(1));
+    wheel.Schedule(distant, origin + hours(24 * 365 * 3));
+
+    ASSERT_LE(wheel.NextExpiry(), origin);
+
+    std::vector<SlotHandle> expired;
+    ASSERT_EQ(wheel.Expire(origin, expired), 1U);
+    ASSERT_EQ(expired.front(), past);
+
+    ASSERT_EQ(wheel.Expire(origin + hours(24 * 365), expired), 0U);
+    ASSERT_EQ(wheel.Expire(origin + hours(24 * 365 * 3), expired), 1U);
+    ASSERT_EQ(expired.back(), distant);
+}
+
+TEST(TimerWheel, ManyTimers)
+{
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(1), origin);
+
+    std::vector<SlotHandle> ids(5000);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        ids[i] = i + 1;
+        wheel.Schedule(ids[i], origin + milliseconds((i * 7919) % 300000));
+    }
+
+    size_t total = 0;
+    std::vector<SlotHandle> expired;
+    for (Clock::time_point now = origin; now <= origin + seconds(300);
+        now += milliseconds(250))
+    {
+        total += wheel.Expire(now, expired);
+    }
+    ASSERT_EQ(total, ids.size());
+    ASSERT_TRUE(wheel.Empty());
+}
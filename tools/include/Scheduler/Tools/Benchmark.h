@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Scheduler/Common/Clock.h>
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+
+namespace Scheduler {
+namespace Tools {
+
+    class Benchmark
+    {
+        Benchmark(const Benchmark&) = delete;
+        Benchmark& operator=(const Benchmark&) = delete;
+
+    public:
+        typedef void (*BenchmarkFn)(std::ostream& out);
+
+        /// Register a benchmark with the global list. Benchmarks are expected
+        /// to be declared statically through the SCHEDULER_BENCHMARK macro.
+        Benchmark(const char* name, BenchmarkFn fn);
+
+        /// Retrieve every benchmark registered with the executable.
+        static const std::vector<const Benchmark*>& All();
+
+        const char* Name() const { return m_name; }
+
+        void Run(std::ostream& out) const { m_fn(out); }
+
+    private:
+        const char* m_name = nullptr;
+        BenchmarkFn m_fn = nullptr;
+    };
+
+    /// Simple elapsed time measurement against the scheduler clock.
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : m_start(Clock::now()) { }
+
+        Clock::duration Elapsed() const { return Clock::now() - m_start; }
+
+        double Microseconds() const
+        {
+            return std::chrono::duration<double, std::micro>(Elapsed()).count();
+        }
+
+        void Reset() { m_start = Clock::now(); }
+
+    private:
+        Clock::time_point m_start;
+    };
+
+}  // namespace Tools
+}  // namespace Scheduler
+
+#define SCHEDULER_BENCHMARK(name)                                           \
+    static void Benchmark_##name(std::ostream& out);                        \
+    static const ::Scheduler::Tools::Benchmark s_benchmark_##name(          \
+        #name, &Benchmark_##name);                                          \
+    static void Benchmark_##name(std::ostream& out)
@@ -0,0 +1,119 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+// Count every trip to the heap made by the benchmark executable. Counting
+// is a relaxed increment, which the other benchmarks can live with.
+namespace {
+
+    std::atomic<uint64_t> s_allocations{0};
+
+}  // namespace
+
+void* operator new(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+    const size_t TASKS = 100000;
+    const size_t ROUNDS = 3;
+    const size_t RUN_TASKS = 2000;
+
+    class Noop : public Task
+    {
+    public:
+        Noop() { }
+        ~Noop() { }
+
+    private:
+        TaskResult Run(ResultPtr&) override { return TaskResult::SUCCESS; }
+    };
+
+    // Create and drop tasks one at a time, reporting heap allocations and
+    // time per task.
+    template<typename Fn>
+    void MeasureCreate(std::ostream& out, const char* name, Fn&& create)
+    {
+        uint64_t before = s_allocations.load(std::memory_order_relaxed);
+        Stopwatch watch;
+        for (size_t i = 0; i < TASKS; ++i)
+        {
+            TaskPtr task = create();
+        }
+        double elapsed = watch.Microseconds();
+        uint64_t allocations = s_allocations.load(std::memory_order_relaxed) - before;
+
+        out << "  " << std::setw(12) << std::left << name << std::right
+            << "  allocs/task="
+            << static_cast<double>(allocations) / TASKS
+            << "  create+destroy=" << elapsed * 1000.0 / TASKS << "ns/task\n";
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(TaskAllocation)
+{
+    out << std::fixed << std::setprecision(2);
+
+    MeasureCreate(out, "new", []{ return TaskPtr(new Noop()); });
+    MeasureCreate(out, "make_shared", []{ return std::make_shared<Noop>(); });
+    MeasureCreate(out, "pooled", []{ return Task::Create<Noop>(); });
+    MeasureCreate(out, "callable", []{ return Task::Create([]{}); });
+
+    // The whole round trip through a scheduler, which also creates a runner
+    // for every dispatch. The in-memory task manager holds on to finished
+    // tasks until shutdown, so each round runs on a scheduler of its own.
+    // The first round fills the pool.
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    for (size_t round = 0; round < ROUNDS; ++round)
+    {
+        uint64_t before = s_allocations.load(std::memory_order_relaxed);
+        TaskPoolStats pool = TaskPool::GetStats();
+        Stopwatch watch;
+        {
+            SchedulerPtr scheduler;
+            if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+            scheduler->Start();
+
+            std::vector<TaskPtr> tasks;
+            tasks.reserve(RUN_TASKS);
+            for (size_t i = 0; i < RUN_TASKS; ++i)
+                tasks.emplace_back(Task::Create([]{}));
+            scheduler->Enqueue(tasks);
+            for (TaskPtr& task : tasks) task->Wait();
+            scheduler->Shutdown(true);
+        }
+        double elapsed = watch.Microseconds();
+        uint64_t allocations = s_allocations.load(std::memory_order_relaxed) - before;
+        uint64_t fresh = TaskPool::GetStats().fresh - pool.fresh;
+
+        out << "  round=" << round << "  tasks=" << RUN_TASKS
+            << "  allocs/task="
+            << static_cast<double>(allocations) / RUN_TASKS
+            << "  pool misses/task="
+            << static_cast<double>(fresh) / RUN_TASKS
+            << "  create+run+destroy=" << elapsed / RUN_TASKS << "us/task\n";
+    }
+}
@@ -0,0 +1,52 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+SCHEDULER_BENCHMARK(ChainStepLatency)
+{
+    static const size_t STEPS = 2000;
+
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+    scheduler->Start();
+
+    // Every step of the chain waits on the one before it, with a gate at
+    // the front holding the chain back until all of it has been taken in.
+    std::atomic<bool> release{false};
+    std::vector<TaskPtr> steps;
+    steps.reserve(STEPS + 1);
+    steps.emplace_back(Task::Create([&release]{
+        while (!release) std::this_thread::yield();
+    }));
+    for (size_t i = 0; i < STEPS; ++i)
+    {
+        TaskPtr task = Task::Create([]{});
+        task->Depends(steps.back());
+        steps.emplace_back(std::move(task));
+    }
+    scheduler->Enqueue(steps);
+    while (steps.back()->GetState() == TaskState::NEW)
+        std::this_thread::yield();
+
+    Stopwatch watch;
+    release = true;
+    steps.back()->Wait();
+    double elapsed = watch.Microseconds();
+
+    out << "  steps=" << STEPS << "  per-step=" << std::fixed
+        << std::setprecision(2) << (elapsed / STEPS) << "us\n";
+
+    scheduler->Shutdown(true);
+}
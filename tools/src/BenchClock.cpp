@@ -0,0 +1,101 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Task.h>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    const size_t READS = 2000000;
+    const size_t TASKS = 10000;
+    const size_t PASSES = 200;
+
+    // Keeps the optimizer from dropping the loops being measured.
+    volatile size_t s_sink = 0;
+
+    template<typename Fn>
+    double MeasureRead(Fn&& read)
+    {
+        Clock::rep total = 0;
+        Stopwatch watch;
+        for (size_t i = 0; i < READS; ++i)
+            total += read().time_since_epoch().count();
+        double elapsed = watch.Microseconds();
+        s_sink = static_cast<size_t>(total);
+        return elapsed * 1000.0 / READS;
+    }
+
+    // Check every task in a pass for expiry and prematurity, either reading
+    // the time for each check or once for the whole pass.
+    double MeasurePass(const std::vector<TaskPtr>& tasks, bool snapshot)
+    {
+        size_t due = 0;
+        Stopwatch watch;
+        for (size_t pass = 0; pass < PASSES; ++pass)
+        {
+            if (snapshot)
+            {
+                Clock::time_point now = Now();
+                for (const TaskPtr& task : tasks)
+                {
+                    if (!task->IsExpired(now) && !task->IsPremature(now)) ++due;
+                }
+            }
+            else
+            {
+                for (const TaskPtr& task : tasks)
+                {
+                    if (!task->IsExpired() && !task->IsPremature()) ++due;
+                }
+            }
+        }
+        double elapsed = watch.Microseconds();
+        s_sink = due;
+        return elapsed * 1000.0 / (PASSES * tasks.size());
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(ClockReads)
+{
+    out << std::fixed << std::setprecision(2);
+
+    double steady = MeasureRead([]{ return Clock::now(); });
+    double source = MeasureRead([]{ return Now(); });
+    {
+        CoarseClock coarse;
+        SetTimeSource(&coarse);
+        double cached = MeasureRead([]{ return Now(); });
+        SetTimeSource(nullptr);
+
+        out << "  reads=" << READS
+            << "  steady=" << steady << "ns"
+            << "  source=" << source << "ns"
+            << "  coarse=" << cached << "ns"
+            << "  precision="
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+                coarse.GetPrecision()).count() << "us\n";
+    }
+
+    Clock::time_point now = Clock::now();
+    std::vector<TaskPtr> tasks;
+    tasks.reserve(TASKS);
+    for (size_t i = 0; i < TASKS; ++i)
+    {
+        tasks.emplace_back(Task::Between(
+            []{},
+            now - std::chrono::seconds(1),
+            now + std::chrono::hours(1)));
+    }
+
+    double perCheck = MeasurePass(tasks, false);
+    double perPass = MeasurePass(tasks, true);
+    out << "  tasks=" << TASKS << "  passes=" << PASSES
+        << "  read per check=" << perCheck << "ns/task"
+        << "  read per pass=" << perPass << "ns/task\n";
+}
@@ -0,0 +1,152 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    void Spin(const Clock::duration& length)
+    {
+        Clock::time_point until = Clock::now() + length;
+        while (Clock::now() < until);
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(DeadlineDispatch)
+{
+    static const size_t TASKS = 1000;
+    static const Clock::duration WORK = std::chrono::milliseconds(1);
+    static const int MIN_SLACK_MS = 10;
+    static const int MAX_SLACK_MS = 1000;
+
+    struct Mode
+    {
+        const char* name;
+        DispatchPolicy policy;
+    };
+    static const Mode MODES[] = {
+        { "fifo", DispatchPolicy::PRIORITY },
+        { "edf", DispatchPolicy::DEADLINE }
+    };
+
+    unsigned concurrency = std::max(std::thread::hardware_concurrency(), 2u);
+    out << "  executor concurrency=" << concurrency << '\n';
+
+    for (const Mode& mode : MODES)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = concurrency;
+        params.dispatchPolicy = mode.policy;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+        scheduler->Start();
+
+        // Every task gets a deadline drawn from the same sequence in both
+        // modes. The total work is well beyond what the workers can get
+        // through before the later deadlines, so some tasks must miss.
+        std::mt19937 random(42);
+        std::uniform_int_distribution<int> slack(MIN_SLACK_MS, MAX_SLACK_MS);
+
+        std::atomic<size_t> met{0}, late{0};
+        std::vector<TaskPtr> tasks;
+        tasks.reserve(TASKS);
+
+        Stopwatch watch;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < TASKS; ++i)
+        {
+            Clock::time_point deadline =
+                start + std::chrono::milliseconds(slack(random));
+            TaskPtr task = Task::Before([deadline, &met, &late]{
+                Spin(WORK);
+                if (Clock::now() <= deadline) ++met;
+                else ++late;
+            }, deadline);
+            task->SetEstimate(WORK);
+            scheduler->Enqueue(task);
+            tasks.emplace_back(std::move(task));
+        }
+        for (TaskPtr& task : tasks) task->Wait();
+        double elapsed = watch.Microseconds();
+
+        // Tasks which finished after their deadline burned a worker for
+        // nothing.
+        size_t ran = met + late;
+        out << "  " << std::setw(4) << mode.name
+            << "  met=" << std::setw(5) << met
+            << "  late=" << std::setw(5) << late
+            << "  dropped=" << std::setw(5) << (TASKS - ran)
+            << "  wasted=" << std::setw(6) << std::fixed << std::setprecision(1)
+            << (late * std::chrono::duration<double, std::milli>(WORK).count())
+            << "ms  total=" << std::setprecision(0) << (elapsed / 1000)
+            << "ms\n";
+
+        scheduler->Shutdown(true);
+    }
+}
+
+SCHEDULER_BENCHMARK(DeadlineTracking)
+{
+    static const size_t WAITING = 20000;
+    static const size_t CHAIN_LENGTH = 2000;
+
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+    scheduler->Start();
+
+    // A large population of tracked tasks with far off deadlines, all
+    // pending on a gate which does not run before the scheduler is shut
+    // down. The gate itself waits on a premature task.
+    Clock::time_point deadline = Clock::now() + std::chrono::minutes(10);
+    TaskPtr hold = Task::After([]{}, deadline - std::chrono::minutes(1)),
+            gate = Task::Create([]{});
+    gate->Depends(hold);
+    scheduler->Enqueue(hold);
+    scheduler->Enqueue(gate);
+
+    std::vector<TaskPtr> waiting;
+    waiting.reserve(WAITING);
+    for (size_t i = 0; i < WAITING; ++i)
+    {
+        TaskPtr task = Task::Before([]{}, deadline);
+        task->Depends(gate);
+        scheduler->Enqueue(task);
+        waiting.emplace_back(std::move(task));
+    }
+
+    // Each link of the chain costs the scheduler at least one pass, so the
+    // per-link time reflects the per-pass cost of the waiting population.
+    std::vector<TaskPtr> chain;
+    chain.reserve(CHAIN_LENGTH);
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i)
+    {
+        TaskPtr task = Task::Create([]{});
+        if (!chain.empty()) task->Depends(chain.back());
+        chain.emplace_back(std::move(task));
+    }
+
+    Stopwatch watch;
+    for (TaskPtr& task : chain) scheduler->Enqueue(task);
+    chain.back()->Wait();
+    double elapsed = watch.Microseconds();
+
+    out << "  waiting=" << WAITING << "  chain=" << CHAIN_LENGTH
+        << "  per-link=" << std::fixed << std::setprecision(2)
+        << (elapsed / CHAIN_LENGTH) << "us\n";
+
+    scheduler->Shutdown(true);
+}
@@ -0,0 +1,157 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    // A task which parks itself in the scheduler by retrying far in the
+    // future. Anything depending on it stays pending for the whole run.
+    class Gate : public ImmutableTask<Gate>
+    {
+    public:
+        ~Gate() { }
+
+        bool HasRun() const { return m_ran; }
+
+    protected:
+        using ImmutableTask<Gate>::ImmutableTask;
+
+    private:
+        Clock::duration GetRetryInterval() const override
+        {
+            return std::chrono::hours(1);
+        }
+
+        TaskResult Run(ResultPtr&) override
+        {
+            m_ran = true;
+            return TaskResult::RETRY;
+        }
+
+        std::atomic<bool> m_ran{false};
+    };
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(DependencyResolution)
+{
+    static const size_t CHAIN_LENGTH = 1000;
+    static const size_t PENDING[] = { 0, 1000, 10000, 100000, 200000 };
+
+    for (size_t pending : PENDING)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = 2;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+        scheduler->Start();
+
+        std::shared_ptr<Gate> gate = Task::Create<Gate>();
+        scheduler->Enqueue(gate);
+        while (!gate->HasRun() || gate->GetState() != TaskState::PENDING)
+            std::this_thread::yield();
+
+        // Park the requested number of tasks behind the gate. The sentinel
+        // is queued last so waiting on it guarantees all of them have been
+        // taken in by the scheduler before the measurement starts.
+        std::vector<TaskPtr> parked;
+        parked.reserve(pending);
+        for (size_t i = 0; i < pending; ++i)
+        {
+            TaskPtr task = Task::Create([]{});
+            task->Depends(gate.get());
+            scheduler->Enqueue(task);
+            parked.emplace_back(std::move(task));
+        }
+
+        TaskPtr sentinel = Task::Create([]{});
+        scheduler->Enqueue(sentinel);
+        sentinel->Wait();
+
+        std::vector<TaskPtr> chain;
+        chain.reserve(CHAIN_LENGTH);
+        for (size_t i = 0; i < CHAIN_LENGTH; ++i)
+        {
+            TaskPtr task = Task::Create([]{});
+            if (!chain.empty()) task->Depends(chain.back());
+            chain.emplace_back(std::move(task));
+        }
+
+        Stopwatch watch;
+        for (TaskPtr& task : chain) scheduler->Enqueue(task);
+        chain.back()->Wait();
+        double elapsed = watch.Microseconds();
+
+        out << "  pending=" << std::setw(7) << pending
+            << "  per-completion=" << std::fixed << std::setprecision(2)
+            << (elapsed / CHAIN_LENGTH) << "us\n";
+
+        scheduler->Shutdown(true);
+    }
+}
+
+namespace {
+
+    // Wire layers of tasks from the bottom up, each task depending on every
+    // task of the layer below, then search from the top for the bottom. Each
+    // Depends checks for a duplicate and for a cycle before adding the edge.
+    // Closing a cycle is left out: the tasks would then own each other and
+    // never be freed.
+    void MeasureWiring(std::ostream& out, const char* name, size_t width, size_t layers)
+    {
+        std::vector<TaskPtr> tasks;
+        tasks.reserve(width * layers);
+        size_t edges = 0;
+
+        Stopwatch watch;
+        for (size_t layer = 0; layer < layers; ++layer)
+        {
+            for (size_t i = 0; i < width; ++i)
+            {
+                TaskPtr task = Task::Create([]{});
+                if (layer > 0)
+                {
+                    for (size_t j = (layer - 1) * width; j < layer * width; ++j)
+                        task->Depends(tasks[j]);
+                    edges += width;
+                }
+                tasks.emplace_back(std::move(task));
+            }
+        }
+        double wiring = watch.Microseconds();
+
+        Stopwatch search;
+        bool found = tasks.back()->Requires(tasks.front());
+        double searching = search.Microseconds();
+
+        out << "  " << std::setw(8) << std::left << name << std::right
+            << "  width=" << std::setw(4) << width
+            << "  layers=" << std::setw(6) << layers
+            << "  edges=" << std::setw(6) << edges
+            << std::fixed << std::setprecision(2)
+            << "  wiring=" << wiring / 1000.0 << "ms"
+            << " (" << wiring * 1000.0 / edges << "ns/edge)"
+            << "  search=" << searching << "us"
+            << (found ? "" : "  NOT FOUND") << "\n";
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(DependencyWiring)
+{
+    // A 30 layer diamond has a billion paths from top to bottom, which a
+    // search without visited marks would walk one by one.
+    MeasureWiring(out, "diamond", 2, 30);
+    MeasureWiring(out, "wide", 100, 11);
+    MeasureWiring(out, "deep", 10, 1001);
+}
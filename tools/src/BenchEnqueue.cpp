@@ -0,0 +1,64 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+SCHEDULER_BENCHMARK(BulkEnqueue)
+{
+    static const size_t SIZES[] = { 1000, 10000, 100000, 1000000 };
+
+    struct Mode
+    {
+        const char* name;
+        bool bulk;
+    };
+    static const Mode MODES[] = {
+        { "per-task", false },
+        { "bulk", true }
+    };
+
+    for (size_t size : SIZES)
+    {
+        for (const Mode& mode : MODES)
+        {
+            SchedulerParams params;
+            params.executorParams.concurrency = 2;
+            SchedulerPtr scheduler;
+            if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+            scheduler->Start();
+
+            std::vector<TaskPtr> tasks;
+            tasks.reserve(size);
+            for (size_t i = 0; i < size; ++i)
+                tasks.emplace_back(Task::Create([]{}));
+
+            // Only the handoff to the scheduler is timed, not the tasks
+            // getting through it.
+            Stopwatch watch;
+            if (mode.bulk) scheduler->Enqueue(tasks);
+            else for (TaskPtr& task : tasks) scheduler->Enqueue(task);
+            double enqueue = watch.Microseconds();
+
+            for (TaskPtr& task : tasks) task->Wait();
+            double elapsed = watch.Microseconds();
+
+            out << "  tasks=" << std::setw(7) << size
+                << "  " << std::setw(8) << mode.name << std::fixed
+                << std::setprecision(0)
+                << "  enqueue=" << std::setw(8) << enqueue << "us"
+                << "  per-task=" << std::setprecision(3) << std::setw(7)
+                << (enqueue / size) << "us"
+                << "  total=" << std::setprecision(0) << std::setw(8)
+                << (elapsed / 1000) << "ms\n";
+
+            scheduler->Shutdown(true);
+        }
+    }
+}
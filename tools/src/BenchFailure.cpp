@@ -0,0 +1,62 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+SCHEDULER_BENCHMARK(FailurePropagation)
+{
+    static const size_t DEPTHS[] = { 100, 1000, 10000 };
+
+    for (size_t depth : DEPTHS)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = 2;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+        scheduler->Start();
+
+        // The root fails once released, taking the whole chain behind it
+        // down with it.
+        std::atomic<bool> release{false};
+        TaskPtr root = Task::Create([&release]{
+            while (!release) std::this_thread::yield();
+            return TaskResult::FAILURE;
+        });
+
+        std::vector<TaskPtr> chain(1, root);
+        chain.reserve(depth + 1);
+        for (size_t i = 0; i < depth; ++i)
+        {
+            TaskPtr task = Task::Create([]{});
+            task->Depends(chain.back());
+            chain.emplace_back(std::move(task));
+        }
+        scheduler->Enqueue(chain);
+
+        // Wait for the scheduler to take the whole chain in so only the
+        // propagation is timed. The tail may already be pending by the time
+        // this looks, so its state is polled rather than waited on.
+        while (chain.back()->GetState() == TaskState::NEW)
+            std::this_thread::yield();
+
+        Stopwatch watch;
+        release = true;
+        chain.back()->Wait();
+        double elapsed = watch.Microseconds();
+
+        out << "  depth=" << std::setw(6) << depth << std::fixed
+            << std::setprecision(0) << "  unwind=" << std::setw(8) << elapsed
+            << "us\n";
+
+        scheduler->Shutdown(true);
+    }
+}
@@ -0,0 +1,72 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    // Run parallel chains held back by a single gate, returning the time
+    // per task once the gate is released.
+    double RunChains(SchedulingMode mode, size_t width, size_t depth)
+    {
+        SchedulerParams params;
+        params.mode = mode;
+        params.executorParams.concurrency = 2;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return 0.0;
+        scheduler->Start();
+
+        std::atomic<bool> release{false};
+        TaskPtr gate = Task::Create([&release]{
+            while (!release) std::this_thread::yield();
+        });
+
+        std::vector<TaskPtr> tasks;
+        tasks.reserve(width * depth + 1);
+        tasks.emplace_back(gate);
+        for (size_t layer = 0; layer < depth; ++layer)
+        {
+            for (size_t i = 0; i < width; ++i)
+            {
+                TaskPtr task = Task::Create([]{});
+                if (layer == 0) task->Depends(gate);
+                else task->Depends(tasks[1 + (layer - 1) * width + i]);
+                tasks.emplace_back(std::move(task));
+            }
+        }
+        scheduler->Enqueue(tasks);
+        while (tasks.back()->GetState() == TaskState::NEW)
+            std::this_thread::yield();
+
+        Stopwatch watch;
+        release = true;
+        for (TaskPtr& task : tasks) task->Wait();
+        double elapsed = watch.Microseconds();
+
+        scheduler->Shutdown(true);
+        return elapsed / (width * depth);
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(SchedulingModes)
+{
+    static const size_t WIDTH = 64;
+    static const size_t DEPTH = 32;
+
+    double centralized = RunChains(SchedulingMode::CENTRALIZED, WIDTH, DEPTH);
+    double decentralized = RunChains(SchedulingMode::DECENTRALIZED, WIDTH, DEPTH);
+
+    out << "  tasks=" << WIDTH * DEPTH << std::fixed << std::setprecision(2)
+        << "  centralized=" << centralized << "us/task"
+        << "  decentralized=" << decentralized << "us/task\n";
+}
@@ -0,0 +1,109 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    void Spin(const Clock::duration& length)
+    {
+        Clock::time_point until = Clock::now() + length;
+        while (Clock::now() < until);
+    }
+
+    double Percentile(std::vector<double>& samples, double percentile)
+    {
+        if (samples.empty()) return 0.0;
+        std::sort(samples.begin(), samples.end());
+        size_t index = static_cast<size_t>(percentile * (samples.size() - 1));
+        return samples[index];
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(PriorityDispatchLatency)
+{
+    static const size_t BACKGROUND = 20000;
+    static const size_t PROBES = 200;
+    static const Clock::duration BACKGROUND_WORK = std::chrono::microseconds(100);
+    static const Clock::duration PROBE_INTERVAL = std::chrono::milliseconds(2);
+
+    struct Mode
+    {
+        const char* name;
+        TaskPriority probe;
+    };
+    static const Mode MODES[] = {
+        { "same-class", TaskPriority::LOW },
+        { "high-priority", TaskPriority::HIGH }
+    };
+
+    unsigned concurrency = std::max(std::thread::hardware_concurrency(), 2u);
+
+    for (const Mode& mode : MODES)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = concurrency;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+        scheduler->Start();
+
+        // Saturate every worker with a backlog of bulk work.
+        std::vector<TaskPtr> background;
+        background.reserve(BACKGROUND);
+        for (size_t i = 0; i < BACKGROUND; ++i)
+        {
+            TaskPtr task = Task::Create([]{ Spin(BACKGROUND_WORK); });
+            task->SetPriority(TaskPriority::LOW);
+            scheduler->Enqueue(task);
+            background.emplace_back(std::move(task));
+        }
+
+        // Give the scheduler time to hand the backlog to the executor so the
+        // probes contend with it in the worker queues rather than sitting
+        // behind it in the intake.
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        // Probes record how long they sat between being enqueued and
+        // starting to run.
+        std::vector<Clock::time_point> queued(PROBES), started(PROBES);
+        std::vector<TaskPtr> probes;
+        probes.reserve(PROBES);
+        for (size_t i = 0; i < PROBES; ++i)
+        {
+            Clock::time_point* start = &started[i];
+            TaskPtr task = Task::Create([start]{ *start = Clock::now(); });
+            task->SetPriority(mode.probe);
+
+            queued[i] = Clock::now();
+            scheduler->Enqueue(task);
+            probes.emplace_back(std::move(task));
+            std::this_thread::sleep_for(PROBE_INTERVAL);
+        }
+        for (TaskPtr& task : probes) task->Wait();
+
+        std::vector<double> latency;
+        latency.reserve(PROBES);
+        for (size_t i = 0; i < PROBES; ++i)
+        {
+            latency.emplace_back(std::chrono::duration<double, std::micro>(
+                started[i] - queued[i]).count());
+        }
+
+        out << "  " << std::setw(13) << mode.name << std::fixed
+            << std::setprecision(0)
+            << "  p50=" << std::setw(9) << Percentile(latency, 0.50) << "us"
+            << "  p99=" << std::setw(9) << Percentile(latency, 0.99) << "us\n";
+
+        scheduler->Shutdown(true);
+    }
+}
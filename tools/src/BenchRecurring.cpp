@@ -0,0 +1,91 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <atomic>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    const unsigned TICKS = 2000;
+
+    // Ticks of a heartbeat, signalling once the last one has run.
+    struct Heartbeat
+    {
+        std::atomic<unsigned> ticks{0};
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool done = false;
+
+        bool Beat()
+        {
+            if (++ticks < TICKS) return true;
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cond.notify_all();
+            return false;
+        }
+
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]() { return done; });
+        }
+    };
+
+    // Emulate a periodic job the old way, queueing a fresh task for every
+    // tick from the body of the last one.
+    void Recreate(SchedulerPtr& scheduler, Heartbeat& heartbeat)
+    {
+        TaskPtr task = Task::Create([&scheduler, &heartbeat]() {
+            if (heartbeat.Beat()) Recreate(scheduler, heartbeat);
+        });
+        scheduler->Enqueue(task);
+    }
+
+    double MeasureTick(bool recurring)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = 2;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return 0.0;
+        scheduler->Start();
+
+        Heartbeat heartbeat;
+        Stopwatch watch;
+        if (recurring)
+        {
+            // The last tick fails the task to end the recurrence.
+            TaskPtr task = Task::Create([&heartbeat]() { return heartbeat.Beat(); });
+            task->SetRecurrence(Recurrence::FixedDelay(Clock::duration::zero()));
+            scheduler->Enqueue(task);
+        }
+        else
+        {
+            Recreate(scheduler, heartbeat);
+        }
+        heartbeat.Wait();
+        double elapsed = watch.Microseconds();
+
+        scheduler->Shutdown(true);
+        return elapsed / TICKS;
+    }
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(RecurringTicks)
+{
+    double recreated = MeasureTick(false);
+    double recurring = MeasureTick(true);
+
+    out << "  ticks=" << TICKS << std::fixed << std::setprecision(2)
+        << "  recreated=" << recreated << "us/tick"
+        << "  recurring=" << recurring << "us/tick\n";
+}
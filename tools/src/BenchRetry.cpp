@@ -0,0 +1,89 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+namespace {
+
+    // Fails its first run as though a shared dependency were down, then
+    // records how long it waited to be run again.
+    class Outage : public ImmutableTask<Outage>
+    {
+    public:
+        ~Outage() { }
+
+        Clock::duration waited = Clock::duration::zero();
+
+    protected:
+        using ImmutableTask<Outage>::ImmutableTask;
+
+    private:
+        Clock::duration GetRetryInterval() const override
+        {
+            return std::chrono::milliseconds(10);
+        }
+
+        TaskResult Run(ResultPtr&) override
+        {
+            if (m_failed != Clock::time_point())
+            {
+                waited = Clock::now() - m_failed;
+                return TaskResult::SUCCESS;
+            }
+            m_failed = Clock::now();
+            return TaskResult::RETRY;
+        }
+
+        Clock::time_point m_failed;
+    };
+
+}  // namespace
+
+SCHEDULER_BENCHMARK(RetrySpread)
+{
+    static const size_t COUNT = 200;
+
+    SchedulerParams params;
+    params.executorParams.concurrency = 2;
+    SchedulerPtr scheduler;
+    if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+
+    // Every task fails together and asks to be retried.
+    std::vector<std::shared_ptr<Outage>> outages;
+    std::vector<TaskPtr> tasks;
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        outages.emplace_back(Task::Create<Outage>());
+        tasks.emplace_back(outages.back());
+    }
+    scheduler->Enqueue(tasks);
+    scheduler->Start();
+    for (TaskPtr& task : tasks) task->Wait();
+
+    // With a fixed interval every task waits the same time and the retries
+    // land as one burst. The spread of the waits is how far apart jitter
+    // pushes them.
+    std::vector<double> waits;
+    for (auto& outage : outages)
+    {
+        waits.emplace_back(
+            std::chrono::duration<double, std::milli>(outage->waited).count());
+    }
+    std::sort(waits.begin(), waits.end());
+
+    out << "  tasks=" << COUNT << std::fixed << std::setprecision(2)
+        << "  wait-p10=" << waits[COUNT / 10] << "ms"
+        << "  wait-p50=" << waits[COUNT / 2] << "ms"
+        << "  wait-p90=" << waits[COUNT * 9 / 10] << "ms\n";
+
+    scheduler->Shutdown(true);
+}
@@ -0,0 +1,70 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Scheduler.h>
+#include <Scheduler/Lib/Task.h>
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+SCHEDULER_BENCHMARK(ShardScaling)
+{
+    static const size_t CHAINS = 1000;
+    static const size_t CHAIN_LENGTH = 10;
+    static const size_t PRODUCERS = 4;
+    static const unsigned SHARDS[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    unsigned concurrency = std::max(std::thread::hardware_concurrency(), 2u);
+    out << "  executor concurrency=" << concurrency << '\n';
+
+    for (unsigned shards : SHARDS)
+    {
+        SchedulerParams params;
+        params.executorParams.concurrency = concurrency;
+        params.shards = shards;
+        SchedulerPtr scheduler;
+        if (TaskScheduler::Create(params, scheduler) != E_SUCCESS) return;
+        scheduler->Start();
+
+        // Short independent chains so there is always plenty to dispatch,
+        // with most links crossing between shards once there are several.
+        std::vector<std::vector<TaskPtr>> chains(CHAINS);
+        for (auto& chain : chains)
+        {
+            chain.reserve(CHAIN_LENGTH);
+            for (size_t i = 0; i < CHAIN_LENGTH; ++i)
+            {
+                TaskPtr task = Task::Create([]{});
+                if (!chain.empty()) task->Depends(chain.back());
+                chain.emplace_back(std::move(task));
+            }
+        }
+
+        Stopwatch watch;
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < PRODUCERS; ++p)
+        {
+            producers.emplace_back([&, p](){
+                for (size_t c = p; c < CHAINS; c += PRODUCERS)
+                    for (TaskPtr& task : chains[c]) scheduler->Enqueue(task);
+            });
+        }
+        for (std::thread& producer : producers) producer.join();
+        for (auto& chain : chains) chain.back()->Wait();
+        double elapsed = watch.Microseconds();
+
+        size_t total = CHAINS * CHAIN_LENGTH;
+        out << "  shards=" << std::setw(2) << shards
+            << "  tasks/s=" << std::setw(9) << std::fixed << std::setprecision(0)
+            << (total / (elapsed / 1e6))
+            << "  per-task=" << std::setprecision(2) << (elapsed / total)
+            << "us\n";
+
+        scheduler->Shutdown(true);
+    }
+}
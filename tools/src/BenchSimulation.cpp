@@ -0,0 +1,48 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <Scheduler/Lib/Simulation.h>
+#include <Scheduler/Lib/Task.h>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace Scheduler;
+using namespace Scheduler::Lib;
+using namespace Scheduler::Tools;
+
+SCHEDULER_BENCHMARK(SimulatedDay)
+{
+    static const size_t COUNT = 100000;
+    static const Clock::duration DAY = std::chrono::hours(24);
+
+    SimulationPtr simulation;
+    if (Simulation::Create(SchedulerParams(), simulation) != E_SUCCESS) return;
+    Clock::time_point start = simulation->Now();
+
+    // Delayed tasks spread evenly across a day, every one of which would
+    // otherwise need its start time waited out.
+    size_t ran = 0;
+    std::vector<TaskPtr> tasks;
+    tasks.reserve(COUNT);
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        Clock::time_point after = start + DAY * static_cast<Clock::rep>(i + 1)
+            / static_cast<Clock::rep>(COUNT);
+        tasks.emplace_back(Task::After([&ran]() { ++ran; }, after));
+    }
+
+    Stopwatch watch;
+    simulation->GetScheduler()->Enqueue(tasks);
+    simulation->RunFor(DAY);
+    double elapsed = watch.Microseconds();
+
+    double scheduler = std::chrono::duration<double, std::micro>(
+        simulation->GetSchedulerTime()).count();
+    double execution = std::chrono::duration<double, std::micro>(
+        simulation->GetExecutionTime()).count();
+
+    out << "  tasks=" << ran << "/" << COUNT << std::fixed << std::setprecision(2)
+        << "  simulated=24h  real=" << elapsed / 1000.0 << "ms"
+        << "  scheduler=" << scheduler / COUNT << "us/task"
+        << "  execution=" << execution / COUNT << "us/task\n";
+}
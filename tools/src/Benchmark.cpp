@@ -0,0 +1,24 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+namespace {
+
+    std::vector<const Scheduler::Tools::Benchmark*>& Registry()
+    {
+        static std::vector<const Scheduler::Tools::Benchmark*> s_benchmarks;
+        return s_benchmarks;
+    }
+
+}  // namespace
+
+Scheduler::Tools::Benchmark::Benchmark(const char* name, BenchmarkFn fn)
+    : m_name(name),
+      m_fn(fn)
+{
+    Registry().emplace_back(this);
+}
+
+const std::vector<const Scheduler::Tools::Benchmark*>&
+Scheduler::Tools::Benchmark::All()
+{
+    return Registry();
+}
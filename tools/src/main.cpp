@@ -0,0 +1,27 @@
+#include <Scheduler/Tools/Benchmark.h>
+
+#include <iostream>
+#include <string.h>
+
+using Scheduler::Tools::Benchmark;
+
+int main(int argc, char** argv)
+{
+    const char* filter = (argc > 1) ? argv[1] : nullptr;
+
+    // The library logs every task transition through the Console. Keep the
+    // results readable by writing them to a separate stream and silencing
+    // std::cout for the duration of the run.
+    std::ostream out(std::cout.rdbuf());
+    std::cout.setstate(std::ios_base::badbit);
+
+    for (const Benchmark* benchmark : Benchmark::All())
+    {
+        if (filter && !strstr(benchmark->Name(), filter)) continue;
+
+        out << "[ RUN      ] " << benchmark->Name() << std::endl;
+        benchmark->Run(out);
+        out << "[     DONE ] " << benchmark->Name() << std::endl;
+    }
+    return 0;
+}